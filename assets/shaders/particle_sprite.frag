@@ -0,0 +1,13 @@
+#version 450
+
+layout(location = 0) in vec2 fragQuadCoord;
+layout(location = 1) flat in vec4 fragColor;
+
+layout(location = 0) out vec4 outColor;
+
+void main() {
+	if (dot(fragQuadCoord, fragQuadCoord) >= 1.0) { // outside the particle circle
+		discard;
+	}
+	outColor = fragColor;
+}
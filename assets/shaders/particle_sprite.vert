@@ -0,0 +1,126 @@
+#version 450
+
+// one instance per particle, 6 vertices per instance forming a quad around the particle
+
+layout(location = 0) out vec2 fragQuadCoord; // [-1, 1] across the quad
+layout(location = 1) flat out vec4 fragColor;
+
+layout(push_constant) uniform Push {
+	vec2 screenExtent;
+	float quadRadius; // in pixels
+	float quadDepth; // depth of the first instance, later instances are drawn behind it
+} push;
+
+// fields before particleData mirror ParticleBufferHeader in src/app/fluid_sim/2d/particle_buffer_header.hpp
+layout(binding = 3) buffer Particles {
+	uint numParticles;
+	float smoothRadius;
+	float targetDensity;
+	float dataScale;
+	uint isNeighborViewActive;
+	uint isDensityViewActive;
+	uint isPackedFormat; // positions as unorm16 relative to positionRange, velocities as fp16
+	float positionRangeX;
+	float positionRangeY;
+	uint particleData[]; // positions then velocities, one word per particle each when packed, two otherwise
+};
+
+vec2 getParticlePosition(int i) { // in pixels
+	if (isPackedFormat == 1)
+		return unpackUnorm2x16(particleData[i]) * vec2(positionRangeX, positionRangeY) / dataScale;
+	return uintBitsToFloat(uvec2(particleData[2 * i], particleData[2 * i + 1])) / dataScale;
+}
+
+vec2 getParticleVelocity(int i) { // in pixels per second
+	if (isPackedFormat == 1)
+		return unpackHalf2x16(particleData[numParticles + i]) / dataScale;
+	uint offset = 2 * (numParticles + i);
+	return uintBitsToFloat(uvec2(particleData[offset], particleData[offset + 1])) / dataScale;
+}
+
+layout(binding = 4) buffer Neighbors {
+	int neighborIndex[];
+};
+
+const vec2 quadCorners[6] = vec2[](
+	vec2( 1.0,  1.0),
+	vec2( 1.0, -1.0),
+	vec2(-1.0, -1.0),
+	vec2(-1.0, -1.0),
+	vec2(-1.0,  1.0),
+	vec2( 1.0,  1.0)
+);
+
+const vec4 upColor = vec4(0.996, 0.267, 0.412, 1.0);
+const vec4 downColor = vec4(0.435, 0.525, 0.984, 1.0);
+const vec4 leftColor = vec4(0.984, 0.851, 0.353, 1.0);
+const vec4 rightColor = vec4(0.400, 0.851, 0.549, 1.0);
+
+const float maxDisplayVelocityMag = 200.0;
+const float maxDisplayVelocityMagSqr = maxDisplayVelocityMag * maxDisplayVelocityMag;
+
+const vec4 white = vec4(1.0, 1.0, 1.0, 1.0);
+
+vec4 fillParticleByVelocity(int particleIndex) { // same coloring as screen_texture_shader.frag
+	vec2 particleVelocity = getParticleVelocity(particleIndex);
+	float velocityMagSqr = dot(particleVelocity, particleVelocity);
+	vec2 velocityDir = normalize(particleVelocity);
+	vec2 normalizedVelocity = particleVelocity;
+	if (velocityMagSqr > maxDisplayVelocityMagSqr) {
+		normalizedVelocity = velocityDir * maxDisplayVelocityMag;
+	}
+
+	vec3 xColor, yColor;
+	vec3 defaultColor = white.rgb * 0.01;
+
+	float xIntensity = clamp(abs(normalizedVelocity.x) / maxDisplayVelocityMag, 0.0, 1.0);
+	if (velocityDir.x > 0.0) {
+		xColor = mix(defaultColor, leftColor.rgb, xIntensity);
+	}
+	else {
+		xColor = mix(defaultColor, rightColor.rgb, xIntensity);
+	}
+
+	float yIntensity = clamp(abs(normalizedVelocity.y) / maxDisplayVelocityMag, 0.0, 1.0);
+	if (velocityDir.y > 0.0) {
+		yColor = mix(defaultColor, downColor.rgb, yIntensity);
+	}
+	else {
+		yColor = mix(defaultColor, upColor.rgb, yIntensity);
+	}
+
+	float intensitySum = xIntensity + yIntensity;
+	return vec4(clamp(xColor * xIntensity / intensitySum + yColor * yIntensity / intensitySum, 0.0, 1.0), 1.0);
+}
+
+vec4 applyNeighborView(int particleIndex) {
+	if (particleIndex == 0) { // Draw the first particle in red
+		return vec4(1.0, 0.0, 0.0, 1.0);
+	}
+	for (int j = 0; j < numParticles; j++) {
+		if (neighborIndex[j] == -1) {
+			break;
+		}
+		if (neighborIndex[j] == particleIndex) {
+			return vec4(1.0, 1.0, 1.0, 1.0);
+		}
+	}
+	return fillParticleByVelocity(particleIndex);
+}
+
+void main() {
+	int i = gl_InstanceIndex;
+	vec2 corner = quadCorners[gl_VertexIndex];
+	vec2 pixelPos = getParticlePosition(i) + corner * push.quadRadius;
+
+	// lower indices in front, matching the first-hit order of the screen texture shader
+	float depth = push.quadDepth + (1.0 - push.quadDepth) * float(i) / float(numParticles);
+	gl_Position = vec4(2.0 * pixelPos / push.screenExtent - vec2(1.0), depth, 1.0);
+	fragQuadCoord = corner;
+
+	// color is constant over the sprite, so it is evaluated per vertex instead of per pixel
+	if (isNeighborViewActive == 1)
+		fragColor = applyNeighborView(i);
+	else
+		fragColor = fillParticleByVelocity(i);
+}
@@ -12,6 +12,7 @@ layout(push_constant) uniform Push {
 	vec2 screenExtent;
 } push;
 
+// fields before particleData mirror ParticleBufferHeader in src/app/fluid_sim/2d/particle_buffer_header.hpp
 layout(binding = 3) buffer Particles {
 	uint numParticles;
 	float smoothRadius;
@@ -19,13 +20,46 @@ layout(binding = 3) buffer Particles {
 	float dataScale;
 	uint isNeighborViewActive;
 	uint isDensityViewActive;
-	vec2 data[];
+	uint isPackedFormat; // positions as unorm16 relative to positionRange, velocities as fp16
+	float positionRangeX;
+	float positionRangeY;
+	uint particleData[]; // positions then velocities, one word per particle each when packed, two otherwise
 };
 
+vec2 getParticlePosition(int i) { // in pixels
+	if (isPackedFormat == 1)
+		return unpackUnorm2x16(particleData[i]) * vec2(positionRangeX, positionRangeY) / dataScale;
+	return uintBitsToFloat(uvec2(particleData[2 * i], particleData[2 * i + 1])) / dataScale;
+}
+
+vec2 getParticleVelocity(int i) { // in pixels per second
+	if (isPackedFormat == 1)
+		return unpackHalf2x16(particleData[numParticles + i]) / dataScale;
+	uint offset = 2 * (numParticles + i);
+	return uintBitsToFloat(uvec2(particleData[offset], particleData[offset + 1])) / dataScale;
+}
+
 layout(binding = 4) buffer Neighbors {
 	int neighborIndex[];
 };
 
+// per-tile particle lists built on the CPU (see TileBinner)
+layout(binding = 5) buffer Tiles {
+	uint tileSize;
+	uint tileCountX;
+	uint tileCountY;
+	float particleRadius; // in pixels
+	uint tileData[]; // tile offsets (tileCountX * tileCountY + 1), then particle indices
+};
+
+// density splatted on the CPU (see DensitySplatter), node (x, y) is at pixel (x, y) * cellSize
+layout(binding = 6) buffer DensityGrid {
+	uint gridWidth;
+	uint gridHeight;
+	float cellSize;
+	float densityGrid[];
+};
+
 // struct ParticleData
 // {
 // 	unsigned int numParticles;
@@ -33,8 +67,6 @@ layout(binding = 4) buffer Neighbors {
 // 	std::vector<glm::vec2> velocities;
 // };
 
-const float particleRadiusSqr = 4.0 * 4.0;
-
 const vec4 colorLow = vec4(0.078, 0.282, 0.627, 1.0);
 const vec4 colorMed = vec4(0.322, 0.984, 0.576, 1.0);
 const vec4 colorMedHigh = vec4(0.980, 0.925, 0.027, 1.0);
@@ -53,30 +85,21 @@ const float medVelocityMagSqr = maxDisplayVelocityMagSqr / 2.0;
 const vec4 black = vec4(0.0, 0.0, 0.0, 1.0);
 const vec4 white = vec4(1.0, 1.0, 1.0, 1.0);
 
-float kernelSpikyPow2_2D(float dist, float radius)
-{
-	if (dist >= radius)
-		return 0.0;
-	float v = radius - dist;
-	return 6.f / (M_PI * pow(smoothRadius, 4.f)) * v * v;
-}
-
-float calculateDensity(vec2 samplePointPos) {
-	float density = 0.0;
-	samplePointPos *= dataScale;
-
-	for (int i = 0; i < numParticles; i++) {
-		vec2 particlePos = data[i];
-		float dist = distance(samplePointPos, particlePos);
-		float influence = kernelSpikyPow2_2D(dist, smoothRadius);
-		density += influence;
-	}
-
-	return density;
+float sampleDensity(vec2 pixelPos) { // bilinear, matches DensitySplatter::sample
+	vec2 gridPos = clamp(pixelPos / cellSize, vec2(0.0), vec2(gridWidth - 1, gridHeight - 1));
+	uint x0 = min(uint(gridPos.x), gridWidth - 2);
+	uint y0 = min(uint(gridPos.y), gridHeight - 2);
+	vec2 fraction = gridPos - vec2(x0, y0);
+
+	float d00 = densityGrid[y0 * gridWidth + x0];
+	float d10 = densityGrid[y0 * gridWidth + x0 + 1];
+	float d01 = densityGrid[(y0 + 1) * gridWidth + x0];
+	float d11 = densityGrid[(y0 + 1) * gridWidth + x0 + 1];
+	return mix(mix(d00, d10, fraction.x), mix(d01, d11, fraction.x), fraction.y);
 }
 
 vec4 fillParticleByVelocity(int particleIndex) {
-	vec2 particleVelocity = data[particleIndex + numParticles] / dataScale;
+	vec2 particleVelocity = getParticleVelocity(particleIndex);
 	float velocityMagSqr = dot(particleVelocity, particleVelocity);
 	vec2 velocityDir = normalize(particleVelocity);
 	vec2 normalizedVelocity = particleVelocity;
@@ -125,7 +148,7 @@ vec4 applyNeighborView(int particleIndex) {
 }
 
 vec4 applyDensityView() {
-	float density = calculateDensity(fragTexCoord);
+	float density = sampleDensity(fragTexCoord);
 	float maxDisplayDensity = targetDensity * 1.25;
 	float minDisplayDensity = targetDensity * 0.75;
 	float medHighDensity = targetDensity * 1.125;
@@ -148,8 +171,14 @@ void main() {
 		outColor = applyDensityView();
 	}
 	else {
-		for (int i = 0; i < numParticles; i++) { // Draw all particles
-			vec2 particlePosition = data[i] / dataScale;
+		// only the particles overlapping this pixel's tile, in ascending index order
+		uvec2 tile = min(uvec2(fragTexCoord) / tileSize, uvec2(tileCountX - 1, tileCountY - 1));
+		uint tileIndex = tile.y * tileCountX + tile.x;
+		uint particleListStart = tileCountX * tileCountY + 1;
+		float particleRadiusSqr = particleRadius * particleRadius;
+		for (uint k = tileData[tileIndex]; k < tileData[tileIndex + 1]; k++) {
+			int i = int(tileData[particleListStart + k]);
+			vec2 particlePosition = getParticlePosition(i);
 			vec2 diff = fragTexCoord - particlePosition;
 			float distanceSqr = dot(diff, diff);
 
@@ -160,7 +189,7 @@ void main() {
 					outColor = fillParticleByVelocity(i);
 				return;
 			}
-	}
+		}
 
 		outColor = black;
 	}
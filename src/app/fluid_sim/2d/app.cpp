@@ -1,9 +1,15 @@
 #include "app/fluid_sim/2d/app.hpp"
 
+#include "lve/core/gpu_profiler.hpp"
+#include "lve/core/pipeline/pipeline_builder.hpp"
+#include "lve/core/pipeline/pipeline_cache.hpp"
 #include "lve/core/resource/buffer.hpp"
 #include "lve/core/resource/sampler_manager.hpp"
+#include "lve/core/resource/staged_buffer.hpp"
 #include "lve/util/math.hpp"
 #include "lve/util/file_io.hpp"
+#include "lve/util/stats.hpp"
+#include "lve/util/trace.hpp"
 
 // libs
 #include "include/glm.hpp"
@@ -13,6 +19,7 @@
 #include <chrono>
 #include <stdexcept>
 #include <cmath>
+#include <cstring>
 #include <thread>
 #include <iostream>
 
@@ -30,53 +37,90 @@ FluidSim2DApp::FluidSim2DApp()
     lve::io::YamlConfig config("config/fluidSim2D.yaml");
     std::vector<int> windowSize = config.get<std::vector<int>>("windowSize");
     lveWindow.resize(windowSize[0], windowSize[1]);
+    particleRadius = config.get<float>("particleRadius");
+    tileBinner = TileBinner(config.get<uint32_t>("tileSize"), particleRadius);
+    densitySplatter = DensitySplatter(config.get<float>("densityGridCellSize"));
+    threadPool = std::make_unique<lve::ThreadPool>(config.get<size_t>("workerThreadCount"));
+
+    std::string bufferMode = config.get<std::string>("particleBufferMode");
+    if (bufferMode == "auto")
+        useDirectBuffers = lveDevice.hasUnifiedMemory();
+    else if (bufferMode == "staged" || bufferMode == "direct")
+        useDirectBuffers = bufferMode == "direct";
+    else
+        throw std::runtime_error("Unknown particleBufferMode: " + bufferMode + ", expected auto, staged or direct");
+    std::cout << "Particle buffers: " << (useDirectBuffers ? "host visible (direct)" : "device local (staged)") << std::endl;
+
+    usePackedParticleFormat = config.get<bool>("packedParticleFormat");
+
+    frameCaptureConfigInfo.outputDirectory = config.get<std::string>("captureDirectory");
+    frameCaptureConfigInfo.slotCount = config.get<uint32_t>("captureSlotCount");
+    frameCaptureConfigInfo.encoderThreadCount = config.get<size_t>("captureEncoderThreadCount");
+    std::string captureFormat = config.get<std::string>("captureFormat");
+    if (captureFormat == "png")
+        frameCaptureConfigInfo.encoding = lve::CaptureEncoding::PNG;
+    else if (captureFormat == "yuv")
+        frameCaptureConfigInfo.encoding = lve::CaptureEncoding::YUV420;
+    else
+        throw std::runtime_error("Unknown captureFormat: " + captureFormat + ", expected png or yuv");
+    std::string captureOverflow = config.get<std::string>("captureOverflow");
+    if (captureOverflow == "drop")
+        frameCaptureConfigInfo.overflowPolicy = lve::CaptureOverflowPolicy::DROP;
+    else if (captureOverflow == "queue")
+        frameCaptureConfigInfo.overflowPolicy = lve::CaptureOverflowPolicy::QUEUE;
+    else
+        throw std::runtime_error("Unknown captureOverflow: " + captureOverflow + ", expected drop or queue");
+
+    std::string renderMode = config.get<std::string>("particleRenderMode");
+    if (renderMode == "screen")
+        particleRenderMode = SCREEN_TEXTURE;
+    else if (renderMode == "sprite")
+        particleRenderMode = SPRITE;
+    else
+        throw std::runtime_error("Unknown particleRenderMode: " + renderMode + ", expected screen or sprite");
 
     // register callback functions for window resize
     lveRenderer.registerSwapChainResizedCallback(
         WINDOW_RESIZED_CALLBACK_NAME,
         [this](VkExtent2D extent)
         {
-            recreateScreenTextureImage(extent);
-            updateGlobalDescriptorSets();
+            recreateScreenTextureImages(extent);
+            recreateTileBuffers(extent);
+            recreateDensityBuffers(extent);
+            // the replaced resources are destroyed by the deletion queue once the frames using them have completed
+            outdatedDescriptorSets.assign(globalDescriptorSets.size(), true);
             fluidParticleSys.updateWindowExtent(extent);
         });
 
     globalPool =
         lve::DescriptorPool::Builder(lveDevice)
-            .setMaxSets(lve::SwapChain::MAX_FRAMES_IN_FLIGHT)
-            .addPoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, lve::SwapChain::MAX_FRAMES_IN_FLIGHT)
-            .addPoolSize(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, lve::SwapChain::MAX_FRAMES_IN_FLIGHT)
-            .addPoolSize(VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, lve::SwapChain::MAX_FRAMES_IN_FLIGHT)
-            .addPoolSize(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, lve::SwapChain::MAX_FRAMES_IN_FLIGHT * 2) // particle buffer, neighbor buffer
+            .setMaxSets(lveDevice.getFramesInFlight())
+            .addPoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, lveDevice.getFramesInFlight())
+            .addPoolSize(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, lveDevice.getFramesInFlight())
+            .addPoolSize(VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, lveDevice.getFramesInFlight())
+            .addPoolSize(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, lveDevice.getFramesInFlight() * 4) // particle, neighbor, tile and density buffers
             .build();
 
-    uboBuffers.resize(lve::SwapChain::MAX_FRAMES_IN_FLIGHT);
-    globalDescriptorSets.resize(lve::SwapChain::MAX_FRAMES_IN_FLIGHT);
+    globalDescriptorSets.resize(lveDevice.getFramesInFlight());
 
-    for (int i = 0; i < uboBuffers.size(); i++)
-    {
-        uboBuffers[i] = std::make_unique<lve::Buffer>(
-            lveDevice,
-            sizeof(GlobalUbo),
-            1,
-            VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
-            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT);
-        uboBuffers[i]->map();
-    }
-
-    initParticleBuffer();
-    writeParticleBuffer();
+    initParticleBuffers();
+    for (int i = 0; i < particleBuffers.size(); i++)
+        writeParticleBuffer(i);
+    recreateTileBuffers(lveWindow.getExtent());
+    recreateDensityBuffers(lveWindow.getExtent());
 
     globalSetLayout =
         lve::DescriptorSetLayout::Builder(lveDevice)
-            .addBinding(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_ALL_GRAPHICS)
+            .addBinding(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, VK_SHADER_STAGE_ALL_GRAPHICS)    // Global ubo, at globalDynamicOffsets[0] in the frame allocator
             .addBinding(1, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT) // Frag shader input texture
             .addBinding(2, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VK_SHADER_STAGE_COMPUTE_BIT)           // Compute shader output texture
-            .addBinding(3, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_FRAGMENT_BIT)         // Frag shader input particle buffer
-            .addBinding(4, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_FRAGMENT_BIT)         // Frag shader input neighbor buffer
+            .addBinding(3, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT) // Particle buffer, read per instance by the sprite vert shader
+            .addBinding(4, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT) // Neighbor buffer
+            .addBinding(5, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_FRAGMENT_BIT)         // Frag shader input tile buffer
+            .addBinding(6, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_FRAGMENT_BIT)         // Frag shader input density grid
             .build();
 
-    recreateScreenTextureImage(lveWindow.getExtent());
+    recreateScreenTextureImages(lveWindow.getExtent());
     updateGlobalDescriptorSets(true);
 
     lve::GraphicPipelineConfigInfo screenTexturePipelineConfigInfo{};
@@ -90,22 +134,31 @@ FluidSim2DApp::FluidSim2DApp()
     linePipelineConfigInfo.vertexBindingDescriptions = lve::Line::Vertex::getBindingDescriptions();
     linePipelineConfigInfo.vertexAttributeDescriptions = lve::Line::Vertex::getAttributeDescriptions();
 
-    screenTextureRenderSystem = lve::RenderSystem(
-        lveDevice,
-        lveRenderer.getSwapChainRenderPass(),
-        {globalSetLayout->getDescriptorSetLayout()},
-        screenTexturePipelineConfigInfo);
-
-    lineRenderSystem = lve::RenderSystem(
-        lveDevice,
-        lveRenderer.getSwapChainRenderPass(),
-        {globalSetLayout->getDescriptorSetLayout()},
-        linePipelineConfigInfo);
-
-    fluidSimComputeSystem = lve::ComputeSystem(
-        lveDevice,
-        {globalSetLayout->getDescriptorSetLayout()},
-        "my_compute_shader.comp.spv");
+    lve::GraphicPipelineConfigInfo particleSpritePipelineConfigInfo{};
+    particleSpritePipelineConfigInfo.vertFilepath = "particle_sprite.vert.spv";
+    particleSpritePipelineConfigInfo.fragFilepath = "particle_sprite.frag.spv";
+
+    // the pipelines compile concurrently, the config infos outlive the builder, which waits for its builds
+    auto pipelineStartTime = std::chrono::steady_clock::now();
+    {
+        lve::PipelineBuilder pipelineBuilder{lveDevice, *threadPool};
+        VkRenderPass renderPass = lveRenderer.getSwapChainRenderPass();
+        std::vector<VkDescriptorSetLayout> setLayouts{globalSetLayout->getDescriptorSetLayout()};
+
+        auto screenTextureBuild = pipelineBuilder.buildRenderSystem(renderPass, setLayouts, screenTexturePipelineConfigInfo);
+        auto lineBuild = pipelineBuilder.buildRenderSystem(renderPass, setLayouts, linePipelineConfigInfo);
+        auto particleSpriteBuild = pipelineBuilder.buildRenderSystem(renderPass, setLayouts, particleSpritePipelineConfigInfo);
+        auto fluidSimComputeBuild = pipelineBuilder.buildComputeSystem(setLayouts, "my_compute_shader.comp.spv");
+
+        screenTextureRenderSystem = screenTextureBuild.get();
+        lineRenderSystem = lineBuild.get();
+        particleSpriteRenderSystem = particleSpriteBuild.get();
+        fluidSimComputeSystem = fluidSimComputeBuild.get();
+    }
+    std::chrono::duration<double, std::milli> pipelineTime = std::chrono::steady_clock::now() - pipelineStartTime;
+    std::cout << "Built pipelines on " << threadPool->getThreadCount() << " threads in " << pipelineTime.count() << " ms" << std::endl;
+
+    lveDevice.getPipelineCache().printCreationSummary();
 }
 
 FluidSim2DApp::~FluidSim2DApp()
@@ -122,32 +175,66 @@ void FluidSim2DApp::run()
     isRunning = false;
     renderThread.join();
 
+    if (frameCapture != nullptr)
+        toggleFrameCapture(); // finish the encoding of captured frames
+
     vkDeviceWaitIdle(lveDevice.device());
+
+    if (lve::trace::isRecording())
+    {
+        lve::trace::stop();
+        lve::trace::flushToFile(TRACE_FILE_PATH);
+        std::cout << "Trace written to " << TRACE_FILE_PATH << std::endl;
+    }
 }
 
 void FluidSim2DApp::updateGlobalDescriptorSets(bool needMemoryAlloc)
 {
-    VkDescriptorImageInfo screenTextureDescriptorInfo = screenTextureImage.getDescriptorImageInfo(
-        0, lve::SamplerManager::getSampler({lve::SamplerType::DEFAULT, lveDevice.device()}));
-    auto particleBufferInfo = particleBuffer->descriptorInfo();
-    auto neighborBufferInfo = neighborBuffer->descriptorInfo();
-
     for (int i = 0; i < globalDescriptorSets.size(); i++)
+        updateGlobalDescriptorSet(i, needMemoryAlloc);
+    outdatedDescriptorSets.assign(globalDescriptorSets.size(), false);
+}
+
+void FluidSim2DApp::updateGlobalDescriptorSet(int frameIndex, bool needMemoryAlloc)
+{
+    auto uboBufferInfo = frameAllocator.descriptorInfo(sizeof(GlobalUbo));
+    // written as a storage image in GENERAL layout by the compute pass, then sampled read only
+    VkDescriptorImageInfo screenTextureSampledInfo = screenTextureImages[frameIndex].getDescriptorImageInfo(
+        0,
+        lve::SamplerManager::getSampler({lve::SamplerType::DEFAULT, lveDevice.device()}),
+        VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+    VkDescriptorImageInfo screenTextureStorageInfo = screenTextureImages[frameIndex].getDescriptorImageInfo(
+        0, VK_NULL_HANDLE, VK_IMAGE_LAYOUT_GENERAL);
+    auto particleBufferInfo = particleBuffers[frameIndex]->descriptorInfo();
+    auto neighborBufferInfo = neighborBuffers[frameIndex]->descriptorInfo();
+    auto tileBufferInfo = tileBuffers[frameIndex]->descriptorInfo();
+    auto densityBufferInfo = densityBuffers[frameIndex]->descriptorInfo();
+    lve::DescriptorWriter writer{*globalSetLayout, *globalPool};
+    writer.writeBuffer(0, &uboBufferInfo)
+        .writeImage(1, &screenTextureSampledInfo)    // combined image sampler
+        .writeImage(2, &screenTextureStorageInfo)    // storage image
+        .writeBuffer(3, &particleBufferInfo)         // storage buffer
+        .writeBuffer(4, &neighborBufferInfo)         // storage buffer
+        .writeBuffer(5, &tileBufferInfo)             // storage buffer
+        .writeBuffer(6, &densityBufferInfo);         // storage buffer
+
+    if (needMemoryAlloc)
     {
-        auto uboBufferInfo = uboBuffers[i]->descriptorInfo();
-        lve::DescriptorWriter writer{*globalSetLayout, *globalPool};
-        writer.writeBuffer(0, &uboBufferInfo)
-            .writeImage(1, &screenTextureDescriptorInfo) // combined image sampler
-            .writeImage(2, &screenTextureDescriptorInfo) // storage image
-            .writeBuffer(3, &particleBufferInfo)         // storage buffer
-            .writeBuffer(4, &neighborBufferInfo);        // storage buffer
-
-        if (needMemoryAlloc)
-        {
-            writer.allocateDescriptorSet(globalDescriptorSets[i]);
-        }
-        writer.overwrite(globalDescriptorSets[i]);
+        writer.allocateDescriptorSet(globalDescriptorSets[frameIndex]);
     }
+    writer.overwrite(globalDescriptorSets[frameIndex]);
+}
+
+VkDeviceSize FluidSim2DApp::getFrameAllocatorSize()
+{
+    // allocations are aligned to at most 256 bytes
+    return sizeof(GlobalUbo) + sizeof(lve::Line) * getMaxLineCount() + 256 * 2;
+}
+
+void FluidSim2DApp::writeGlobalUbo()
+{
+    GlobalUbo ubo{};
+    globalDynamicOffsets[0] = frameAllocator.write(&ubo, sizeof(GlobalUbo)).dynamicOffset();
 }
 
 VkImageCreateInfo FluidSim2DApp::createScreenTextureInfo(VkFormat format, VkExtent2D extent)
@@ -161,8 +248,8 @@ VkImageCreateInfo FluidSim2DApp::createScreenTextureInfo(VkFormat format, VkExte
     screenTextureInfo.extent.depth = 1;
     screenTextureInfo.mipLevels = 1;
     screenTextureInfo.arrayLayers = 1;
-    screenTextureInfo.tiling = VK_IMAGE_TILING_LINEAR;
-    screenTextureInfo.initialLayout = VK_IMAGE_LAYOUT_GENERAL;
+    screenTextureInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+    screenTextureInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED; // transitioned in the frame command buffer
     screenTextureInfo.usage = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_STORAGE_BIT;
     screenTextureInfo.samples = VK_SAMPLE_COUNT_1_BIT;
     screenTextureInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
@@ -170,7 +257,7 @@ VkImageCreateInfo FluidSim2DApp::createScreenTextureInfo(VkFormat format, VkExte
     return screenTextureInfo;
 }
 
-void FluidSim2DApp::createScreenTextureImageView()
+void FluidSim2DApp::createScreenTextureImageView(lve::Image &screenTextureImage)
 {
     VkImageViewCreateInfo screenTextureViewInfo{};
     screenTextureViewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
@@ -186,79 +273,346 @@ void FluidSim2DApp::createScreenTextureImageView()
     screenTextureImage.createImageView(0, &screenTextureViewInfo);
 }
 
-void FluidSim2DApp::recreateScreenTextureImage(VkExtent2D extent)
+void FluidSim2DApp::recreateScreenTextureImages(VkExtent2D extent)
 {
-    screenTextureImage = lve::Image(
-        lveDevice,
-        createScreenTextureInfo(screenTextureFormat, extent),
-        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    VkImageCreateInfo screenTextureInfo = createScreenTextureInfo(screenTextureFormat, extent);
 
-    createScreenTextureImageView();
+    // written on the compute queue and sampled on the graphics queue without ownership transfers
+    lve::QueueFamilyIndices queueFamilyIndices = lveDevice.findPhysicalQueueFamilies();
+    uint32_t queueFamilies[] = {queueFamilyIndices.graphicsFamily, computeQueue.getQueueFamily()};
+    if (computeQueue.isAsync())
+    {
+        screenTextureInfo.sharingMode = VK_SHARING_MODE_CONCURRENT;
+        screenTextureInfo.queueFamilyIndexCount = 2;
+        screenTextureInfo.pQueueFamilyIndices = queueFamilies;
+    }
+
+    screenTextureImages.clear();
+    for (int i = 0; i < lveDevice.getFramesInFlight(); i++)
+    {
+        screenTextureImages.emplace_back(lveDevice, screenTextureInfo, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+        createScreenTextureImageView(screenTextureImages.back());
+    }
 }
 
-void FluidSim2DApp::initParticleBuffer()
+void FluidSim2DApp::initParticleBuffers()
 {
     int particleCount = fluidParticleSys.getParticleCount();
 
-    particleBuffer = std::make_unique<lve::Buffer>(
-        lveDevice,
-        sizeof(int) +                           // particle count
-            sizeof(float) +                     // smoothing radius
-            sizeof(float) +                     // target density
-            sizeof(float) +                     // data scale
-            sizeof(uint32_t) +                  // isNeighborViewActive
-            sizeof(uint32_t) +                  // isDensityViewActive
-            sizeof(glm::vec2) * particleCount + // position
-            sizeof(glm::vec2) * particleCount,  // velocity
-        1,
-        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
-        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
-    particleBuffer->map();
-    particleBuffer->writeToBuffer(&particleCount, sizeof(int));
-
-    neighborBuffer = std::make_unique<lve::Buffer>(
-        lveDevice,
-        sizeof(int) * particleCount,
-        1,
-        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
-        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
-    neighborBuffer->map();
+    particleBuffers.resize(lveDevice.getFramesInFlight());
+    neighborBuffers.resize(lveDevice.getFramesInFlight());
+    uploadedParticleHeaders.assign(lveDevice.getFramesInFlight(), ParticleBufferHeader{});
+    for (int i = 0; i < particleBuffers.size(); i++)
+    {
+        particleBuffers[i] = std::make_unique<lve::StagedBuffer>(
+            lveDevice,
+            sizeof(ParticleBufferHeader) +
+                sizeof(glm::vec2) * particleCount + // position, sized for the unpacked format
+                sizeof(glm::vec2) * particleCount,  // velocity
+            VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+            useDirectBuffers);
+
+        neighborBuffers[i] = std::make_unique<lve::StagedBuffer>(
+            lveDevice,
+            sizeof(int) * particleCount,
+            VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+            useDirectBuffers);
+    }
 }
 
-void FluidSim2DApp::writeParticleBuffer()
+/*
+ * Only what changed since this frame's buffer was last written is uploaded: the header when a
+ * parameter or view toggle changed, positions and velocities when the simulation stepped, and the
+ * neighbor list only while the neighbor view is on
+ */
+void FluidSim2DApp::writeParticleBuffer(int frameIndex)
 {
+    LVE_TRACE_ZONE("FluidSim2DApp::writeParticleBuffer");
     int particleCount = fluidParticleSys.getParticleCount();
-    float smoothRadius = fluidParticleSys.getSmoothRadius();
-    float targetDensity = fluidParticleSys.getTargetDensity();
-    float dataScale = fluidParticleSys.getDataScale();
-    uint32_t isNeighborViewActive = static_cast<uint32_t>(fluidParticleSys.isNeighborViewOn());
-    uint32_t isDensityViewActive = static_cast<uint32_t>(fluidParticleSys.isDensityViewOn());
-
-    particleBuffer->setRecordedOffset(sizeof(int));
-    particleBuffer->writeToBufferOrdered(&smoothRadius, sizeof(float));
-    particleBuffer->writeToBufferOrdered(&targetDensity, sizeof(float));
-    particleBuffer->writeToBufferOrdered(&dataScale, sizeof(float));
-    particleBuffer->writeToBufferOrdered(&isNeighborViewActive, sizeof(uint32_t));
-    particleBuffer->writeToBufferOrdered(&isDensityViewActive, sizeof(uint32_t));
-    particleBuffer->writeToBufferOrdered((void *)fluidParticleSys.getPositionData().data(), sizeof(glm::vec2) * particleCount);
-    particleBuffer->writeToBufferOrdered((void *)fluidParticleSys.getVelocityData().data(), sizeof(glm::vec2) * particleCount);
-
-    neighborBuffer->writeToBuffer((void *)fluidParticleSys.getFirstParticleNeighborIndex().data());
+    uint64_t dataVersion = fluidParticleSys.getParticleDataVersion();
+    lve::Buffer &particleBuffer = particleBuffers[frameIndex]->getHostBuffer();
+    lve::Buffer &neighborBuffer = neighborBuffers[frameIndex]->getHostBuffer();
+    LVE_STATS_ONLY(size_t uploadedBytes = 0);
+
+    ParticleBufferHeader header{};
+    header.particleCount = static_cast<uint32_t>(particleCount);
+    header.smoothRadius = fluidParticleSys.getSmoothRadius();
+    header.targetDensity = fluidParticleSys.getTargetDensity();
+    header.dataScale = fluidParticleSys.getDataScale();
+    header.isNeighborViewActive = static_cast<uint32_t>(fluidParticleSys.isNeighborViewOn());
+    header.isDensityViewActive = static_cast<uint32_t>(fluidParticleSys.isDensityViewOn());
+    header.isPackedFormat = static_cast<uint32_t>(usePackedParticleFormat);
+    header.positionRangeX = fluidParticleSys.getScaledWindowExtent().x;
+    header.positionRangeY = fluidParticleSys.getScaledWindowExtent().y;
+    bool headerChanged = std::memcmp(&header, &uploadedParticleHeaders[frameIndex], sizeof(ParticleBufferHeader)) != 0;
+    if (headerChanged)
+    {
+        particleBuffer.writeToBuffer(&header, sizeof(ParticleBufferHeader));
+        uploadedParticleHeaders[frameIndex] = header;
+        LVE_STATS_ONLY(uploadedBytes += sizeof(ParticleBufferHeader));
+    }
+
+    // the format and the packed position range are in the header, so a header change also rewrites the data
+    if (headerChanged || particleBuffer.getContentVersion() != dataVersion)
+    {
+        particleBuffer.setRecordedOffset(sizeof(ParticleBufferHeader));
+        if (usePackedParticleFormat)
+        {
+            fluidParticleSys.packRenderData();
+            const std::vector<uint32_t> &packedData = fluidParticleSys.getPackedRenderData();
+            particleBuffer.writeToBufferOrdered((void *)packedData.data(), sizeof(uint32_t) * packedData.size());
+            LVE_STATS_ONLY(uploadedBytes += sizeof(uint32_t) * packedData.size());
+        }
+        else
+        {
+            particleBuffer.writeToBufferOrdered((void *)fluidParticleSys.getPositionData().data(), sizeof(glm::vec2) * particleCount);
+            particleBuffer.writeToBufferOrdered((void *)fluidParticleSys.getVelocityData().data(), sizeof(glm::vec2) * particleCount);
+            LVE_STATS_ONLY(uploadedBytes += sizeof(glm::vec2) * particleCount * 2);
+        }
+        particleBuffer.setContentVersion(dataVersion);
+    }
+
+    if (fluidParticleSys.isNeighborViewOn() && neighborBuffer.getContentVersion() != dataVersion)
+    {
+        neighborBuffer.writeToBuffer((void *)fluidParticleSys.getFirstParticleNeighborIndex().data());
+        neighborBuffer.setContentVersion(dataVersion);
+        LVE_STATS_ONLY(uploadedBytes += neighborBuffer.getBufferSize());
+    }
+
+    LVE_STATS_RECORD("render/particle_upload_bytes", uploadedBytes);
 }
 
-void FluidSim2DApp::drawDebugLines(VkCommandBuffer cmdBuffer)
+void FluidSim2DApp::togglePackedParticleFormat()
+{
+    usePackedParticleFormat = !usePackedParticleFormat;
+    std::cout << "Packed particle format: " << (usePackedParticleFormat ? "on" : "off") << std::endl;
+}
+
+/*
+ * Tile buffer layout: tile size, tile count x, tile count y, particle radius, then tile offsets
+ * (tile count + 1 entries) followed by the particle indices of all tiles
+ */
+void FluidSim2DApp::recreateTileBuffers(VkExtent2D extent)
+{
+    tileBinner.setScreenExtent(extent.width, extent.height);
+    size_t maxEntryCount = tileBinner.getMaxEntryCount(fluidParticleSys.getParticleCount());
+
+    uint32_t tileSize = tileBinner.getTileSize();
+    uint32_t tileCountX = tileBinner.getTileCountX();
+    uint32_t tileCountY = tileBinner.getTileCountY();
+    float particleRadius = tileBinner.getParticleRadius();
+
+    tileBuffers.resize(lveDevice.getFramesInFlight());
+    for (auto &stagedTileBuffer : tileBuffers)
+    {
+        stagedTileBuffer = std::make_unique<lve::StagedBuffer>(
+            lveDevice,
+            sizeof(uint32_t) * 3 +                                   // tile size, tile count x, tile count y
+                sizeof(float) +                                      // particle radius
+                sizeof(uint32_t) * (tileBinner.getTileCount() + 1) + // tile offsets
+                sizeof(uint32_t) * maxEntryCount,                    // particle indices
+            VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+            useDirectBuffers);
+
+        lve::Buffer &tileBuffer = stagedTileBuffer->getHostBuffer();
+        tileBuffer.setRecordedOffset(0);
+        tileBuffer.writeToBufferOrdered(&tileSize, sizeof(uint32_t));
+        tileBuffer.writeToBufferOrdered(&tileCountX, sizeof(uint32_t));
+        tileBuffer.writeToBufferOrdered(&tileCountY, sizeof(uint32_t));
+        tileBuffer.writeToBufferOrdered(&particleRadius, sizeof(float));
+    }
+}
+
+void FluidSim2DApp::writeTileBuffer(int frameIndex)
+{
+    uint64_t dataVersion = fluidParticleSys.getParticleDataVersion();
+    lve::Buffer &tileBuffer = tileBuffers[frameIndex]->getHostBuffer();
+    if (tileBuffer.getContentVersion() == dataVersion)
+        return;
+
+    LVE_TRACE_ZONE("FluidSim2DApp::writeTileBuffer");
+    {
+        LVE_STATS_SCOPE("render/tile_binning_ms");
+        LVE_TRACE_ZONE("tile binning");
+        tileBinner.bin(fluidParticleSys.getPositionData(), fluidParticleSys.getDataScale());
+    }
+    LVE_STATS_RECORD("render/tile_entries", tileBinner.getEntryCount());
+
+    const std::vector<uint32_t> &tileOffsets = tileBinner.getTileOffsets();
+    const std::vector<uint32_t> &particleIndices = tileBinner.getParticleIndices();
+    tileBuffer.setRecordedOffset(sizeof(uint32_t) * 3 + sizeof(float));
+    tileBuffer.writeToBufferOrdered((void *)tileOffsets.data(), sizeof(uint32_t) * tileOffsets.size());
+    tileBuffer.writeToBufferOrdered((void *)particleIndices.data(), sizeof(uint32_t) * particleIndices.size());
+    tileBuffer.setContentVersion(dataVersion);
+}
+
+/*
+ * Density buffer layout: grid width, grid height, cell size in pixels, then the density of every
+ * grid node row by row
+ */
+void FluidSim2DApp::recreateDensityBuffers(VkExtent2D extent)
+{
+    densitySplatter.setScreenExtent(extent.width, extent.height);
+    uint32_t gridWidth = densitySplatter.getGridWidth();
+    uint32_t gridHeight = densitySplatter.getGridHeight();
+    float cellSize = densitySplatter.getCellSize();
+
+    densityBuffers.resize(lveDevice.getFramesInFlight());
+    for (auto &stagedDensityBuffer : densityBuffers)
+    {
+        stagedDensityBuffer = std::make_unique<lve::StagedBuffer>(
+            lveDevice,
+            sizeof(uint32_t) * 2 +                                       // grid width, grid height
+                sizeof(float) +                                          // cell size
+                sizeof(float) * densitySplatter.getDensityData().size(), // density
+            VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+            useDirectBuffers);
+
+        lve::Buffer &densityBuffer = stagedDensityBuffer->getHostBuffer();
+        densityBuffer.setRecordedOffset(0);
+        densityBuffer.writeToBufferOrdered(&gridWidth, sizeof(uint32_t));
+        densityBuffer.writeToBufferOrdered(&gridHeight, sizeof(uint32_t));
+        densityBuffer.writeToBufferOrdered(&cellSize, sizeof(float));
+    }
+}
+
+void FluidSim2DApp::writeDensityBuffer(int frameIndex)
+{
+    uint64_t dataVersion = fluidParticleSys.getParticleDataVersion();
+    lve::Buffer &densityBuffer = densityBuffers[frameIndex]->getHostBuffer();
+    if (!fluidParticleSys.isDensityViewOn() || densityBuffer.getContentVersion() == dataVersion)
+        return;
+
+    LVE_TRACE_ZONE("FluidSim2DApp::writeDensityBuffer");
+    {
+        LVE_STATS_SCOPE("render/density_splat_ms");
+        LVE_TRACE_ZONE("density splat");
+        densitySplatter.splat(
+            fluidParticleSys.getPositionData(),
+            fluidParticleSys.getSmoothRadius(),
+            fluidParticleSys.getDataScale(),
+            threadPool.get());
+    }
+
+    const std::vector<float> &densityData = densitySplatter.getDensityData();
+    densityBuffer.setRecordedOffset(sizeof(uint32_t) * 2 + sizeof(float));
+    densityBuffer.writeToBufferOrdered((void *)densityData.data(), sizeof(float) * densityData.size());
+    densityBuffer.setContentVersion(dataVersion);
+}
+
+/*
+ * The compute pass rewrites the whole screen texture each frame, so its previous contents are
+ * discarded, and the fragment reads of the last frame are ordered before the new writes by the
+ * tracked source scope of the first transition
+ * On the async compute queue the fragment stage does not exist: the wait for the slot's previous
+ * frame already orders the reads of the slot's texture, and the semaphore wait of the graphics submission makes the
+ * writes visible to the fragment shader.
+ */
+void FluidSim2DApp::dispatchScreenTexture(VkCommandBuffer cmdBuffer, int frameIndex)
+{
+    lve::Image &screenTextureImage = screenTextureImages[frameIndex];
+    screenTextureImage.transition(
+        cmdBuffer,
+        VK_IMAGE_LAYOUT_GENERAL,
+        VK_ACCESS_SHADER_WRITE_BIT,
+        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+        true);
+
+    {
+        LVE_GPU_ZONE(lveRenderer.getGpuProfiler(), cmdBuffer, "gpu/screen_texture_compute_ms");
+        fluidSimComputeSystem.dispatchComputePipeline(
+            cmdBuffer,
+            &globalDescriptorSets[frameIndex],
+            static_cast<int>(std::ceil(windowExtent.width / 8.f)),
+            static_cast<int>(std::ceil(windowExtent.height / 8.f)),
+            globalDynamicOffsets);
+    }
+
+    bool isAsync = computeQueue.isAsync();
+    screenTextureImage.transition(
+        cmdBuffer,
+        VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+        isAsync ? 0 : VK_ACCESS_SHADER_READ_BIT,
+        isAsync ? VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT : VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);
+}
+
+// the graphics submission of the frame waits for the compute pass before its fragment shaders
+void FluidSim2DApp::submitScreenTextureCompute(int frameIndex)
+{
+    VkCommandBuffer computeCommandBuffer = computeQueue.beginFrame(frameIndex);
+    dispatchScreenTexture(computeCommandBuffer, frameIndex);
+    uint64_t computeValue = computeQueue.submit();
+    lveRenderer.addWaitSemaphore(
+        computeQueue.getTimelineSemaphore(),
+        VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+        computeValue);
+}
+
+// copy this frame's writes into the device local buffers, before the render pass reads them
+void FluidSim2DApp::uploadFrameBuffers(VkCommandBuffer cmdBuffer, int frameIndex)
+{
+    LVE_TRACE_ZONE("FluidSim2DApp::uploadFrameBuffers");
+    particleBuffers[frameIndex]->recordUpload(cmdBuffer);
+    neighborBuffers[frameIndex]->recordUpload(cmdBuffer);
+    tileBuffers[frameIndex]->recordUpload(cmdBuffer);
+    densityBuffers[frameIndex]->recordUpload(cmdBuffer);
+}
+
+/*
+ * The density view is always a full screen pass. Otherwise particles are either shaded per pixel
+ * from the tile lists, or drawn as instanced sprites so the fragment cost only scales with the
+ * area they cover.
+ */
+void FluidSim2DApp::drawParticles(VkCommandBuffer cmdBuffer)
 {
-    if (!fluidParticleSys.isDebugLineOn())
+    int frameIndex = lveRenderer.getFrameIndex();
+    if (particleRenderMode == SCREEN_TEXTURE || fluidParticleSys.isDensityViewOn())
+    {
+        LVE_GPU_ZONE(lveRenderer.getGpuProfiler(), cmdBuffer, "gpu/screen_texture_ms");
+        lve::renderScreenTexture(
+            cmdBuffer,
+            &globalDescriptorSets[frameIndex],
+            screenTextureRenderSystem.getPipelineLayout(),
+            screenTextureRenderSystem.getPipeline(),
+            windowExtent,
+            globalDynamicOffsets);
         return;
+    }
+
+    LVE_GPU_ZONE(lveRenderer.getGpuProfiler(), cmdBuffer, "gpu/particle_sprites_ms");
+    lve::renderInstancedQuads(
+        cmdBuffer,
+        &globalDescriptorSets[frameIndex],
+        particleSpriteRenderSystem.getPipelineLayout(),
+        particleSpriteRenderSystem.getPipeline(),
+        windowExtent,
+        particleRadius,
+        0.5f, // same depth as the screen texture, debug lines stay in front
+        fluidParticleSys.getParticleCount(),
+        globalDynamicOffsets);
+}
 
+void FluidSim2DApp::updateDebugLines()
+{
     lineCollection.clearLines();
-    lineCollection.addLines(fluidParticleSys.getDebugLines());
+    lineCollection.addLines(fluidParticleSys.getObstacleLines());
+    if (fluidParticleSys.isDebugLineOn())
+        lineCollection.addLines(fluidParticleSys.getDebugLines());
+}
+
+void FluidSim2DApp::drawDebugLines(VkCommandBuffer cmdBuffer)
+{
+    if (lineCollection.getLineCount() == 0)
+        return;
+
+    LVE_GPU_ZONE(lveRenderer.getGpuProfiler(), cmdBuffer, "gpu/debug_lines_ms");
     lve::renderLines(
         cmdBuffer,
         &globalDescriptorSets[lveRenderer.getFrameIndex()],
         lineRenderSystem.getPipelineLayout(),
         lineRenderSystem.getPipeline(),
-        lineCollection);
+        lineCollection,
+        globalDynamicOffsets);
 }
 
 void FluidSim2DApp::handleInput()
@@ -292,10 +646,61 @@ void FluidSim2DApp::handleInput()
                                   { fluidParticleSys.toggleNeighborView(); });
     lveWindow.input.oneTimeKeyUse(GLFW_KEY_D, [this]
                                   { fluidParticleSys.toggleDensityView(); });
+
+    lveWindow.input.oneTimeKeyUse(GLFW_KEY_S, [this]
+                                  {fluidParticleSys.toggleSymmetricPairForce();
+                                  std::cout << "Symmetric pair force: " << (fluidParticleSys.isSymmetricPairForceOn() ? "on" : "off") << std::endl; });
+    lveWindow.input.oneTimeKeyUse(GLFW_KEY_B, [this]
+                                  { fluidParticleSys.benchmarkPairForce(); });
+    lveWindow.input.oneTimeKeyUse(GLFW_KEY_P, [this]
+                                  {lve::stats::StatsRecorder::printSummary();
+                                  lveDevice.getMemoryAllocator().printStats();
+                                  lve::stats::StatsRecorder::dumpJson("stats.json");
+                                  std::cout << "Stats written to stats.json" << std::endl; });
+    lveWindow.input.oneTimeKeyUse(GLFW_KEY_T, [this]
+                                  { toggleTrace(); });
+    lveWindow.input.oneTimeKeyUse(GLFW_KEY_H, [this]
+                                  { togglePackedParticleFormat(); });
+    lveWindow.input.oneTimeKeyUse(GLFW_KEY_C, [this]
+                                  { toggleFrameCapture(); });
+}
+
+void FluidSim2DApp::toggleTrace()
+{
+    if (!lve::trace::isRecording())
+    {
+        lve::trace::start();
+        std::cout << "Trace recording started" << std::endl;
+        return;
+    }
+    lve::trace::stop();
+    lve::trace::flushToFile(TRACE_FILE_PATH);
+    std::cout << "Trace written to " << TRACE_FILE_PATH << std::endl;
+}
+
+void FluidSim2DApp::toggleFrameCapture()
+{
+    if (frameCapture == nullptr)
+    {
+        if (!lveRenderer.supportsImageCopy())
+        {
+            std::cout << "Frame capture is not supported, swap chain images cannot be copied" << std::endl;
+            return;
+        }
+        frameCapture = std::make_unique<lve::FrameCapture>(lveDevice, frameCaptureConfigInfo);
+        std::cout << "Frame capture started, writing to " << frameCaptureConfigInfo.outputDirectory << std::endl;
+        return;
+    }
+
+    frameCapture->finish();
+    std::cout << "Frame capture stopped: " << frameCapture->getCapturedFrameCount() << " frames written, "
+              << frameCapture->getDroppedFrameCount() << " dropped" << std::endl;
+    frameCapture.reset();
 }
 
 void FluidSim2DApp::renderLoop()
 {
+    LVE_TRACE_THREAD_NAME("render");
     auto currentTime = std::chrono::high_resolution_clock::now();
     auto now = currentTime;
     bool oneSecondPassed;
@@ -319,35 +724,57 @@ void FluidSim2DApp::renderLoop()
         if (auto commandBuffer = lveRenderer.beginFrame())
         {
             int frameIndex = lveRenderer.getFrameIndex();
+            frameAllocator.beginFrame(frameIndex);
+            if (outdatedDescriptorSets[frameIndex])
+            {
+                updateGlobalDescriptorSet(frameIndex);
+                outdatedDescriptorSets[frameIndex] = false;
+            }
+            writeGlobalUbo();
 
             // update
             windowExtent = lveWindow.getExtent();
-            fluidSimComputeSystem.dispatchComputePipeline(
-                commandBuffer,
-                &globalDescriptorSets[frameIndex],
-                static_cast<int>(std::ceil(windowExtent.width / 8.f)),
-                static_cast<int>(std::ceil(windowExtent.height / 8.f)));
+            if (computeQueue.isAsync())
+                submitScreenTextureCompute(frameIndex);
+            else
+                dispatchScreenTexture(commandBuffer, frameIndex);
 
             handleInput();
 
             // fluid particle system
             fluidParticleSys.updateParticleData(frameTime);
-            writeParticleBuffer();
+            writeParticleBuffer(frameIndex);
+            if (particleRenderMode == SCREEN_TEXTURE)
+                writeTileBuffer(frameIndex);
+            writeDensityBuffer(frameIndex);
+            uploadFrameBuffers(commandBuffer, frameIndex);
+            updateDebugLines();
 
             // render
             lveRenderer.beginSwapChainRenderPass(commandBuffer);
 
-            renderScreenTexture(
-                commandBuffer,
-                &globalDescriptorSets[frameIndex],
-                screenTextureRenderSystem.getPipelineLayout(),
-                screenTextureRenderSystem.getPipeline(),
-                windowExtent);
-
+            drawParticles(commandBuffer);
             drawDebugLines(commandBuffer);
 
             lveRenderer.endSwapChainRenderPass(commandBuffer);
+
+            if (frameCapture != nullptr)
+            {
+                frameCapture->recordCapture(
+                    commandBuffer,
+                    lveRenderer.getCurrentImage(),
+                    VK_IMAGE_LAYOUT_PRESENT_SRC_KHR,
+                    lveRenderer.getImageFormat(),
+                    lveRenderer.getExtent());
+            }
+
             lveRenderer.endFrame();
+
+            if (frameCapture != nullptr)
+            {
+                frameCapture->submit();
+                frameCapture->poll();
+            }
         }
     }
 }
@@ -1,14 +1,22 @@
 #pragma once
 
+#include "app/fluid_sim/2d/density_splatter.hpp"
 #include "app/fluid_sim/2d/fluid_particle_system.hpp"
+#include "app/fluid_sim/2d/particle_buffer_header.hpp"
+#include "app/fluid_sim/2d/tile_binner.hpp"
 #include "lve/core/resource/descriptors.hpp"
+#include "lve/core/resource/frame_allocator.hpp"
 #include "lve/core/resource/image.hpp"
+#include "lve/core/resource/staged_buffer.hpp"
+#include "lve/core/compute_queue.hpp"
 #include "lve/core/device.hpp"
+#include "lve/core/frame_capture.hpp"
 #include "lve/core/frame_manager.hpp"
 #include "lve/core/window.hpp"
 #include "lve/core/system/render_system.hpp"
 #include "lve/core/system/compute_system.hpp"
 #include "lve/go/geo/line.hpp"
+#include "lve/util/thread_pool.hpp"
 
 // std
 #include <memory>
@@ -37,6 +45,8 @@ private:
     lve::Window lveWindow{128, 128, APP_NAME};
     lve::Device lveDevice{lveWindow};
     lve::FrameManager lveRenderer{lveWindow, lveDevice};
+    // the screen texture compute pass runs here when the device has an async compute queue
+    lve::ComputeQueue computeQueue{lveDevice};
     VkExtent2D windowExtent = lveWindow.getExtent();
 
     // Frame rate
@@ -50,35 +60,86 @@ private:
 
     // GPU resources
     std::unique_ptr<lve::DescriptorPool> globalPool{};
-    std::vector<std::unique_ptr<lve::Buffer>> uboBuffers;
-    std::unique_ptr<lve::Buffer> particleBuffer;
-    std::unique_ptr<lve::Buffer> neighborBuffer;
+    // storage buffers are duplicated per frame in flight, so the CPU never writes a buffer the GPU may still read
+    // device local and uploaded through a staging buffer each, or host visible only when useDirectBuffers is set
+    std::vector<std::unique_ptr<lve::StagedBuffer>> particleBuffers;
+    std::vector<std::unique_ptr<lve::StagedBuffer>> neighborBuffers;
+    std::vector<std::unique_ptr<lve::StagedBuffer>> tileBuffers;
+    std::vector<std::unique_ptr<lve::StagedBuffer>> densityBuffers;
+    bool useDirectBuffers = false;
+    bool usePackedParticleFormat = false; // unorm16 positions and fp16 velocities instead of floats
+    void togglePackedParticleFormat();
+
+    // the header last written to each frame's particle buffer, kept to skip unchanged uploads
+    std::vector<ParticleBufferHeader> uploadedParticleHeaders;
     std::unique_ptr<lve::DescriptorSetLayout> globalSetLayout;
     std::vector<VkDescriptorSet> globalDescriptorSets;
+    std::vector<bool> outdatedDescriptorSets; // rewritten when their frame slot begins next, not while in flight
     lve::RenderSystem screenTextureRenderSystem{lveDevice};
     lve::RenderSystem lineRenderSystem{lveDevice};
+    lve::RenderSystem particleSpriteRenderSystem{lveDevice};
     lve::ComputeSystem fluidSimComputeSystem{lveDevice};
 
-    lve::Image screenTextureImage{lveDevice};
+    // one per frame in flight, so the compute pass of the next frame never writes the texture sampled by the current one
+    std::vector<lve::Image> screenTextureImages;
     VkFormat screenTextureFormat = VK_FORMAT_R8G8B8A8_UNORM;
 
     FluidParticleSystem fluidParticleSys{"config/fluidSim2D.yaml", lveWindow.getExtent()};
-    lve::LineCollection lineCollection{lveDevice, fluidParticleSys.getParticleCount()};
+
+    // per frame data rewritten every frame: the global ubo (dynamic binding 0) and the debug lines
+    size_t getMaxLineCount() { return fluidParticleSys.getParticleCount() + fluidParticleSys.getObstacleLines().size(); }
+    VkDeviceSize getFrameAllocatorSize();
+    lve::FrameAllocator frameAllocator{lveDevice, getFrameAllocatorSize(), VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT};
+    std::vector<uint32_t> globalDynamicOffsets{0};
+    void writeGlobalUbo();
+
+    lve::LineCollection lineCollection{lveDevice, getMaxLineCount(), &frameAllocator};
+    TileBinner tileBinner{16, 4.f};        // replaced by config values in constructor
+    DensitySplatter densitySplatter{4.f}; // replaced by config values in constructor
+
+    // SCREEN_TEXTURE shades every pixel against its tile's particle list, SPRITE draws one instanced quad per particle
+    enum ParticleRenderMode
+    {
+        SCREEN_TEXTURE,
+        SPRITE
+    };
+    ParticleRenderMode particleRenderMode = SCREEN_TEXTURE;
+    float particleRadius = 4.f; // in pixels
 
     void updateGlobalDescriptorSets(bool build = false);
+    void updateGlobalDescriptorSet(int frameIndex, bool build = false);
 
     VkImageCreateInfo createScreenTextureInfo(VkFormat format, VkExtent2D extent);
-    void createScreenTextureImageView();
-    void recreateScreenTextureImage(VkExtent2D extent);
-
-    void initParticleBuffer();
-    void writeParticleBuffer();
+    void createScreenTextureImageView(lve::Image &screenTextureImage);
+    void recreateScreenTextureImages(VkExtent2D extent);
+
+    void initParticleBuffers();
+    void writeParticleBuffer(int frameIndex);
+    void recreateTileBuffers(VkExtent2D extent);
+    void writeTileBuffer(int frameIndex);
+    void recreateDensityBuffers(VkExtent2D extent);
+    void writeDensityBuffer(int frameIndex);
+    void uploadFrameBuffers(VkCommandBuffer cmdBuffer, int frameIndex);
+    void dispatchScreenTexture(VkCommandBuffer cmdBuffer, int frameIndex);
+    void submitScreenTextureCompute(int frameIndex);
+    void drawParticles(VkCommandBuffer cmdBuffer);
+    void updateDebugLines(); // rebuilds the line list, written to the frame allocator when drawn
     void drawDebugLines(VkCommandBuffer cmdBuffer);
 
     // Input
     void handleInput();
 
+    // Profiling
+    const std::string TRACE_FILE_PATH = "trace.json";
+    void toggleTrace();
+
+    // Frame capture, recording while frameCapture exists
+    lve::FrameCaptureConfigInfo frameCaptureConfigInfo{};
+    std::unique_ptr<lve::FrameCapture> frameCapture;
+    void toggleFrameCapture();
+
     // Multi-threading
     std::atomic<bool> isRunning{true};
+    std::unique_ptr<lve::ThreadPool> threadPool;
     void renderLoop();
 };
\ No newline at end of file
@@ -0,0 +1,134 @@
+#include "app/fluid_sim/2d/density_splatter.hpp"
+
+// std
+#include <algorithm>
+#include <cmath>
+#include <future>
+#include <stdexcept>
+
+DensitySplatter::DensitySplatter(float cellSize, uint32_t bandRows)
+    : cellSize{cellSize}, bandRows{bandRows}
+{
+    if (cellSize <= 0.f || bandRows == 0)
+        throw std::runtime_error("Density grid cell size and band rows must be greater than 0");
+}
+
+void DensitySplatter::setScreenExtent(uint32_t width, uint32_t height)
+{
+    gridWidth = static_cast<uint32_t>(std::ceil(width / cellSize)) + 1;
+    gridHeight = static_cast<uint32_t>(std::ceil(height / cellSize)) + 1;
+    bandCount = (gridHeight + bandRows - 1) / bandRows;
+    densityData.assign(gridWidth * gridHeight, 0.f);
+    bandOffsets.assign(bandCount + 1, 0);
+}
+
+void DensitySplatter::splat(const std::vector<glm::vec2> &positions, float smoothRadius, float dataScale, lve::ThreadPool *threadPool)
+{
+    binParticles(positions, smoothRadius / dataScale, dataScale);
+
+    if (threadPool == nullptr)
+    {
+        for (uint32_t band = 0; band < bandCount; band++)
+            accumulateBand(band, positions, smoothRadius, dataScale);
+        return;
+    }
+
+    std::vector<std::future<void>> bandTasks;
+    bandTasks.reserve(bandCount);
+    for (uint32_t band = 0; band < bandCount; band++)
+        bandTasks.push_back(threadPool->submit(
+            [this, band, &positions, smoothRadius, dataScale]()
+            { accumulateBand(band, positions, smoothRadius, dataScale); }));
+    for (auto &task : bandTasks)
+        task.get();
+}
+
+/*
+ * Counting sort of the particles into row bands, a particle is listed in every band its
+ * footprint overlaps
+ */
+void DensitySplatter::binParticles(const std::vector<glm::vec2> &positions, float radiusInPixels, float dataScale)
+{
+    std::fill(bandOffsets.begin(), bandOffsets.end(), 0);
+    particleNodeRanges.resize(positions.size());
+
+    for (size_t i = 0; i < positions.size(); i++)
+    {
+        glm::vec2 pixelPos = positions[i] / dataScale;
+        NodeRange range;
+        range.minX = std::max(static_cast<int>(std::ceil((pixelPos.x - radiusInPixels) / cellSize)), 0);
+        range.minY = std::max(static_cast<int>(std::ceil((pixelPos.y - radiusInPixels) / cellSize)), 0);
+        range.maxX = std::min(static_cast<int>(std::floor((pixelPos.x + radiusInPixels) / cellSize)), static_cast<int>(gridWidth) - 1);
+        range.maxY = std::min(static_cast<int>(std::floor((pixelPos.y + radiusInPixels) / cellSize)), static_cast<int>(gridHeight) - 1);
+        particleNodeRanges[i] = range;
+        if (range.minX > range.maxX || range.minY > range.maxY)
+            continue;
+
+        for (int band = range.minY / static_cast<int>(bandRows); band <= range.maxY / static_cast<int>(bandRows); band++)
+            bandOffsets[band + 1]++;
+    }
+
+    for (size_t b = 1; b < bandOffsets.size(); b++)
+        bandOffsets[b] += bandOffsets[b - 1];
+
+    bandParticleIndices.resize(bandOffsets.back());
+    bandCursor.assign(bandOffsets.begin(), bandOffsets.end() - 1);
+    for (size_t i = 0; i < positions.size(); i++)
+    {
+        const NodeRange &range = particleNodeRanges[i];
+        if (range.minX > range.maxX || range.minY > range.maxY)
+            continue;
+
+        for (int band = range.minY / static_cast<int>(bandRows); band <= range.maxY / static_cast<int>(bandRows); band++)
+            bandParticleIndices[bandCursor[band]++] = static_cast<uint32_t>(i);
+    }
+}
+
+// Clear the rows of one band and add the spiky pow2 kernel of the particles listed in it
+void DensitySplatter::accumulateBand(uint32_t band, const std::vector<glm::vec2> &positions, float smoothRadius, float dataScale)
+{
+    int bandMinY = static_cast<int>(band * bandRows);
+    int bandMaxY = std::min(bandMinY + static_cast<int>(bandRows), static_cast<int>(gridHeight)) - 1;
+    std::fill(densityData.begin() + bandMinY * gridWidth, densityData.begin() + (bandMaxY + 1) * gridWidth, 0.f);
+
+    float scalingFactor = 6.f / (M_PI * smoothRadius * smoothRadius * smoothRadius * smoothRadius);
+    float smoothRadiusSqr = smoothRadius * smoothRadius;
+    float cellSizeScaled = cellSize * dataScale;
+    for (uint32_t k = bandOffsets[band]; k < bandOffsets[band + 1]; k++)
+    {
+        uint32_t i = bandParticleIndices[k];
+        const NodeRange &range = particleNodeRanges[i];
+        int minY = std::max(range.minY, bandMinY);
+        int maxY = std::min(range.maxY, bandMaxY);
+        for (int y = minY; y <= maxY; y++)
+        {
+            float dy = y * cellSizeScaled - positions[i].y;
+            float *row = densityData.data() + y * gridWidth;
+            for (int x = range.minX; x <= range.maxX; x++)
+            {
+                float dx = x * cellSizeScaled - positions[i].x;
+                float distanceSqr = dx * dx + dy * dy;
+                if (distanceSqr >= smoothRadiusSqr)
+                    continue;
+                float v = smoothRadius - std::sqrt(distanceSqr);
+                row[x] += scalingFactor * v * v;
+            }
+        }
+    }
+}
+
+float DensitySplatter::sample(glm::vec2 pixelPos) const
+{
+    glm::vec2 gridPos = glm::clamp(pixelPos / cellSize, glm::vec2(0.f), glm::vec2(gridWidth - 1, gridHeight - 1));
+    int x0 = std::min(static_cast<int>(gridPos.x), static_cast<int>(gridWidth) - 2);
+    int y0 = std::min(static_cast<int>(gridPos.y), static_cast<int>(gridHeight) - 2);
+    glm::vec2 fraction = gridPos - glm::vec2(x0, y0);
+
+    float d00 = densityData[y0 * gridWidth + x0];
+    float d10 = densityData[y0 * gridWidth + x0 + 1];
+    float d01 = densityData[(y0 + 1) * gridWidth + x0];
+    float d11 = densityData[(y0 + 1) * gridWidth + x0 + 1];
+    float bottom = d00 + (d10 - d00) * fraction.x;
+    float top = d01 + (d11 - d01) * fraction.x;
+    return bottom + (top - bottom) * fraction.y;
+}
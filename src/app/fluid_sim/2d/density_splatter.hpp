@@ -0,0 +1,63 @@
+#pragma once
+
+#include "lve/util/thread_pool.hpp"
+
+// libs
+#include "include/glm.hpp"
+
+// std
+#include <cstdint>
+#include <vector>
+
+/*
+ * Scatters the density kernel of every particle into a low resolution grid covering the screen
+ * Grid node (x, y) sits at pixel (x, y) * cellSize. The grid is split into bands of rows, every
+ * particle is listed in the bands its footprint touches and each band is accumulated by a single
+ * task, so bands can run in parallel without atomics or reduction. Running without a thread pool
+ * gives the same result and serves as the headless reference.
+ */
+class DensitySplatter
+{
+public:
+    DensitySplatter(float cellSize, uint32_t bandRows = 8);
+
+    void setScreenExtent(uint32_t width, uint32_t height);
+
+    /*
+     * Rebuild the density grid
+     * @param positions: particle positions in simulation space
+     * @param smoothRadius: kernel radius in simulation space
+     * @param dataScale: simulation units per pixel
+     * @param threadPool: pool used to accumulate the bands, nullptr runs on the calling thread
+     */
+    void splat(const std::vector<glm::vec2> &positions, float smoothRadius, float dataScale, lve::ThreadPool *threadPool = nullptr);
+
+    // bilinear sample, same interpolation as the shader
+    float sample(glm::vec2 pixelPos) const;
+
+    float getCellSize() const { return cellSize; }
+    uint32_t getGridWidth() const { return gridWidth; }
+    uint32_t getGridHeight() const { return gridHeight; }
+    const std::vector<float> &getDensityData() const { return densityData; }
+
+private:
+    float cellSize; // in pixels
+    uint32_t bandRows;
+    uint32_t gridWidth = 0;
+    uint32_t gridHeight = 0;
+    uint32_t bandCount = 0;
+    std::vector<float> densityData;
+
+    // footprint of each particle in grid nodes, inclusive, empty when min > max
+    struct NodeRange
+    {
+        int minX, minY, maxX, maxY;
+    };
+    std::vector<NodeRange> particleNodeRanges;
+    std::vector<uint32_t> bandOffsets;
+    std::vector<uint32_t> bandParticleIndices;
+    std::vector<uint32_t> bandCursor;
+
+    void binParticles(const std::vector<glm::vec2> &positions, float radiusInPixels, float dataScale);
+    void accumulateBand(uint32_t band, const std::vector<glm::vec2> &positions, float smoothRadius, float dataScale);
+};
@@ -1,10 +1,16 @@
 #include "app/fluid_sim/2d/fluid_particle_system.hpp"
 #include "lve/util/math.hpp"
+#include "lve/util/pack.hpp"
 #include "lve/util/file_io.hpp"
+#include "lve/util/stats.hpp"
+#include "lve/util/trace.hpp"
 
 // std
 #include <algorithm>
+#include <chrono>
+#include <cmath>
 #include <iostream>
+#include <map>
 
 FluidParticleSystem::FluidParticleSystem(const std::string &configFilePath, VkExtent2D windowExtent) : windowExtent(windowExtent)
 {
@@ -20,12 +26,17 @@ FluidParticleSystem::FluidParticleSystem(const std::string &configFilePath, VkEx
     bool randomize = config.get<bool>("randomize");
 
     initParticleData(glm::vec2(startPoint[0], startPoint[1]), stride, maxWidth, randomize);
+    initObstacles(config);
 }
 
 void FluidParticleSystem::reloadConfigParam()
 {
     lve::io::YamlConfig config{configFilePath};
+    float previousCollisionRadius = obstacleCollisionRadius;
     initSimParams(config);
+    if (obstacleCollisionRadius != previousCollisionRadius)
+        bakeObstacleSdf(); // the baked region is padded by the collision radius
+    particleDataVersion++; // data scale and kernel radius change how the same positions are drawn
 }
 
 void FluidParticleSystem::initParticleData(glm::vec2 startPoint, float stride, float maxWidth, bool randomize)
@@ -35,9 +46,9 @@ void FluidParticleSystem::initParticleData(glm::vec2 startPoint, float stride, f
     velocityData.resize(particleCount);
     densityData.resize(particleCount);
     massData.resize(particleCount);
+    gridCoordData.resize(particleCount);
 
-    spacialLookup.resize(particleCount);
-    spacialLookupEntry.resize(particleCount);
+    spatialHash.resize(particleCount);
 
     // debug
     pressureForceData.resize(particleCount);
@@ -84,6 +95,10 @@ void FluidParticleSystem::initSimParams(lve::io::YamlConfig &config)
     dataScale = config.get<float>("dataScale");
     rangeForceScale = config.get<float>("rangeForceScale");
     rangeForceRadius = config.get<float>("rangeForceRadius");
+    useSymmetricPairForce = config.get<bool>("symmetricPairForce");
+    pairForceBenchmarkIterations = config.get<int>("pairForceBenchmarkIterations");
+    obstacleCollisionRadius = config.get<float>("obstacleCollisionRadius");
+    obstacleRestitution = config.get<float>("obstacleRestitution");
 
     scaledWindowExtent.x = static_cast<float>(windowExtent.width) * dataScale;
     scaledWindowExtent.y = static_cast<float>(windowExtent.height) * dataScale;
@@ -97,6 +112,78 @@ void FluidParticleSystem::initSimParams(lve::io::YamlConfig &config)
     scalingFactorSpikyPow2_2D_atZero = kernelSpikyPow2_2D(0.f, smoothRadius);
 }
 
+/*
+ * Load obstacles from config and bake them into the signed distance field
+ * "obstacles" is a list of polygons in scaled coordinates, "obstacleModels" is a list of OBJ
+ * files with their position and scale, both are optional
+ */
+void FluidParticleSystem::initObstacles(lve::io::YamlConfig &config)
+{
+    if (config.isKeyDefined("obstacles"))
+    {
+        auto polygons = config.get<std::vector<std::vector<std::vector<float>>>>("obstacles");
+        for (const auto &polygon : polygons)
+        {
+            ObstacleSdf::Polygon vertices;
+            for (const auto &vertex : polygon)
+                vertices.push_back(glm::vec2(vertex[0], vertex[1]));
+            obstacleSdf.addPolygon(vertices);
+        }
+    }
+
+    if (config.isKeyDefined("obstacleModels"))
+    {
+        auto models = config.get<std::vector<std::map<std::string, std::string>>>("obstacleModels");
+        for (auto &model : models)
+        {
+            float positionX = std::stof(model["positionX"]);
+            float positionY = std::stof(model["positionY"]);
+            obstacleSdf.addObjOutline(model["file"], glm::vec2(positionX, positionY), std::stof(model["scale"]));
+        }
+    }
+
+    sdfCellSize = config.get<float>("sdfCellSize");
+    bakeObstacleSdf();
+
+    obstacleLines.resize(obstacleSdf.getOutline().size());
+    for (lve::Line &line : obstacleLines)
+    {
+        line.start.color = glm::vec4(1.f, 1.f, 1.f, 1.f);
+        line.end.color = glm::vec4(1.f, 1.f, 1.f, 1.f);
+    }
+    updateObstacleLines();
+}
+
+void FluidParticleSystem::bakeObstacleSdf()
+{
+    // the grid only needs to cover the region where collision can happen
+    obstacleSdf.bake(sdfCellSize, obstacleCollisionRadius + 2.f * sdfCellSize);
+}
+
+void FluidParticleSystem::updateObstacleLines()
+{
+    const std::vector<ObstacleSdf::Segment> &outline = obstacleSdf.getOutline();
+    for (size_t i = 0; i < outline.size(); i++)
+    {
+        obstacleLines[i].start.position = glm::vec3(scaledPos2ScreenPos(outline[i].start), debugLineZ);
+        obstacleLines[i].end.position = glm::vec3(scaledPos2ScreenPos(outline[i].end), debugLineZ);
+    }
+}
+
+void FluidParticleSystem::packRenderData()
+{
+    static_assert(sizeof(glm::vec2) == sizeof(float) * 2, "particle data is packed as interleaved float pairs");
+    LVE_TRACE_ZONE("fluid2d/pack_render_data");
+    packedRenderData.resize(particleCount * 2);
+    lve::pack::packUnorm2x16(
+        &positionData[0].x,
+        particleCount,
+        1.f / scaledWindowExtent.x,
+        1.f / scaledWindowExtent.y,
+        packedRenderData.data());
+    lve::pack::packHalf2x16(&velocityData[0].x, particleCount, packedRenderData.data() + particleCount);
+}
+
 glm::vec2 FluidParticleSystem::scaledPos2ScreenPos(glm::vec2 scaledPos) const
 {
     return 2.f * scaledPos / scaledWindowExtent - glm::vec2(1.f, 1.f);
@@ -107,6 +194,7 @@ void FluidParticleSystem::updateWindowExtent(VkExtent2D newExtent)
     windowExtent = newExtent;
     scaledWindowExtent.x = static_cast<float>(windowExtent.width) * dataScale;
     scaledWindowExtent.y = static_cast<float>(windowExtent.height) * dataScale;
+    updateObstacleLines();
 }
 
 void FluidParticleSystem::updateParticleData(float deltaTime)
@@ -123,31 +211,25 @@ void FluidParticleSystem::updateParticleData(float deltaTime)
     if (deltaTime > maxDeltaTime)
         deltaTime = maxDeltaTime;
 
-    for (int i = 0; i < particleCount; i++) // update predicted position and spacial lookup
-    {
-        nextPositionData[i] = positionData[i] + velocityData[i] * lookAheadTime;
-        int hashValue = hashGridCoord2D(pos2gridCoord(nextPositionData[i], smoothRadius));
-        unsigned int hashKey = lve::math::positiveMod(hashValue, particleCount);
-        spacialLookup[i].particleIndex = i;
-        spacialLookup[i].spatialHashKey = hashKey;
-    }
+    LVE_STATS_SCOPE("fluid2d/update_ms");
+    LVE_TRACE_ZONE("fluid2d/update");
+    LVE_STATS_ONLY(updateCounters = {});
 
-    std::sort(
-        spacialLookup.begin(),
-        spacialLookup.end(),
-        [](const SpatialHashEntry &a, const SpatialHashEntry &b)
+    {
+        LVE_STATS_SCOPE("fluid2d/hash_ms");
+        LVE_TRACE_ZONE("fluid2d/hash");
+        for (int i = 0; i < particleCount; i++) // update predicted position and spacial lookup
         {
-            return a.spatialHashKey < b.spatialHashKey;
-        });
-
-    // init spacial lookup entry
-    std::fill(spacialLookupEntry.begin(), spacialLookupEntry.end(), -1);
-    for (int i = 0; i < particleCount; i++)
+            nextPositionData[i] = positionData[i] + velocityData[i] * lookAheadTime;
+            gridCoordData[i] = pos2gridCoord(nextPositionData[i], smoothRadius);
+            int hashValue = SpatialHash::hashGridCoord2D(gridCoordData[i]);
+            spatialHash.setEntry(i, spatialHash.hashKey(hashValue));
+        }
+    }
     {
-        unsigned int key = spacialLookup[i].spatialHashKey;
-        unsigned int keyPrev = (i == 0) ? -1 : spacialLookup[i - 1].spatialHashKey;
-        if (key != keyPrev)
-            spacialLookupEntry[key] = i;
+        LVE_STATS_SCOPE("fluid2d/sort_ms");
+        LVE_TRACE_ZONE("fluid2d/sort");
+        spatialHash.build();
     }
 
     if (isNeighborViewActive)
@@ -159,25 +241,68 @@ void FluidParticleSystem::updateParticleData(float deltaTime)
         firstParticleNeighborIndex.push_back(-1); // mark the end of the list
     }
 
-    for (int i = 0; i < particleCount; i++) // calculate density using predicted position
-        densityData[i] = calculateDensity(i);
+    {
+        LVE_STATS_SCOPE("fluid2d/density_ms");
+        LVE_TRACE_ZONE("fluid2d/density");
+        if (useSymmetricPairForce)
+            calculateDensityPairwise(); // calculate density using predicted position
+        else
+        {
+            for (int i = 0; i < particleCount; i++)
+                densityData[i] = calculateDensity(i);
+        }
+    }
 
-    for (int i = 0; i < particleCount; i++) // update velocity and position
+    auto integrate = [&](int i) // update velocity and position
     {
-        pressureForceData[i] = calculatePressureForce(i);
         externalForceData[i] = calculateExternalForce(i);
-        viscosityForceData[i] = calculateViscosityForce(i);
 
         glm::vec2 acceleration = (pressureForceData[i] + viscosityForceData[i] + externalForceData[i]) / densityData[i].density;
         velocityData[i] += acceleration * deltaTime;
         positionData[i] += velocityData[i] * deltaTime;
+        resolveObstacleCollision(i);
+    };
+
+    if (useSymmetricPairForce)
+    {
+        {
+            LVE_STATS_SCOPE("fluid2d/forces_ms");
+            LVE_TRACE_ZONE("fluid2d/forces");
+            calculatePairForce();
+        }
+        LVE_STATS_SCOPE("fluid2d/integrate_ms");
+        LVE_TRACE_ZONE("fluid2d/integrate");
+        for (int i = 0; i < particleCount; i++)
+            integrate(i);
+    }
+    else
+    {
+        // forces are evaluated right before each particle is integrated, so later particles see the
+        // velocities integrated before them, both are timed together
+        LVE_STATS_SCOPE("fluid2d/forces_integrate_ms");
+        LVE_TRACE_ZONE("fluid2d/forces_integrate");
+        for (int i = 0; i < particleCount; i++)
+        {
+            pressureForceData[i] = calculatePressureForce(i);
+            viscosityForceData[i] = calculateViscosityForce(i);
+            integrate(i);
+        }
     }
+    particleDataVersion++;
 
     rangeForceInfo.active = false;
 
     // update debug lines
     if (isDebugLineVisible)
+    {
+        LVE_STATS_SCOPE("fluid2d/debug_lines_ms");
+        LVE_TRACE_ZONE("fluid2d/debug_lines");
         updateDebugLines();
+    }
+
+    LVE_STATS_RECORD("fluid2d/candidates_visited", updateCounters.candidatesVisited);
+    LVE_STATS_RECORD("fluid2d/hash_collisions_rejected", updateCounters.collisionsRejected);
+    LVE_STATS_RECORD("fluid2d/avg_neighbors", static_cast<double>(updateCounters.neighborsFound) / particleCount);
 }
 
 void FluidParticleSystem::updateDebugLines()
@@ -279,6 +404,7 @@ FluidParticleSystem::Density FluidParticleSystem::calculateDensity(unsigned int
             float distance = glm::distance(particleNextPos, nextPositionData[neighborIndex]);
             if (distance >= smoothRadius)
                 return;
+            LVE_STATS_ONLY(updateCounters.neighborsFound++);
             density += massData[neighborIndex] * kernelSpikyPow2_2D(distance, smoothRadius);
             nearDensity += massData[neighborIndex] * kernelSpikyPow3_2D(distance, smoothRadius);
         });
@@ -378,6 +504,32 @@ glm::vec2 FluidParticleSystem::calculateExternalForce(unsigned int particleIndex
     return externalForce;
 }
 
+/*
+ * Push a particle out of the obstacles along the SDF gradient and reflect the velocity
+ * component pointing into the obstacle
+ * @param particleIndex: index of the particle
+ */
+void FluidParticleSystem::resolveObstacleCollision(unsigned int particleIndex)
+{
+    if (obstacleSdf.isEmpty())
+        return;
+
+    glm::vec2 particlePos = positionData[particleIndex];
+    float distance = obstacleSdf.sample(particlePos);
+    if (distance >= obstacleCollisionRadius)
+        return;
+
+    glm::vec2 normal = obstacleSdf.sampleGradient(particlePos);
+    if (normal == glm::vec2(0.f, 0.f))
+        return;
+
+    positionData[particleIndex] = particlePos + normal * (obstacleCollisionRadius - distance);
+
+    float normalVelocity = glm::dot(velocityData[particleIndex], normal);
+    if (normalVelocity < 0.f)
+        velocityData[particleIndex] -= (1.f + obstacleRestitution) * normalVelocity * normal;
+}
+
 glm::vec2 FluidParticleSystem::calculateViscosityForce(unsigned int particleIndex)
 {
     glm::vec2 viscosityForce = glm::vec2(0.f, 0.f);
@@ -403,9 +555,154 @@ glm::int2 FluidParticleSystem::pos2gridCoord(glm::vec2 position, float gridWidth
     return {x, y};
 }
 
-int FluidParticleSystem::hashGridCoord2D(glm::int2 gridCoord) const
+/*
+ * Iterate over every pair of particles closer than the smoothing radius exactly once
+ * Only the own cell and 4 of the 8 neighbor cells are searched, callers apply the pair
+ * contribution to both particles
+ * @param callback: function called with (i, j, distance, nextPos[j] - nextPos[i])
+ */
+template <typename Callback>
+void FluidParticleSystem::foreachNeighborPair(Callback &&callback)
+{
+    float smoothRadiusSqr = smoothRadius * smoothRadius;
+    for (unsigned int i = 0; i < particleCount; i++)
+    {
+        glm::vec2 particleNextPos = nextPositionData[i];
+        glm::int2 gridPos = gridCoordData[i];
+        for (int k = 0; k < 5; k++)
+        {
+            glm::int2 offsetGridPos = gridPos + halfOffset2D[k];
+            unsigned int hashKey = spatialHash.hashKey(SpatialHash::hashGridCoord2D(offsetGridPos));
+            spatialHash.foreachInBucket(
+                hashKey,
+                [&](unsigned int j)
+                {
+                    LVE_STATS_ONLY(updateCounters.candidatesVisited++);
+                    // exact cell check skips hash collisions and keeps every pair unique
+                    if (gridCoordData[j] != offsetGridPos)
+                    {
+                        LVE_STATS_ONLY(updateCounters.collisionsRejected++);
+                        return;
+                    }
+                    if (k == 0 && j <= i)
+                        return;
+
+                    glm::vec2 offset = nextPositionData[j] - particleNextPos;
+                    float distanceSqr = glm::dot(offset, offset);
+                    if (distanceSqr >= smoothRadiusSqr)
+                        return;
+
+                    callback(i, j, std::sqrt(distanceSqr), offset);
+                });
+        }
+    }
+}
+
+void FluidParticleSystem::calculateDensityPairwise()
+{
+    for (int i = 0; i < particleCount; i++)
+    {
+        densityData[i].density = massData[i] * scalingFactorSpikyPow2_2D_atZero;
+        densityData[i].nearDensity = massData[i] * scalingFactorSpikyPow3_2D_atZero;
+    }
+
+    foreachNeighborPair(
+        [&](unsigned int i, unsigned int j, float distance, glm::vec2)
+        {
+            LVE_STATS_ONLY(updateCounters.neighborsFound += 2);
+            float influence = kernelSpikyPow2_2D(distance, smoothRadius);
+            float nearInfluence = kernelSpikyPow3_2D(distance, smoothRadius);
+            densityData[i].density += massData[j] * influence;
+            densityData[i].nearDensity += massData[j] * nearInfluence;
+            densityData[j].density += massData[i] * influence;
+            densityData[j].nearDensity += massData[i] * nearInfluence;
+        });
+}
+
+/*
+ * Pressure and viscosity forces of all particles, written to pressureForceData and
+ * viscosityForceData. Single threaded, so applying both sides of a pair never conflicts.
+ */
+void FluidParticleSystem::calculatePairForce()
+{
+    std::fill(pressureForceData.begin(), pressureForceData.end(), glm::vec2(0.f, 0.f));
+    std::fill(viscosityForceData.begin(), viscosityForceData.end(), glm::vec2(0.f, 0.f));
+
+    foreachNeighborPair(
+        [&](unsigned int i, unsigned int j, float distance, glm::vec2 offset)
+        {
+            glm::vec2 dir; // from i to j
+            if (distance < glm::epsilon<float>())
+                dir = glm::circularRand(1.f);
+            else
+                dir = offset / distance;
+
+            float pressureI = pressureMultiplier * (densityData[i].density - targetDensity);
+            float pressureJ = pressureMultiplier * (densityData[j].density - targetDensity);
+            float nearPressureI = nearPressureMultiplier * densityData[i].nearDensity;
+            float nearPressureJ = nearPressureMultiplier * densityData[j].nearDensity;
+            float sharedPressure = (pressureI + pressureJ) * 0.5f;
+            float sharedNearPressure = (nearPressureI + nearPressureJ) * 0.5f;
+
+            float pressureTerm = derivativeSpikyPow2_2D(distance, smoothRadius) * sharedPressure;
+            float nearPressureTerm = derivativeSpikyPow3_2D(distance, smoothRadius) * sharedNearPressure;
+            pressureForceData[i] += (pressureTerm / densityData[j].density +
+                                     nearPressureTerm / densityData[j].nearDensity) * dir;
+            pressureForceData[j] -= (pressureTerm / densityData[i].density +
+                                     nearPressureTerm / densityData[i].nearDensity) * dir;
+
+            glm::vec2 viscosityTerm = (velocityData[j] - velocityData[i]) *
+                                      kernelPoly6_2D(distance, smoothRadius) * viscosityMultiplier;
+            viscosityForceData[i] += viscosityTerm;
+            viscosityForceData[j] -= viscosityTerm;
+        });
+}
+
+/*
+ * Time the full stencil and the half stencil paths on the current predicted positions and
+ * print the cost of each, along with the largest force difference between them
+ */
+void FluidParticleSystem::benchmarkPairForce()
 {
-    return static_cast<uint32_t>(gridCoord.x) * 15823 + static_cast<uint32_t>(gridCoord.y) * 9737333;
+    int iterations = pairForceBenchmarkIterations;
+    std::vector<glm::vec2> fullPressureForce(particleCount);
+    std::vector<glm::vec2> fullViscosityForce(particleCount);
+
+    auto startTime = std::chrono::high_resolution_clock::now();
+    for (int it = 0; it < iterations; it++)
+    {
+        for (int i = 0; i < particleCount; i++)
+            densityData[i] = calculateDensity(i);
+        for (int i = 0; i < particleCount; i++)
+        {
+            fullPressureForce[i] = calculatePressureForce(i);
+            fullViscosityForce[i] = calculateViscosityForce(i);
+        }
+    }
+    auto fullTime = std::chrono::high_resolution_clock::now() - startTime;
+
+    startTime = std::chrono::high_resolution_clock::now();
+    for (int it = 0; it < iterations; it++)
+    {
+        calculateDensityPairwise();
+        calculatePairForce();
+    }
+    auto halfTime = std::chrono::high_resolution_clock::now() - startTime;
+
+    float maxPressureDiff = 0.f;
+    float maxViscosityDiff = 0.f;
+    for (int i = 0; i < particleCount; i++)
+    {
+        maxPressureDiff = std::max(maxPressureDiff, glm::length(fullPressureForce[i] - pressureForceData[i]));
+        maxViscosityDiff = std::max(maxViscosityDiff, glm::length(fullViscosityForce[i] - viscosityForceData[i]));
+    }
+
+    float fullMs = std::chrono::duration<float, std::milli>(fullTime).count() / iterations;
+    float halfMs = std::chrono::duration<float, std::milli>(halfTime).count() / iterations;
+    std::cout << "Pair force benchmark (" << particleCount << " particles, " << iterations << " iterations)" << std::endl
+              << "  full stencil: " << fullMs << " ms" << std::endl
+              << "  half stencil: " << halfMs << " ms (" << fullMs / halfMs << "x)" << std::endl
+              << "  max difference: pressure " << maxPressureDiff << ", viscosity " << maxViscosityDiff << std::endl;
 }
 
 /*
@@ -421,26 +718,23 @@ void FluidParticleSystem::foreachNeighbor(unsigned int particleIndex, std::funct
     for (int i = 0; i < 9; i++)
     {
         glm::int2 offsetGridPos = gridPos + offset2D[i];
-        unsigned int hashKey = lve::math::positiveMod(hashGridCoord2D(offsetGridPos), particleCount);
-        int startIndex = spacialLookupEntry[hashKey];
-        if (startIndex == -1) // no particle in this grid
-            continue;
-
-        for (int j = startIndex; j < particleCount; j++)
-        {
-            if (spacialLookup[j].spatialHashKey != hashKey)
-                break;
-
-            unsigned int neighborIndex = spacialLookup[j].particleIndex;
-
-            // simple check to skip hash collision
-            glm::vec2 neighborNextPos = nextPositionData[neighborIndex];
-            if (std::abs(neighborNextPos.x - particleNextPos.x) > smoothRadius_mul_2 ||
-                std::abs(neighborNextPos.y - particleNextPos.y) > smoothRadius_mul_2)
-                continue;
+        unsigned int hashKey = spatialHash.hashKey(SpatialHash::hashGridCoord2D(offsetGridPos));
+        spatialHash.foreachInBucket(
+            hashKey,
+            [&](unsigned int neighborIndex)
+            {
+                LVE_STATS_ONLY(updateCounters.candidatesVisited++);
+                // simple check to skip hash collision
+                glm::vec2 neighborNextPos = nextPositionData[neighborIndex];
+                if (std::abs(neighborNextPos.x - particleNextPos.x) > smoothRadius_mul_2 ||
+                    std::abs(neighborNextPos.y - particleNextPos.y) > smoothRadius_mul_2)
+                {
+                    LVE_STATS_ONLY(updateCounters.collisionsRejected++);
+                    return;
+                }
 
-            if (neighborIndex != particleIndex)
-                callback(neighborIndex);
-        }
+                if (neighborIndex != particleIndex)
+                    callback(neighborIndex);
+            });
     }
 }
\ No newline at end of file
@@ -1,5 +1,7 @@
 #pragma once
 
+#include "app/fluid_sim/2d/obstacle_sdf.hpp"
+#include "app/fluid_sim/common/spatial_hash.hpp"
 #include "lve/go/geo/line.hpp"
 #include "lve/util/math.hpp"
 #include "lve/util/file_io.hpp"
@@ -28,6 +30,16 @@ public:
     float getDataScale() const { return dataScale; }
     std::vector<glm::vec2> &getPositionData() { return positionData; }
     std::vector<glm::vec2> &getVelocityData() { return velocityData; }
+    // bumped whenever particle data or the neighbor list changes, consumers compare it to skip unchanged uploads
+    uint64_t getParticleDataVersion() const { return particleDataVersion; }
+    glm::vec2 getScaledWindowExtent() const { return scaledWindowExtent; }
+
+    /*
+     * Compact render copy of the particle data: positions as unorm16 pairs relative to the scaled
+     * window extent, then velocities as fp16 pairs, one 32 bit word per particle each
+     */
+    void packRenderData();
+    const std::vector<uint32_t> &getPackedRenderData() const { return packedRenderData; }
 
     void setRangeForcePos(bool sign, glm::vec2 mousePosition);
 
@@ -47,16 +59,14 @@ public:
     bool isNeighborViewOn() { return isNeighborViewActive; }
     bool isDensityViewOn() { return isDensityViewActive; }
     void setDebugLineType(DebugLineType type) { debugLineType = type; }
+    void toggleSymmetricPairForce() { useSymmetricPairForce = !useSymmetricPairForce; }
+    bool isSymmetricPairForceOn() { return useSymmetricPairForce; }
+    void benchmarkPairForce();
     std::vector<int> &getFirstParticleNeighborIndex() { return firstParticleNeighborIndex; }
     std::vector<lve::Line> &getDebugLines() { return debugLines; }
+    std::vector<lve::Line> &getObstacleLines() { return obstacleLines; }
 
 private:
-    struct SpatialHashEntry
-    {
-        unsigned int particleIndex;
-        unsigned int spatialHashKey;
-    };
-
     std::string configFilePath;
     unsigned int particleCount;
     VkExtent2D windowExtent;
@@ -73,6 +83,17 @@ private:
     DebugLineType debugLineType = VELOCITY;
     bool isNeighborViewActive = false;
     bool isDensityViewActive = false;
+    bool useSymmetricPairForce = true;
+
+    // instrumentation counters, reset every update and recorded to lve::stats
+    struct UpdateCounters
+    {
+        size_t candidatesVisited;  // entries read from hash buckets, over all passes
+        size_t collisionsRejected; // entries from a different cell sharing the bucket
+        size_t neighborsFound;     // neighbors within smoothing radius in the density pass
+    };
+    UpdateCounters updateCounters{};
+    int pairForceBenchmarkIterations;
     unsigned int getClosetParticleIndex(glm::vec2 mousePosition);
     std::vector<glm::vec2> pressureForceData;
     std::vector<glm::vec2> externalForceData;
@@ -104,6 +125,8 @@ private:
     std::vector<glm::vec2> velocityData;
     std::vector<Density> densityData;
     std::vector<float> massData;
+    uint64_t particleDataVersion = 1; // buffers start at version 0, so the initial state is uploaded
+    std::vector<uint32_t> packedRenderData;
     void initParticleData(glm::vec2 startPoint, float stride, float maxWidth, bool randomize);
     void initSimParams(lve::io::YamlConfig &config);
     glm::vec2 scaledPos2ScreenPos(glm::vec2 scaledPos) const;
@@ -121,20 +144,38 @@ private:
     float scalingFactorSpikyPow2_2D;
     float scalingFactorSpikyPow2_2D_atZero;
 
-    // update rules
+    // update rules, full stencil (every pair is evaluated from both particles)
     Density calculateDensity(unsigned int particleIndex);
     glm::vec2 calculatePressureForce(unsigned int particleIndex);
     glm::vec2 calculateExternalForce(unsigned int particleIndex);
     glm::vec2 calculateViscosityForce(unsigned int particleIndex);
     glm::vec2 calculateNearPressureForce(unsigned int particleIndex);
 
+    // update rules, half stencil (every pair is evaluated once and applied to both particles)
+    void calculateDensityPairwise();
+    void calculatePairForce();
+
     // hash grid
-    std::vector<SpatialHashEntry> spacialLookup;
-    std::vector<int> spacialLookupEntry;
+    SpatialHash spatialHash;
+    std::vector<glm::int2> gridCoordData;
     glm::int2 pos2gridCoord(glm::vec2 position, float gridWidth) const;
-    int hashGridCoord2D(glm::int2 gridCoord) const;
     void foreachNeighbor(unsigned int particleIndex, std::function<void(int)> callback);
+    template <typename Callback>
+    void foreachNeighborPair(Callback &&callback);
     const glm::int2 offset2D[9] = {{-1, -1}, {0, -1}, {1, -1}, {-1, 0}, {0, 0}, {1, 0}, {-1, 1}, {0, 1}, {1, 1}};
+    // own cell followed by the upper half of the 9-cell neighborhood
+    const glm::int2 halfOffset2D[5] = {{0, 0}, {1, 0}, {-1, 1}, {0, 1}, {1, 1}};
+
+    // obstacles
+    ObstacleSdf obstacleSdf;
+    float obstacleCollisionRadius;
+    float obstacleRestitution;
+    float sdfCellSize;
+    std::vector<lve::Line> obstacleLines;
+    void initObstacles(lve::io::YamlConfig &config);
+    void bakeObstacleSdf();
+    void updateObstacleLines();
+    void resolveObstacleCollision(unsigned int particleIndex);
 
     // external force
     struct RangeForceInfo
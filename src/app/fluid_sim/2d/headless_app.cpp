@@ -0,0 +1,208 @@
+#include "app/fluid_sim/2d/headless_app.hpp"
+#include "app/fluid_sim/2d/particle_buffer_header.hpp"
+
+#include "lve/core/gpu_profiler.hpp"
+#include "lve/core/pipeline/pipeline_cache.hpp"
+#include "lve/util/image_io.hpp"
+#include "lve/util/stats.hpp"
+#include "lve/util/trace.hpp"
+
+// std
+#include <chrono>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+
+FluidSim2DHeadlessApp::FluidSim2DHeadlessApp()
+{
+    std::vector<int> windowSize = config.get<std::vector<int>>("windowSize");
+    frameExtent = {static_cast<uint32_t>(windowSize[0]), static_cast<uint32_t>(windowSize[1])};
+    frameCount = config.get<unsigned int>("headlessFrameCount");
+    fixedDeltaTime = config.get<float>("headlessTimeStep");
+    captureInterval = config.get<unsigned int>("headlessCaptureInterval");
+    captureDirectory = config.get<std::string>("headlessCaptureDirectory");
+    captureFormat = config.get<std::string>("headlessCaptureFormat");
+    particleRadius = config.get<float>("particleRadius");
+    if (captureFormat != "png" && captureFormat != "ppm")
+        throw std::runtime_error("Unknown headlessCaptureFormat: " + captureFormat + ", expected png or ppm");
+
+    lveRenderer = std::make_unique<lve::OffscreenFrameManager>(lveDevice, frameExtent);
+    fluidParticleSys = std::make_unique<FluidParticleSystem>(CONFIG_FILE_PATH, frameExtent);
+
+    globalPool =
+        lve::DescriptorPool::Builder(lveDevice)
+            .setMaxSets(lveDevice.getFramesInFlight())
+            .addPoolSize(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, lveDevice.getFramesInFlight() * 2) // particle and neighbor buffers
+            .build();
+
+    // binding numbers match the global set of FluidSim2DApp so the sprite shaders are shared
+    globalSetLayout =
+        lve::DescriptorSetLayout::Builder(lveDevice)
+            .addBinding(3, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT) // Particle buffer
+            .addBinding(4, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT) // Neighbor buffer
+            .build();
+
+    createParticleBuffers();
+
+    globalDescriptorSets.resize(lveDevice.getFramesInFlight());
+    for (int i = 0; i < globalDescriptorSets.size(); i++)
+    {
+        auto particleBufferInfo = particleBuffers[i]->descriptorInfo();
+        auto neighborBufferInfo = neighborBuffers[i]->descriptorInfo();
+        lve::DescriptorWriter writer{*globalSetLayout, *globalPool};
+        writer.writeBuffer(3, &particleBufferInfo)
+            .writeBuffer(4, &neighborBufferInfo);
+        writer.allocateDescriptorSet(globalDescriptorSets[i]);
+        writer.overwrite(globalDescriptorSets[i]);
+    }
+
+    lve::GraphicPipelineConfigInfo particleSpritePipelineConfigInfo{};
+    particleSpritePipelineConfigInfo.vertFilepath = "particle_sprite.vert.spv";
+    particleSpritePipelineConfigInfo.fragFilepath = "particle_sprite.frag.spv";
+
+    particleSpriteRenderSystem = lve::RenderSystem(
+        lveDevice,
+        lveRenderer->getSwapChainRenderPass(),
+        {globalSetLayout->getDescriptorSetLayout()},
+        particleSpritePipelineConfigInfo);
+
+    lveDevice.getPipelineCache().printCreationSummary();
+}
+
+FluidSim2DHeadlessApp::~FluidSim2DHeadlessApp()
+{
+    vkDeviceWaitIdle(lveDevice.device());
+}
+
+void FluidSim2DHeadlessApp::createParticleBuffers()
+{
+    int particleCount = fluidParticleSys->getParticleCount();
+    std::vector<int> noNeighbors(particleCount, 0);
+
+    particleBuffers.resize(lveDevice.getFramesInFlight());
+    neighborBuffers.resize(lveDevice.getFramesInFlight());
+    for (int i = 0; i < particleBuffers.size(); i++)
+    {
+        particleBuffers[i] = std::make_unique<lve::Buffer>(
+            lveDevice,
+            sizeof(ParticleBufferHeader) +
+                sizeof(glm::vec2) * particleCount + // position
+                sizeof(glm::vec2) * particleCount,  // velocity
+            1,
+            VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT);
+        particleBuffers[i]->map();
+
+        // the neighbor view is never on, the buffer only has to be bound
+        neighborBuffers[i] = std::make_unique<lve::Buffer>(
+            lveDevice,
+            sizeof(int) * particleCount,
+            1,
+            VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT);
+        neighborBuffers[i]->map();
+        neighborBuffers[i]->writeToBuffer(noNeighbors.data());
+        neighborBuffers[i]->flushDirtyRanges();
+    }
+}
+
+void FluidSim2DHeadlessApp::writeParticleBuffer(int frameIndex)
+{
+    LVE_TRACE_ZONE("FluidSim2DHeadlessApp::writeParticleBuffer");
+    int particleCount = fluidParticleSys->getParticleCount();
+    lve::Buffer &particleBuffer = *particleBuffers[frameIndex];
+
+    ParticleBufferHeader header{};
+    header.particleCount = static_cast<uint32_t>(particleCount);
+    header.smoothRadius = fluidParticleSys->getSmoothRadius();
+    header.targetDensity = fluidParticleSys->getTargetDensity();
+    header.dataScale = fluidParticleSys->getDataScale();
+    header.positionRangeX = fluidParticleSys->getScaledWindowExtent().x;
+    header.positionRangeY = fluidParticleSys->getScaledWindowExtent().y;
+
+    particleBuffer.setRecordedOffset(0);
+    particleBuffer.writeToBufferOrdered(&header, sizeof(ParticleBufferHeader));
+    particleBuffer.writeToBufferOrdered((void *)fluidParticleSys->getPositionData().data(), sizeof(glm::vec2) * particleCount);
+    particleBuffer.writeToBufferOrdered((void *)fluidParticleSys->getVelocityData().data(), sizeof(glm::vec2) * particleCount);
+    particleBuffer.flushDirtyRanges();
+}
+
+bool FluidSim2DHeadlessApp::isCaptureFrame(unsigned int frame) const
+{
+    if (frame == frameCount)
+        return true;
+    return captureInterval > 0 && frame % captureInterval == 0;
+}
+
+std::string FluidSim2DHeadlessApp::getCaptureFilePath(uint64_t frameNumber) const
+{
+    std::ostringstream filePath;
+    filePath << captureDirectory << "/frame_" << std::setw(6) << std::setfill('0') << frameNumber << "." << captureFormat;
+    return filePath.str();
+}
+
+/*
+ * Frames are recorded back to back, a captured frame is written to disk from its readback
+ * callback once the graphics timeline reached the frame's value, so the GPU keeps working on the
+ * next frames meanwhile
+ */
+void FluidSim2DHeadlessApp::run()
+{
+    std::cout << "FluidSim2DHeadlessApp: " << fluidParticleSys->getParticleCount() << " particles, "
+              << frameExtent.width << "x" << frameExtent.height << ", " << frameCount << " frames" << std::endl;
+    std::filesystem::create_directories(captureDirectory);
+
+    unsigned int capturedCount = 0;
+    auto startTime = std::chrono::high_resolution_clock::now();
+    for (unsigned int frame = 1; frame <= frameCount; frame++)
+    {
+        VkCommandBuffer commandBuffer = lveRenderer->beginFrame();
+        int frameIndex = lveRenderer->getFrameIndex();
+
+        {
+            LVE_STATS_SCOPE("headless/simulation_ms");
+            fluidParticleSys->updateParticleData(fixedDeltaTime);
+        }
+        writeParticleBuffer(frameIndex);
+
+        if (isCaptureFrame(frame))
+        {
+            lveRenderer->requestReadback(
+                [this, &capturedCount](const lve::OffscreenFrameManager::ReadbackImage &image)
+                {
+                    LVE_STATS_SCOPE("headless/capture_write_ms");
+                    std::string filePath = getCaptureFilePath(image.frameNumber + 1);
+                    lve::io::writeImage(filePath, image.width, image.height, image.pixels);
+                    std::cout << "Captured " << filePath << std::endl;
+                    capturedCount++;
+                });
+        }
+
+        lveRenderer->beginSwapChainRenderPass(commandBuffer);
+        {
+            LVE_GPU_ZONE(lveRenderer->getGpuProfiler(), commandBuffer, "gpu/particle_sprites_ms");
+            lve::renderInstancedQuads(
+                commandBuffer,
+                &globalDescriptorSets[frameIndex],
+                particleSpriteRenderSystem.getPipelineLayout(),
+                particleSpriteRenderSystem.getPipeline(),
+                frameExtent,
+                particleRadius,
+                0.5f,
+                fluidParticleSys->getParticleCount());
+        }
+        lveRenderer->endSwapChainRenderPass(commandBuffer);
+        lveRenderer->endFrame();
+        lveRenderer->pollReadbacks();
+    }
+    lveRenderer->waitIdle();
+
+    float totalSeconds = std::chrono::duration<float, std::chrono::seconds::period>(
+                             std::chrono::high_resolution_clock::now() - startTime)
+                             .count();
+    std::cout << "average: " << frameCount / totalSeconds << " frames/s, "
+              << totalSeconds * 1000.f / frameCount << " ms/frame, "
+              << capturedCount << " frames captured" << std::endl;
+}
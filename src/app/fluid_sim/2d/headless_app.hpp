@@ -0,0 +1,63 @@
+#pragma once
+
+#include "app/fluid_sim/2d/fluid_particle_system.hpp"
+#include "lve/core/resource/buffer.hpp"
+#include "lve/core/resource/descriptors.hpp"
+#include "lve/core/device.hpp"
+#include "lve/core/offscreen_frame_manager.hpp"
+#include "lve/core/system/render_system.hpp"
+#include "lve/util/file_io.hpp"
+
+// std
+#include <memory>
+#include <string>
+#include <vector>
+
+/*
+ * Windowless runner for the 2D fluid simulation: steps with a fixed time step, draws the particles
+ * as instanced sprites into offscreen images and dumps captured frames to disk
+ * Meant for throughput measurements and golden image tests on machines without a display, e.g.
+ * lavapipe in CI. Particle buffers are host visible and written directly, there is no input and no
+ * debug view.
+ */
+class FluidSim2DHeadlessApp
+{
+public:
+    FluidSim2DHeadlessApp();
+    ~FluidSim2DHeadlessApp();
+
+    FluidSim2DHeadlessApp(const FluidSim2DHeadlessApp &) = delete;
+    FluidSim2DHeadlessApp &operator=(const FluidSim2DHeadlessApp &) = delete;
+
+    void run();
+
+private:
+    const std::string CONFIG_FILE_PATH = "config/fluidSim2D.yaml";
+
+    lve::io::YamlConfig config{CONFIG_FILE_PATH};
+    VkExtent2D frameExtent;
+    lve::Device lveDevice{};
+    std::unique_ptr<lve::OffscreenFrameManager> lveRenderer;
+
+    unsigned int frameCount;
+    float fixedDeltaTime;
+    unsigned int captureInterval; // 0 only captures the last frame
+    std::string captureDirectory;
+    std::string captureFormat;
+    float particleRadius;
+
+    std::unique_ptr<FluidParticleSystem> fluidParticleSys;
+
+    // GPU resources, one set per frame in flight
+    std::unique_ptr<lve::DescriptorPool> globalPool{};
+    std::unique_ptr<lve::DescriptorSetLayout> globalSetLayout;
+    std::vector<VkDescriptorSet> globalDescriptorSets;
+    std::vector<std::unique_ptr<lve::Buffer>> particleBuffers;
+    std::vector<std::unique_ptr<lve::Buffer>> neighborBuffers;
+    lve::RenderSystem particleSpriteRenderSystem{lveDevice};
+
+    void createParticleBuffers();
+    void writeParticleBuffer(int frameIndex);
+    bool isCaptureFrame(unsigned int frame) const;
+    std::string getCaptureFilePath(uint64_t frameNumber) const;
+};
@@ -0,0 +1,201 @@
+#include "app/fluid_sim/2d/obstacle_sdf.hpp"
+#include "lve/go/geo/model.hpp"
+
+// std
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <map>
+#include <stdexcept>
+#include <utility>
+
+void ObstacleSdf::addPolygon(const Polygon &polygon)
+{
+    if (polygon.size() < 3)
+        throw std::runtime_error("Obstacle polygon needs at least 3 vertices");
+
+    polygons.push_back(polygon);
+    for (size_t i = 0; i < polygon.size(); i++)
+        outline.push_back({polygon[i], polygon[(i + 1) % polygon.size()]});
+}
+
+/*
+ * Add the triangles of an OBJ model projected onto the XY plane as one obstacle
+ * Only edges used by a single triangle are kept as outline, so shared inner edges do not
+ * count as boundary
+ * @param filepath: path of the OBJ file
+ * @param position: offset applied to the model in simulation space
+ * @param scale: uniform scale applied to the model before the offset
+ */
+void ObstacleSdf::addObjOutline(const std::string &filepath, glm::vec2 position, float scale)
+{
+    lve::Model::Builder builder{};
+    builder.loadModel(filepath);
+
+    // model vertices are split by normal and uv, merge them by projected position
+    std::map<std::pair<float, float>, unsigned int> uniquePositions;
+    std::vector<glm::vec2> positions;
+    std::vector<unsigned int> remappedIndices;
+    remappedIndices.reserve(builder.indices.size());
+    for (uint32_t index : builder.indices)
+    {
+        const glm::vec3 &vertexPos = builder.vertices[index].position;
+        glm::vec2 point = glm::vec2(vertexPos.x, vertexPos.y) * scale + position;
+        auto key = std::make_pair(point.x, point.y);
+        auto it = uniquePositions.find(key);
+        if (it == uniquePositions.end())
+        {
+            it = uniquePositions.emplace(key, static_cast<unsigned int>(positions.size())).first;
+            positions.push_back(point);
+        }
+        remappedIndices.push_back(it->second);
+    }
+
+    std::map<std::pair<unsigned int, unsigned int>, int> edgeUseCount;
+    for (size_t i = 0; i + 2 < remappedIndices.size(); i += 3)
+    {
+        unsigned int triangle[3] = {remappedIndices[i], remappedIndices[i + 1], remappedIndices[i + 2]};
+        polygons.push_back({positions[triangle[0]], positions[triangle[1]], positions[triangle[2]]});
+        for (int e = 0; e < 3; e++)
+        {
+            unsigned int a = triangle[e];
+            unsigned int b = triangle[(e + 1) % 3];
+            edgeUseCount[std::make_pair(std::min(a, b), std::max(a, b))]++;
+        }
+    }
+
+    for (const auto &edge : edgeUseCount)
+    {
+        if (edge.second == 1)
+            outline.push_back({positions[edge.first.first], positions[edge.first.second]});
+    }
+}
+
+/*
+ * Precompute the signed distance on a regular grid covering all obstacles
+ * @param cellSize: distance between two grid nodes
+ * @param padding: extra space around the obstacles covered by the grid
+ */
+void ObstacleSdf::bake(float cellSize, float padding)
+{
+    if (isEmpty())
+        return;
+
+    glm::vec2 minCorner{std::numeric_limits<float>::max()};
+    glm::vec2 maxCorner{std::numeric_limits<float>::lowest()};
+    for (const Segment &segment : outline)
+    {
+        minCorner = glm::min(minCorner, glm::min(segment.start, segment.end));
+        maxCorner = glm::max(maxCorner, glm::max(segment.start, segment.end));
+    }
+    minCorner -= glm::vec2(padding);
+    maxCorner += glm::vec2(padding);
+
+    this->cellSize = cellSize;
+    gridOrigin = minCorner;
+    gridSize.x = static_cast<int>(std::ceil((maxCorner.x - minCorner.x) / cellSize)) + 1;
+    gridSize.y = static_cast<int>(std::ceil((maxCorner.y - minCorner.y) / cellSize)) + 1;
+
+    distanceData.resize(gridSize.x * gridSize.y);
+    for (int y = 0; y < gridSize.y; y++)
+    {
+        for (int x = 0; x < gridSize.x; x++)
+            distanceData[y * gridSize.x + x] = signedDistance(gridOrigin + glm::vec2(x, y) * cellSize);
+    }
+}
+
+/*
+ * Bilinearly interpolated signed distance, positions outside the baked grid are at least
+ * "padding" away from every obstacle and return the max float value
+ */
+float ObstacleSdf::sample(glm::vec2 position) const
+{
+    glm::int2 cell;
+    glm::vec2 fraction;
+    if (!cellCoord(position, cell, fraction))
+        return std::numeric_limits<float>::max();
+
+    float d00 = gridValue(cell.x, cell.y);
+    float d10 = gridValue(cell.x + 1, cell.y);
+    float d01 = gridValue(cell.x, cell.y + 1);
+    float d11 = gridValue(cell.x + 1, cell.y + 1);
+    float bottom = d00 + (d10 - d00) * fraction.x;
+    float top = d01 + (d11 - d01) * fraction.x;
+    return bottom + (top - bottom) * fraction.y;
+}
+
+/*
+ * Normalized gradient of the bilinear interpolation, points away from the closest obstacle
+ */
+glm::vec2 ObstacleSdf::sampleGradient(glm::vec2 position) const
+{
+    glm::int2 cell;
+    glm::vec2 fraction;
+    if (!cellCoord(position, cell, fraction))
+        return glm::vec2(0.f, 0.f);
+
+    float d00 = gridValue(cell.x, cell.y);
+    float d10 = gridValue(cell.x + 1, cell.y);
+    float d01 = gridValue(cell.x, cell.y + 1);
+    float d11 = gridValue(cell.x + 1, cell.y + 1);
+    glm::vec2 gradient{
+        (d10 - d00) * (1.f - fraction.y) + (d11 - d01) * fraction.y,
+        (d01 - d00) * (1.f - fraction.x) + (d11 - d10) * fraction.x};
+
+    float lengthSqr = glm::dot(gradient, gradient);
+    if (lengthSqr < glm::epsilon<float>())
+        return glm::vec2(0.f, 0.f);
+    return gradient / std::sqrt(lengthSqr);
+}
+
+float ObstacleSdf::signedDistance(glm::vec2 position) const
+{
+    float minDistanceSqr = std::numeric_limits<float>::max();
+    for (const Segment &segment : outline)
+    {
+        glm::vec2 edge = segment.end - segment.start;
+        float edgeLengthSqr = glm::dot(edge, edge);
+        float t = edgeLengthSqr > 0.f ? glm::dot(position - segment.start, edge) / edgeLengthSqr : 0.f;
+        t = std::min(std::max(t, 0.f), 1.f);
+        glm::vec2 diff = position - (segment.start + edge * t);
+        minDistanceSqr = std::min(minDistanceSqr, glm::dot(diff, diff));
+    }
+
+    float distance = std::sqrt(minDistanceSqr);
+    return isInside(position) ? -distance : distance;
+}
+
+bool ObstacleSdf::isInside(glm::vec2 position) const
+{
+    for (const Polygon &polygon : polygons)
+    {
+        // crossing number test
+        bool inside = false;
+        for (size_t i = 0, j = polygon.size() - 1; i < polygon.size(); j = i++)
+        {
+            const glm::vec2 &a = polygon[i];
+            const glm::vec2 &b = polygon[j];
+            if ((a.y > position.y) != (b.y > position.y) &&
+                position.x < (b.x - a.x) * (position.y - a.y) / (b.y - a.y) + a.x)
+                inside = !inside;
+        }
+        if (inside)
+            return true;
+    }
+    return false;
+}
+
+bool ObstacleSdf::cellCoord(glm::vec2 position, glm::int2 &cell, glm::vec2 &fraction) const
+{
+    if (distanceData.empty())
+        return false;
+
+    glm::vec2 gridPos = (position - gridOrigin) / cellSize;
+    if (gridPos.x < 0.f || gridPos.y < 0.f ||
+        gridPos.x >= static_cast<float>(gridSize.x - 1) || gridPos.y >= static_cast<float>(gridSize.y - 1))
+        return false;
+
+    cell = glm::int2(static_cast<int>(gridPos.x), static_cast<int>(gridPos.y));
+    fraction = gridPos - glm::vec2(cell);
+    return true;
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+// libs
+#include "include/glm.hpp"
+
+// std
+#include <string>
+#include <vector>
+
+/*
+ * Static obstacles baked into a 2D signed distance field grid
+ * Obstacles are added as polygons (or triangles of an OBJ model) before baking, after baking
+ * the distance and its gradient are sampled bilinearly so the cost per query does not depend on
+ * obstacle complexity. Distance is negative inside obstacles.
+ */
+class ObstacleSdf
+{
+public:
+    using Polygon = std::vector<glm::vec2>;
+
+    struct Segment
+    {
+        glm::vec2 start;
+        glm::vec2 end;
+    };
+
+    void addPolygon(const Polygon &polygon);
+    void addObjOutline(const std::string &filepath, glm::vec2 position, float scale);
+    void bake(float cellSize, float padding);
+
+    bool isEmpty() const { return polygons.empty(); }
+    float sample(glm::vec2 position) const;
+    glm::vec2 sampleGradient(glm::vec2 position) const;
+    const std::vector<Segment> &getOutline() const { return outline; }
+
+private:
+    std::vector<Polygon> polygons; // solid regions, used for the inside test
+    std::vector<Segment> outline;  // boundary segments, used for the distance
+
+    float signedDistance(glm::vec2 position) const;
+    bool isInside(glm::vec2 position) const;
+    bool cellCoord(glm::vec2 position, glm::int2 &cell, glm::vec2 &fraction) const;
+    float gridValue(int x, int y) const { return distanceData[y * gridSize.x + x]; }
+
+    // baked grid, node (x, y) is at gridOrigin + (x, y) * cellSize
+    glm::vec2 gridOrigin{0.f, 0.f};
+    glm::int2 gridSize{0, 0};
+    float cellSize = 1.f;
+    std::vector<float> distanceData;
+};
@@ -0,0 +1,29 @@
+#pragma once
+
+// std
+#include <cstddef>
+#include <cstdint>
+
+/*
+ * Fields at the start of the 2D particle storage buffer, followed by positions and velocities
+ * Mirrors the std430 block Particles (binding 3) of particle_sprite.vert and
+ * screen_texture_shader.frag, both apps write it through this struct.
+ */
+struct ParticleBufferHeader
+{
+    uint32_t particleCount;
+    float smoothRadius;
+    float targetDensity;
+    float dataScale;
+    uint32_t isNeighborViewActive;
+    uint32_t isDensityViewActive;
+    uint32_t isPackedFormat;
+    float positionRangeX; // scaled window extent, packed positions are relative to it
+    float positionRangeY;
+};
+
+// std430 packs the scalars without padding and the particle data array follows at offset 36
+static_assert(offsetof(ParticleBufferHeader, smoothRadius) == 4, "particle buffer header must match the shader layout");
+static_assert(offsetof(ParticleBufferHeader, isNeighborViewActive) == 16, "particle buffer header must match the shader layout");
+static_assert(offsetof(ParticleBufferHeader, positionRangeX) == 28, "particle buffer header must match the shader layout");
+static_assert(sizeof(ParticleBufferHeader) == 36, "particle buffer header must match the shader layout");
@@ -0,0 +1,67 @@
+#include "app/fluid_sim/2d/tile_binner.hpp"
+
+// std
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+TileBinner::TileBinner(uint32_t tileSize, float particleRadius)
+    : tileSize{tileSize}, particleRadius{particleRadius}
+{
+    if (tileSize == 0)
+        throw std::runtime_error("Tile size must be greater than 0");
+}
+
+void TileBinner::setScreenExtent(uint32_t width, uint32_t height)
+{
+    tileCountX = (width + tileSize - 1) / tileSize;
+    tileCountY = (height + tileSize - 1) / tileSize;
+    tileOffsets.assign(getTileCount() + 1, 0);
+}
+
+size_t TileBinner::getMaxEntryCount(size_t particleCount) const
+{
+    size_t tilesPerAxis = static_cast<size_t>(std::ceil(2.f * particleRadius / tileSize)) + 1;
+    return particleCount * tilesPerAxis * tilesPerAxis;
+}
+
+TileBinner::TileRange TileBinner::footprintTiles(glm::vec2 pixelPos) const
+{
+    // bounding box of the footprint, clamped to the screen
+    TileRange range;
+    range.minX = std::max(static_cast<int>(std::floor((pixelPos.x - particleRadius) / tileSize)), 0);
+    range.minY = std::max(static_cast<int>(std::floor((pixelPos.y - particleRadius) / tileSize)), 0);
+    range.maxX = std::min(static_cast<int>(std::floor((pixelPos.x + particleRadius) / tileSize)), static_cast<int>(tileCountX) - 1);
+    range.maxY = std::min(static_cast<int>(std::floor((pixelPos.y + particleRadius) / tileSize)), static_cast<int>(tileCountY) - 1);
+    return range;
+}
+
+void TileBinner::bin(const std::vector<glm::vec2> &positions, float dataScale)
+{
+    std::fill(tileOffsets.begin(), tileOffsets.end(), 0);
+    particleTileRanges.resize(positions.size());
+
+    // count entries per tile, offsets are shifted by one so the prefix sum gives the start
+    for (size_t i = 0; i < positions.size(); i++)
+    {
+        TileRange range = footprintTiles(positions[i] / dataScale);
+        particleTileRanges[i] = range;
+        for (int y = range.minY; y <= range.maxY; y++)
+            for (int x = range.minX; x <= range.maxX; x++)
+                tileOffsets[y * tileCountX + x + 1]++;
+    }
+
+    for (size_t t = 1; t < tileOffsets.size(); t++)
+        tileOffsets[t] += tileOffsets[t - 1];
+
+    // scatter, particles are visited in index order so every tile list stays sorted
+    particleIndices.resize(tileOffsets.back());
+    tileCursor.assign(tileOffsets.begin(), tileOffsets.end() - 1);
+    for (size_t i = 0; i < positions.size(); i++)
+    {
+        const TileRange &range = particleTileRanges[i];
+        for (int y = range.minY; y <= range.maxY; y++)
+            for (int x = range.minX; x <= range.maxX; x++)
+                particleIndices[tileCursor[y * tileCountX + x]++] = static_cast<uint32_t>(i);
+    }
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+// libs
+#include "include/glm.hpp"
+
+// std
+#include <cstdint>
+#include <vector>
+
+/*
+ * Buckets particles into square screen tiles by their circular footprint
+ * Produces a compact index list per tile (counting sort, particle indices ascending inside a
+ * tile) so the shading pass only tests the particles overlapping its own tile. This is the CPU
+ * reference of the binning stage, it does not depend on the GPU.
+ */
+class TileBinner
+{
+public:
+    TileBinner(uint32_t tileSize, float particleRadius);
+
+    void setScreenExtent(uint32_t width, uint32_t height);
+
+    /*
+     * Rebuild the tile lists
+     * @param positions: particle positions in simulation space
+     * @param dataScale: simulation units per pixel
+     */
+    void bin(const std::vector<glm::vec2> &positions, float dataScale);
+
+    uint32_t getTileSize() const { return tileSize; }
+    float getParticleRadius() const { return particleRadius; }
+    uint32_t getTileCountX() const { return tileCountX; }
+    uint32_t getTileCountY() const { return tileCountY; }
+    uint32_t getTileCount() const { return tileCountX * tileCountY; }
+    size_t getEntryCount() const { return particleIndices.size(); }
+
+    // tile t owns particleIndices[tileOffsets[t], tileOffsets[t + 1])
+    const std::vector<uint32_t> &getTileOffsets() const { return tileOffsets; }
+    const std::vector<uint32_t> &getParticleIndices() const { return particleIndices; }
+
+    // upper bound of the entry count, used to size GPU buffers
+    size_t getMaxEntryCount(size_t particleCount) const;
+
+private:
+    uint32_t tileSize;
+    float particleRadius; // in pixels
+    uint32_t tileCountX = 0;
+    uint32_t tileCountY = 0;
+
+    struct TileRange
+    {
+        int minX, minY, maxX, maxY; // inclusive, empty when min > max
+    };
+    std::vector<TileRange> particleTileRanges;
+    std::vector<uint32_t> tileOffsets;
+    std::vector<uint32_t> particleIndices;
+    std::vector<uint32_t> tileCursor; // next write position per tile while scattering
+
+    TileRange footprintTiles(glm::vec2 pixelPos) const;
+};
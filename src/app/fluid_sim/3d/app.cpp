@@ -0,0 +1,44 @@
+#include "app/fluid_sim/3d/app.hpp"
+
+#include "lve/util/file_io.hpp"
+
+// std
+#include <chrono>
+#include <iostream>
+
+FluidSim3DApp::FluidSim3DApp()
+{
+    lve::io::YamlConfig config{CONFIG_FILE_PATH};
+    benchmarkStepCount = config.get<unsigned int>("benchmarkStepCount");
+    fixedDeltaTime = config.get<float>("fixedDeltaTime");
+}
+
+void FluidSim3DApp::run()
+{
+    std::cout << "FluidSim3DApp: " << fluidParticleSys.getParticleCount() << " particles, "
+              << benchmarkStepCount << " steps" << std::endl;
+
+    auto startTime = std::chrono::high_resolution_clock::now();
+    auto reportTime = startTime;
+    size_t pairCountSum = 0;
+    for (unsigned int step = 1; step <= benchmarkStepCount; step++)
+    {
+        fluidParticleSys.updateParticleData(fixedDeltaTime);
+        pairCountSum += fluidParticleSys.getLastPairCount();
+
+        auto now = std::chrono::high_resolution_clock::now();
+        if (std::chrono::duration<float, std::chrono::seconds::period>(now - reportTime).count() >= 1.0f)
+        {
+            float elapsedMs = std::chrono::duration<float, std::chrono::milliseconds::period>(now - startTime).count();
+            std::cout << "step " << step << ": " << elapsedMs / step << " ms/step, "
+                      << fluidParticleSys.getLastPairCount() << " pairs" << std::endl;
+            reportTime = now;
+        }
+    }
+
+    float totalMs = std::chrono::duration<float, std::chrono::milliseconds::period>(
+                        std::chrono::high_resolution_clock::now() - startTime)
+                        .count();
+    std::cout << "average: " << totalMs / benchmarkStepCount << " ms/step, "
+              << pairCountSum / benchmarkStepCount << " pairs/step" << std::endl;
+}
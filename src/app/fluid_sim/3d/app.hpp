@@ -0,0 +1,28 @@
+#pragma once
+
+#include "app/fluid_sim/3d/fluid_particle_system.hpp"
+
+// std
+#include <string>
+
+/*
+ * Headless runner for the 3D fluid particle system, steps the simulation with a fixed
+ * time step and reports the cost per step, there is no 3D particle renderer yet
+ */
+class FluidSim3DApp
+{
+public:
+    FluidSim3DApp();
+
+    FluidSim3DApp(const FluidSim3DApp &) = delete;
+    FluidSim3DApp &operator=(const FluidSim3DApp &) = delete;
+
+    void run();
+
+private:
+    const std::string CONFIG_FILE_PATH = "config/fluidSim3D.yaml";
+
+    FluidParticleSystem3D fluidParticleSys{CONFIG_FILE_PATH};
+    unsigned int benchmarkStepCount;
+    float fixedDeltaTime;
+};
@@ -0,0 +1,297 @@
+#include "app/fluid_sim/3d/fluid_particle_system.hpp"
+#include "lve/util/math.hpp"
+#include "lve/util/file_io.hpp"
+
+// std
+#include <algorithm>
+#include <cmath>
+
+FluidParticleSystem3D::FluidParticleSystem3D(const std::string &configFilePath)
+{
+    this->configFilePath = configFilePath;
+    lve::io::YamlConfig config{configFilePath};
+    particleCount = config.get<unsigned int>("particleCount");
+
+    initSimParams(config);
+
+    std::vector<float> startPoint = config.get<std::vector<float>>("startPoint");
+    std::vector<float> spawnSize = config.get<std::vector<float>>("spawnSize");
+    float stride = config.get<float>("stride");
+    bool randomize = config.get<bool>("randomize");
+
+    initParticleData(
+        glm::vec3(startPoint[0], startPoint[1], startPoint[2]),
+        stride,
+        glm::vec3(spawnSize[0], spawnSize[1], spawnSize[2]),
+        randomize);
+}
+
+void FluidParticleSystem3D::reloadConfigParam()
+{
+    lve::io::YamlConfig config{configFilePath};
+    initSimParams(config);
+}
+
+void FluidParticleSystem3D::initParticleData(glm::vec3 startPoint, float stride, glm::vec3 spawnSize, bool randomize)
+{
+    positionData.resize(particleCount);
+    nextPositionData.resize(particleCount);
+    velocityData.resize(particleCount);
+    densityData.resize(particleCount);
+    massData.resize(particleCount);
+    pressureForceData.resize(particleCount);
+    viscosityForceData.resize(particleCount);
+    gridCoordData.resize(particleCount);
+
+    spatialHash.resize(particleCount);
+
+    // fill the spawn box layer by layer, x first, then z, then y
+    int cntX = std::max(1, static_cast<int>(spawnSize.x / stride));
+    int cntZ = std::max(1, static_cast<int>(spawnSize.z / stride));
+    for (int i = 0; i < particleCount; i++)
+    {
+        int x = i % cntX;
+        int z = (i / cntX) % cntZ;
+        int y = i / (cntX * cntZ);
+
+        if (randomize)
+            positionData[i] = glm::linearRand(glm::vec3(0.f), boundsSize);
+        else
+            positionData[i] = startPoint + glm::vec3(x * stride, y * stride, z * stride);
+
+        velocityData[i] = glm::vec3(0.f);
+
+        massData[i] = 1.f;
+    }
+}
+
+void FluidParticleSystem3D::initSimParams(lve::io::YamlConfig &config)
+{
+    smoothRadius = config.get<float>("smoothRadius");
+    boundaryMultipler = config.get<float>("boundaryMultipler");
+    boundaryDamping = config.get<float>("boundaryDamping");
+    targetDensity = config.get<float>("targetDensity");
+    pressureMultiplier = config.get<float>("pressureMultiplier");
+    nearPressureMultiplier = config.get<float>("nearPressureMultiplier");
+    viscosityMultiplier = config.get<float>("viscosityMultiplier");
+    gravityAccValue = config.get<float>("gravityAccValue");
+
+    std::vector<float> bounds = config.get<std::vector<float>>("boundsSize");
+    boundsSize = glm::vec3(bounds[0], bounds[1], bounds[2]);
+
+    // init kernel constants
+    scalingFactorPoly6_3D = 315.f / (64.f * M_PI * lve::math::intPow(smoothRadius, 9));
+    scalingFactorSpikyPow3_3D = 15.f / (M_PI * lve::math::intPow(smoothRadius, 6));
+    scalingFactorSpikyPow2_3D = 15.f / (2.f * M_PI * lve::math::intPow(smoothRadius, 5));
+    scalingFactorSpikyPow3_3D_atZero = kernelSpikyPow3_3D(0.f, smoothRadius);
+    scalingFactorSpikyPow2_3D_atZero = kernelSpikyPow2_3D(0.f, smoothRadius);
+}
+
+void FluidParticleSystem3D::updateParticleData(float deltaTime)
+{
+    if (isPaused)
+    {
+        if (!pausedNextFrame)
+            return;
+        deltaTime = maxDeltaTime;
+        pausedNextFrame = false;
+    }
+
+    if (deltaTime > maxDeltaTime)
+        deltaTime = maxDeltaTime;
+
+    for (int i = 0; i < particleCount; i++) // update predicted position and spacial lookup
+    {
+        nextPositionData[i] = positionData[i] + velocityData[i] * lookAheadTime;
+        gridCoordData[i] = pos2gridCoord(nextPositionData[i], smoothRadius);
+        int hashValue = SpatialHash::hashGridCoord3D(gridCoordData[i]);
+        spatialHash.setEntry(i, spatialHash.hashKey(hashValue));
+    }
+    spatialHash.build();
+
+    calculateDensity(); // calculate density using predicted position
+    calculatePairForce();
+
+    for (int i = 0; i < particleCount; i++) // update velocity and position
+    {
+        glm::vec3 externalForce = calculateExternalForce(i);
+        glm::vec3 acceleration = (pressureForceData[i] + viscosityForceData[i] + externalForce) / densityData[i].density;
+        velocityData[i] += acceleration * deltaTime;
+        positionData[i] += velocityData[i] * deltaTime;
+    }
+}
+
+float FluidParticleSystem3D::kernelPoly6_3D(float distance, float radius) const
+{
+    if (distance >= radius)
+        return 0.f;
+    float v = radius * radius - distance * distance;
+    return scalingFactorPoly6_3D * v * v * v;
+}
+
+float FluidParticleSystem3D::kernelSpikyPow3_3D(float distance, float radius) const
+{
+    if (distance >= radius)
+        return 0.f;
+    float v = radius - distance;
+    return scalingFactorSpikyPow3_3D * v * v * v;
+}
+
+float FluidParticleSystem3D::derivativeSpikyPow3_3D(float distance, float radius) const
+{
+    if (distance >= radius)
+        return 0.f;
+    float v = radius - distance;
+    return -3.f * scalingFactorSpikyPow3_3D * v * v;
+}
+
+float FluidParticleSystem3D::kernelSpikyPow2_3D(float distance, float radius) const
+{
+    if (distance >= radius)
+        return 0.f;
+    float v = radius - distance;
+    return scalingFactorSpikyPow2_3D * v * v;
+}
+
+float FluidParticleSystem3D::derivativeSpikyPow2_3D(float distance, float radius) const
+{
+    if (distance >= radius)
+        return 0.f;
+    float v = radius - distance;
+    return -2.f * scalingFactorSpikyPow2_3D * v;
+}
+
+glm::int3 FluidParticleSystem3D::pos2gridCoord(glm::vec3 position, float gridWidth) const
+{
+    int x = static_cast<int>(std::floor(position.x / gridWidth));
+    int y = static_cast<int>(std::floor(position.y / gridWidth));
+    int z = static_cast<int>(std::floor(position.z / gridWidth));
+    return {x, y, z};
+}
+
+/*
+ * Iterate over every pair of particles closer than the smoothing radius exactly once
+ * Only the own cell and the half shell of the 27-cell neighborhood are searched, callers apply
+ * the pair contribution to both particles
+ * @param callback: function called with (i, j, distance, nextPos[j] - nextPos[i])
+ */
+template <typename Callback>
+void FluidParticleSystem3D::foreachNeighborPair(Callback &&callback)
+{
+    float smoothRadiusSqr = smoothRadius * smoothRadius;
+    size_t pairCount = 0;
+    for (unsigned int i = 0; i < particleCount; i++)
+    {
+        glm::vec3 particleNextPos = nextPositionData[i];
+        glm::int3 gridPos = gridCoordData[i];
+        for (int k = 0; k < 14; k++)
+        {
+            glm::int3 offsetGridPos = gridPos + halfShellOffset3D[k];
+            unsigned int hashKey = spatialHash.hashKey(SpatialHash::hashGridCoord3D(offsetGridPos));
+            spatialHash.foreachInBucket(
+                hashKey,
+                [&](unsigned int j)
+                {
+                    // exact cell check skips hash collisions and keeps every pair unique
+                    if (gridCoordData[j] != offsetGridPos)
+                        return;
+                    if (k == 0 && j <= i)
+                        return;
+
+                    glm::vec3 offset = nextPositionData[j] - particleNextPos;
+                    float distanceSqr = glm::dot(offset, offset);
+                    if (distanceSqr >= smoothRadiusSqr)
+                        return;
+
+                    pairCount++;
+                    callback(i, j, std::sqrt(distanceSqr), offset);
+                });
+        }
+    }
+    lastPairCount = pairCount;
+}
+
+void FluidParticleSystem3D::calculateDensity()
+{
+    for (int i = 0; i < particleCount; i++)
+    {
+        densityData[i].density = massData[i] * scalingFactorSpikyPow2_3D_atZero;
+        densityData[i].nearDensity = massData[i] * scalingFactorSpikyPow3_3D_atZero;
+    }
+
+    foreachNeighborPair(
+        [&](unsigned int i, unsigned int j, float distance, glm::vec3)
+        {
+            float influence = kernelSpikyPow2_3D(distance, smoothRadius);
+            float nearInfluence = kernelSpikyPow3_3D(distance, smoothRadius);
+            densityData[i].density += massData[j] * influence;
+            densityData[i].nearDensity += massData[j] * nearInfluence;
+            densityData[j].density += massData[i] * influence;
+            densityData[j].nearDensity += massData[i] * nearInfluence;
+        });
+}
+
+void FluidParticleSystem3D::calculatePairForce()
+{
+    std::fill(pressureForceData.begin(), pressureForceData.end(), glm::vec3(0.f));
+    std::fill(viscosityForceData.begin(), viscosityForceData.end(), glm::vec3(0.f));
+
+    foreachNeighborPair(
+        [&](unsigned int i, unsigned int j, float distance, glm::vec3 offset)
+        {
+            glm::vec3 dir; // from i to j
+            if (distance < glm::epsilon<float>())
+                dir = glm::sphericalRand(1.f);
+            else
+                dir = offset / distance;
+
+            float pressureI = pressureMultiplier * (densityData[i].density - targetDensity);
+            float pressureJ = pressureMultiplier * (densityData[j].density - targetDensity);
+            float nearPressureI = nearPressureMultiplier * densityData[i].nearDensity;
+            float nearPressureJ = nearPressureMultiplier * densityData[j].nearDensity;
+            float sharedPressure = (pressureI + pressureJ) * 0.5f;
+            float sharedNearPressure = (nearPressureI + nearPressureJ) * 0.5f;
+
+            float pressureTerm = derivativeSpikyPow2_3D(distance, smoothRadius) * sharedPressure;
+            float nearPressureTerm = derivativeSpikyPow3_3D(distance, smoothRadius) * sharedNearPressure;
+            pressureForceData[i] += (pressureTerm / densityData[j].density +
+                                     nearPressureTerm / densityData[j].nearDensity) * dir;
+            pressureForceData[j] -= (pressureTerm / densityData[i].density +
+                                     nearPressureTerm / densityData[i].nearDensity) * dir;
+
+            glm::vec3 viscosityTerm = (velocityData[j] - velocityData[i]) *
+                                      kernelPoly6_3D(distance, smoothRadius) * viscosityMultiplier;
+            viscosityForceData[i] += viscosityTerm;
+            viscosityForceData[j] -= viscosityTerm;
+        });
+}
+
+glm::vec3 FluidParticleSystem3D::calculateExternalForce(unsigned int particleIndex)
+{
+    glm::vec3 externalForce = glm::vec3(0.f);
+
+    // boundary force, push particles back to range when they are near the boundary
+    glm::vec3 particleNextPos = nextPositionData[particleIndex];
+    glm::vec3 boundaryForce = glm::vec3(0.f);
+    bool outOfBounds = false;
+    for (int axis = 0; axis < 3; axis++)
+    {
+        if (particleNextPos[axis] < boundaryMargin)
+        {
+            boundaryForce[axis] = boundaryMargin - particleNextPos[axis];
+            outOfBounds = true;
+        }
+        else if (particleNextPos[axis] > boundsSize[axis] - boundaryMargin)
+        {
+            boundaryForce[axis] = boundsSize[axis] - boundaryMargin - particleNextPos[axis];
+            outOfBounds = true;
+        }
+    }
+    if (outOfBounds) // slow down the velocity when particles are out of boundary
+        externalForce += boundaryMultipler * (boundaryForce - velocityData[particleIndex] * boundaryDamping);
+
+    // gravity
+    externalForce += glm::vec3(0.f, -gravityAccValue * densityData[particleIndex].density, 0.f);
+
+    return externalForce;
+}
@@ -0,0 +1,107 @@
+#pragma once
+
+#include "app/fluid_sim/common/spatial_hash.hpp"
+#include "lve/util/math.hpp"
+#include "lve/util/file_io.hpp"
+
+// libs
+#include "include/glm.hpp"
+
+// std
+#include <string>
+#include <vector>
+
+class FluidParticleSystem3D
+{
+public:
+    FluidParticleSystem3D(const std::string &configFilePath);
+
+    void reloadConfigParam();
+
+    void updateParticleData(float deltaTime);
+
+    unsigned int getParticleCount() const { return particleCount; }
+    float getSmoothRadius() const { return smoothRadius; }
+    float getTargetDensity() const { return targetDensity; }
+    glm::vec3 getBoundsSize() const { return boundsSize; }
+    std::vector<glm::vec3> &getPositionData() { return positionData; }
+    std::vector<glm::vec3> &getVelocityData() { return velocityData; }
+
+    // control and debug
+    void togglePause() { isPaused = !isPaused; }
+    void renderPausedNextFrame() { pausedNextFrame = true; }
+    size_t getLastPairCount() const { return lastPairCount; }
+
+private:
+    std::string configFilePath;
+    unsigned int particleCount;
+    glm::vec3 boundsSize;
+
+    // control and debug
+    bool isPaused = false;
+    bool pausedNextFrame = false;
+    size_t lastPairCount = 0;
+
+    // simulation parameters
+    float smoothRadius;
+    float boundaryMultipler;
+    float boundaryDamping;
+    float targetDensity;
+    float pressureMultiplier;
+    float nearPressureMultiplier;
+    float viscosityMultiplier;
+    float gravityAccValue;
+    float lookAheadTime = 1.0 / 120.0;
+    float maxDeltaTime = 1.0 / 120.0;
+    float boundaryMargin = 0.05;
+
+    // particle data
+    struct Density
+    {
+        float density;
+        float nearDensity;
+    };
+    std::vector<glm::vec3> positionData;
+    std::vector<glm::vec3> nextPositionData;
+    std::vector<glm::vec3> velocityData;
+    std::vector<Density> densityData;
+    std::vector<float> massData;
+    std::vector<glm::vec3> pressureForceData;
+    std::vector<glm::vec3> viscosityForceData;
+    void initParticleData(glm::vec3 startPoint, float stride, glm::vec3 spawnSize, bool randomize);
+    void initSimParams(lve::io::YamlConfig &config);
+
+    // kernels
+    float kernelPoly6_3D(float distance, float radius) const;
+    float scalingFactorPoly6_3D;
+    float kernelSpikyPow3_3D(float distance, float radius) const;
+    float derivativeSpikyPow3_3D(float distance, float radius) const;
+    float scalingFactorSpikyPow3_3D;
+    float scalingFactorSpikyPow3_3D_atZero;
+    float kernelSpikyPow2_3D(float distance, float radius) const;
+    float derivativeSpikyPow2_3D(float distance, float radius) const;
+    float scalingFactorSpikyPow2_3D;
+    float scalingFactorSpikyPow2_3D_atZero;
+
+    // update rules, pair terms are evaluated once and applied to both particles
+    void calculateDensity();
+    void calculatePairForce();
+    glm::vec3 calculateExternalForce(unsigned int particleIndex);
+
+    // hash grid
+    SpatialHash spatialHash;
+    std::vector<glm::int3> gridCoordData;
+    glm::int3 pos2gridCoord(glm::vec3 position, float gridWidth) const;
+    template <typename Callback>
+    void foreachNeighborPair(Callback &&callback);
+
+    // own cell followed by the 13 cells of the upper half of the 27-cell neighborhood,
+    // every pair of adjacent cells is covered by exactly one of these offsets
+    const glm::int3 halfShellOffset3D[14] = {
+        {0, 0, 0},
+        {1, 0, 0},
+        {-1, 1, 0}, {0, 1, 0}, {1, 1, 0},
+        {-1, -1, 1}, {0, -1, 1}, {1, -1, 1},
+        {-1, 0, 1}, {0, 0, 1}, {1, 0, 1},
+        {-1, 1, 1}, {0, 1, 1}, {1, 1, 1}};
+};
@@ -0,0 +1,44 @@
+#include "app/fluid_sim/common/spatial_hash.hpp"
+
+// std
+#include <algorithm>
+
+void SpatialHash::resize(unsigned int particleCount)
+{
+    tableSize = particleCount;
+    spacialLookup.resize(particleCount);
+    spacialLookupEntry.resize(particleCount);
+}
+
+void SpatialHash::build()
+{
+    std::sort(
+        spacialLookup.begin(),
+        spacialLookup.end(),
+        [](const Entry &a, const Entry &b)
+        {
+            return a.spatialHashKey < b.spatialHashKey;
+        });
+
+    // init spacial lookup entry
+    std::fill(spacialLookupEntry.begin(), spacialLookupEntry.end(), -1);
+    for (unsigned int i = 0; i < tableSize; i++)
+    {
+        unsigned int key = spacialLookup[i].spatialHashKey;
+        unsigned int keyPrev = (i == 0) ? -1 : spacialLookup[i - 1].spatialHashKey;
+        if (key != keyPrev)
+            spacialLookupEntry[key] = i;
+    }
+}
+
+int SpatialHash::hashGridCoord2D(glm::int2 gridCoord)
+{
+    return static_cast<uint32_t>(gridCoord.x) * 15823 + static_cast<uint32_t>(gridCoord.y) * 9737333;
+}
+
+int SpatialHash::hashGridCoord3D(glm::int3 gridCoord)
+{
+    return static_cast<uint32_t>(gridCoord.x) * 15823 +
+           static_cast<uint32_t>(gridCoord.y) * 9737333 +
+           static_cast<uint32_t>(gridCoord.z) * 440817757;
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include "lve/util/math.hpp"
+
+// libs
+#include "include/glm.hpp"
+
+// std
+#include <vector>
+
+/*
+ * Spatial hash grid shared by the 2D and 3D fluid particle systems.
+ * Particles are bucketed by the hash key of their grid cell, sorted by key, and the first
+ * sorted index of every key is stored so a bucket can be visited without searching.
+ */
+class SpatialHash
+{
+public:
+    struct Entry
+    {
+        unsigned int particleIndex;
+        unsigned int spatialHashKey;
+    };
+
+    void resize(unsigned int particleCount);
+
+    unsigned int hashKey(int hashValue) const { return lve::math::positiveMod(hashValue, tableSize); }
+    void setEntry(unsigned int particleIndex, unsigned int spatialHashKey) { spacialLookup[particleIndex] = {particleIndex, spatialHashKey}; }
+    void build(); // sort entries and init lookup entry table, call after all entries are set
+
+    static int hashGridCoord2D(glm::int2 gridCoord);
+    static int hashGridCoord3D(glm::int3 gridCoord);
+
+    /*
+     * Iterate over all particles whose hash key equals the given key
+     * @param key: hash key of the bucket
+     * @param callback: function to be called with the index of each particle in the bucket
+     */
+    template <typename Callback>
+    void foreachInBucket(unsigned int key, Callback &&callback) const
+    {
+        int startIndex = spacialLookupEntry[key];
+        if (startIndex == -1) // no particle in this bucket
+            return;
+
+        for (unsigned int j = startIndex; j < tableSize; j++)
+        {
+            if (spacialLookup[j].spatialHashKey != key)
+                break;
+            callback(spacialLookup[j].particleIndex);
+        }
+    }
+
+private:
+    unsigned int tableSize = 0;
+    std::vector<Entry> spacialLookup;
+    std::vector<int> spacialLookupEntry;
+};
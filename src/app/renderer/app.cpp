@@ -7,6 +7,7 @@
 #include "lve/core/resource/sampler_manager.hpp"
 #include "lve/core/system/render_system.hpp"
 #include "lve/core/system/compute_system.hpp"
+#include "lve/core/upload_context.hpp"
 
 // libs
 #include "include/glm.hpp"
@@ -30,34 +31,22 @@ RendererApp::RendererApp()
 {
     globalPool =
         lve::DescriptorPool::Builder(lveDevice)
-            .setMaxSets(lve::SwapChain::MAX_FRAMES_IN_FLIGHT)
-            .addPoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, lve::SwapChain::MAX_FRAMES_IN_FLIGHT)
+            .setMaxSets(1)
+            .addPoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 1)
             .build();
     loadGameObjects();
 }
 
 void RendererApp::run()
 {
-    uboBuffers.resize(lve::SwapChain::MAX_FRAMES_IN_FLIGHT);
-    globalDescriptorSets.resize(lve::SwapChain::MAX_FRAMES_IN_FLIGHT);
-
-    for (int i = 0; i < uboBuffers.size(); i++)
-    {
-        uboBuffers[i] = std::make_unique<lve::Buffer>(
-            lveDevice,
-            sizeof(GlobalUbo),
-            1,
-            VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
-            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT);
-        uboBuffers[i]->map();
-    }
+    frameAllocator = std::make_unique<lve::FrameAllocator>(lveDevice, sizeof(GlobalUbo), VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT);
 
     globalSetLayout =
         lve::DescriptorSetLayout::Builder(lveDevice)
-            .addBinding(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_ALL_GRAPHICS)
+            .addBinding(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, VK_SHADER_STAGE_ALL_GRAPHICS)
             .build();
 
-    updateGlobalDescriptorSets();
+    updateGlobalDescriptorSet();
 
     lve::GraphicPipelineConfigInfo graphicPipelineConfigInfo{};
     graphicPipelineConfigInfo.vertFilepath = "simple_shader.vert.spv";
@@ -95,23 +84,23 @@ void RendererApp::run()
 
         if (auto commandBuffer = lveRenderer.beginFrame())
         {
-            int frameIndex = lveRenderer.getFrameIndex();
+            frameAllocator->beginFrame(lveRenderer.getFrameIndex());
 
             // update
             GlobalUbo ubo{};
             ubo.projectionView = camera.getProjection() * camera.getView();
-            uboBuffers[frameIndex]->writeToBuffer(&ubo);
-            uboBuffers[frameIndex]->flush();
+            uint32_t uboOffset = frameAllocator->write(&ubo, sizeof(GlobalUbo)).dynamicOffset();
 
             // render
             lveRenderer.beginSwapChainRenderPass(commandBuffer);
 
             renderGameObjects(
                 commandBuffer,
-                &globalDescriptorSets[frameIndex],
+                &globalDescriptorSet,
                 gameObjects,
                 simpleRenderSystem.getPipelineLayout(),
-                simpleRenderSystem.getPipeline());
+                simpleRenderSystem.getPipeline(),
+                {uboOffset});
 
             lveRenderer.endSwapChainRenderPass(commandBuffer);
             lveRenderer.endFrame();
@@ -125,39 +114,41 @@ void RendererApp::loadGameObjects()
 {
     lve::io::YamlConfig generalConfig{"config/general.yaml"};
     std::string modelRoot = generalConfig.get<std::string>("modelRoot") + "/";
+    lve::UploadBatch uploadBatch;
 
     std::shared_ptr<lve::Model> lveModel =
-        lve::Model::createModelFromFile(lveDevice, modelRoot + "flat_vase.obj");
+        lve::Model::createModelFromFile(lveDevice, modelRoot + "flat_vase.obj", &uploadBatch);
     auto flatVase = lve::GameObject::createGameObject();
     flatVase.model = lveModel;
     flatVase.transform.translation = {-.5f, .5f, 0.f};
     flatVase.transform.scale = {3.f, 1.5f, 3.f};
     gameObjects.emplace(flatVase.getId(), std::move(flatVase));
 
-    lveModel = lve::Model::createModelFromFile(lveDevice, modelRoot + "smooth_vase.obj");
+    lveModel = lve::Model::createModelFromFile(lveDevice, modelRoot + "smooth_vase.obj", &uploadBatch);
     auto smoothVase = lve::GameObject::createGameObject();
     smoothVase.model = lveModel;
     smoothVase.transform.translation = {.5f, .5f, 0.f};
     smoothVase.transform.scale = {3.f, 1.5f, 3.f};
     gameObjects.emplace(smoothVase.getId(), std::move(smoothVase));
 
-    lveModel = lve::Model::createModelFromFile(lveDevice, modelRoot + "quad.obj");
+    lveModel = lve::Model::createModelFromFile(lveDevice, modelRoot + "quad.obj", &uploadBatch);
     auto floor = lve::GameObject::createGameObject();
     floor.model = lveModel;
     floor.transform.translation = {0.f, .5f, 0.f};
     floor.transform.scale = {3.f, 1.f, 3.f};
     gameObjects.emplace(floor.getId(), std::move(floor));
+
+    // the new models' buffers are copied on the transfer queue while the first frames are recorded
+    lveDevice.getUploadContext().submitTransfer(uploadBatch);
 }
 
-void RendererApp::updateGlobalDescriptorSets()
+// a single set for all frames, each frame selects its ubo with a dynamic offset
+void RendererApp::updateGlobalDescriptorSet()
 {
-    for (int i = 0; i < globalDescriptorSets.size(); i++)
-    {
-        auto uboBufferInfo = uboBuffers[i]->descriptorInfo();
-        lve::DescriptorWriter writer{*globalSetLayout, *globalPool};
-        writer.writeBuffer(0, &uboBufferInfo);
+    auto uboBufferInfo = frameAllocator->descriptorInfo(sizeof(GlobalUbo));
+    lve::DescriptorWriter writer{*globalSetLayout, *globalPool};
+    writer.writeBuffer(0, &uboBufferInfo);
 
-        writer.allocateDescriptorSet(globalDescriptorSets[i]);
-        writer.overwrite(globalDescriptorSets[i]);
-    }
+    writer.allocateDescriptorSet(globalDescriptorSet);
+    writer.overwrite(globalDescriptorSet);
 }
\ No newline at end of file
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "lve/core/resource/descriptors.hpp"
+#include "lve/core/resource/frame_allocator.hpp"
 #include "lve/core/resource/image.hpp"
 #include "lve/core/device.hpp"
 #include "lve/core/frame_manager.hpp"
@@ -33,10 +34,10 @@ private:
 
     // note: order of declarations matters because of destruction order
     std::unique_ptr<lve::DescriptorPool> globalPool{};
-    std::vector<std::unique_ptr<lve::Buffer>> uboBuffers;
+    std::unique_ptr<lve::FrameAllocator> frameAllocator;
     std::unique_ptr<lve::DescriptorSetLayout> globalSetLayout;
-    std::vector<VkDescriptorSet> globalDescriptorSets;
+    VkDescriptorSet globalDescriptorSet;
     lve::GameObject::Map gameObjects;
 
-    void updateGlobalDescriptorSets();
+    void updateGlobalDescriptorSet();
 };
\ No newline at end of file
@@ -0,0 +1,94 @@
+#include "lve/core/compute_queue.hpp"
+#include "lve/util/trace.hpp"
+
+// std
+#include <stdexcept>
+#include <string>
+
+namespace lve
+{
+    ComputeQueue::ComputeQueue(Device &device)
+        : lveDevice{device}, timeline{device.computeTimeline()}
+    {
+        QueueFamilyIndices queueFamilyIndices = lveDevice.findPhysicalQueueFamilies();
+        queueFamily = queueFamilyIndices.computeFamily;
+        graphicsFamily = queueFamilyIndices.graphicsFamily;
+
+        createCommandBuffers(lveDevice.getFramesInFlight());
+    }
+
+    ComputeQueue::~ComputeQueue()
+    {
+        waitIdle();
+        // frees the command buffers
+        vkDestroyCommandPool(lveDevice.device(), commandPool, nullptr);
+    }
+
+    void ComputeQueue::createCommandBuffers(int frameCount)
+    {
+        VkCommandPoolCreateInfo poolInfo{};
+        poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+        poolInfo.queueFamilyIndex = queueFamily;
+        poolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+
+        if (vkCreateCommandPool(lveDevice.device(), &poolInfo, nullptr, &commandPool) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to create compute command pool!");
+        }
+
+        commandBuffers.resize(frameCount);
+        frameValues.assign(frameCount, 0);
+
+        VkCommandBufferAllocateInfo allocInfo{};
+        allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+        allocInfo.commandPool = commandPool;
+        allocInfo.commandBufferCount = static_cast<uint32_t>(commandBuffers.size());
+
+        if (vkAllocateCommandBuffers(lveDevice.device(), &allocInfo, commandBuffers.data()) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to allocate compute command buffers!");
+        }
+    }
+
+    VkCommandBuffer ComputeQueue::beginFrame(int frameIndex)
+    {
+        if (frameIndex < 0 || frameIndex >= static_cast<int>(commandBuffers.size()))
+            throw std::runtime_error("ComputeQueue frame index out of range: " + std::to_string(frameIndex));
+
+        LVE_TRACE_ZONE("ComputeQueue::beginFrame");
+        timeline.wait(frameValues[frameIndex]);
+        currentFrameIndex = frameIndex;
+
+        VkCommandBuffer commandBuffer = commandBuffers[frameIndex];
+        vkResetCommandBuffer(commandBuffer, 0);
+
+        VkCommandBufferBeginInfo beginInfo{};
+        beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+        if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to begin recording compute command buffer!");
+        }
+        return commandBuffer;
+    }
+
+    uint64_t ComputeQueue::submit()
+    {
+        if (currentFrameIndex < 0)
+            throw std::runtime_error("ComputeQueue::beginFrame must be called before submit");
+
+        LVE_TRACE_ZONE("ComputeQueue::submit");
+        VkCommandBuffer commandBuffer = commandBuffers[currentFrameIndex];
+        if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to record compute command buffer!");
+        }
+
+        uint64_t signalValue = timeline.submit({commandBuffer});
+        submittedValue = signalValue;
+        frameValues[currentFrameIndex] = signalValue;
+        currentFrameIndex = -1;
+        return signalValue;
+    }
+} // namespace lve
@@ -0,0 +1,61 @@
+#pragma once
+
+#include "lve/core/device.hpp"
+#include "lve/core/queue_timeline.hpp"
+
+// libs
+#include <vulkan/vulkan.h>
+
+// std
+#include <cstdint>
+#include <vector>
+
+namespace lve
+{
+    /*
+     * Submission path for compute work outside of the frame's graphics command buffer
+     * Every frame slot has its own command buffer on the device's compute queue, and every submit
+     * signals the next value of the queue's timeline (Device::computeTimeline). A graphics frame that reads the results waits
+     * on that value (FrameManager::addWaitSemaphore), so compute for the next frame overlaps the
+     * graphics work of the frame in flight on a dedicated compute family. Without one, the
+     * submissions go to the graphics queue and share its timeline.
+     * Resources written here and read by graphics must either be created with concurrent sharing
+     * between getQueueFamily() and the graphics family, or have their ownership transferred.
+     */
+    class ComputeQueue
+    {
+    public:
+        ComputeQueue(Device &device);
+        ~ComputeQueue();
+
+        ComputeQueue(const ComputeQueue &) = delete;
+        ComputeQueue &operator=(const ComputeQueue &) = delete;
+
+        // waits for the slot's previous submission, then begins recording its command buffer
+        VkCommandBuffer beginFrame(int frameIndex);
+        // submit the command buffer of beginFrame, returns the timeline value signaled on completion
+        uint64_t submit();
+
+        // whether the work runs next to the graphics queue instead of on it
+        bool isAsync() const { return queueFamily != graphicsFamily; }
+        uint32_t getQueueFamily() const { return queueFamily; }
+        VkSemaphore getTimelineSemaphore() const { return timeline.getSemaphore(); }
+        uint64_t getSubmittedValue() const { return submittedValue; }
+        uint64_t getCompletedValue() { return timeline.getCompletedValue(); }
+        void waitIdle() { timeline.wait(submittedValue); }
+
+    private:
+        void createCommandBuffers(int frameCount);
+
+        Device &lveDevice;
+        uint32_t queueFamily;
+        uint32_t graphicsFamily;
+        VkCommandPool commandPool = VK_NULL_HANDLE;
+        std::vector<VkCommandBuffer> commandBuffers;
+        std::vector<uint64_t> frameValues; // value signaled by the last submission of each slot
+
+        QueueTimeline &timeline;
+        uint64_t submittedValue = 0; // of this queue's submissions, the timeline may be shared
+        int currentFrameIndex = -1;
+    };
+} // namespace lve
@@ -0,0 +1,92 @@
+#include "lve/core/deletion_queue.hpp"
+#include "lve/util/stats.hpp"
+#include "lve/util/trace.hpp"
+
+namespace lve
+{
+    DeletionQueue::DeletionQueue(Device &device)
+        : timelines{&device.graphicsTimeline(), &device.computeTimeline(), &device.transferTimeline()}
+    {
+    }
+
+    DeletionQueue::~DeletionQueue()
+    {
+        // deleters may push again, e.g. a swap chain releasing its depth images
+        while (size() > 0)
+        {
+            std::deque<Deletion> remaining;
+            {
+                std::lock_guard<std::mutex> lock{mutex};
+                remaining.swap(deletions);
+            }
+            run(remaining);
+        }
+    }
+
+    void DeletionQueue::push(std::function<void()> deleter)
+    {
+        Deletion deletion{};
+        for (size_t i = 0; i < timelines.size(); i++)
+            deletion.timelineValues[i] = timelines[i]->getSubmittedValue();
+        deletion.deleter = std::move(deleter);
+
+        std::lock_guard<std::mutex> lock{mutex};
+        deletions.push_back(std::move(deletion));
+    }
+
+    void DeletionQueue::collect()
+    {
+        std::array<uint64_t, 3> completedValues;
+        for (size_t i = 0; i < timelines.size(); i++)
+            completedValues[i] = timelines[i]->getCompletedValue();
+
+        // the deleters run without the lock, they may push themselves
+        std::deque<Deletion> completed;
+        {
+            std::lock_guard<std::mutex> lock{mutex};
+            LVE_STATS_RECORD("render/deferred_deletions", deletions.size());
+            while (!deletions.empty())
+            {
+                const Deletion &deletion = deletions.front();
+                bool isComplete = true;
+                for (size_t i = 0; i < timelines.size(); i++)
+                    isComplete = isComplete && deletion.timelineValues[i] <= completedValues[i];
+                if (!isComplete)
+                    break;
+
+                completed.push_back(std::move(deletions.front()));
+                deletions.pop_front();
+            }
+        }
+        run(completed);
+    }
+
+    void DeletionQueue::flush()
+    {
+        LVE_TRACE_ZONE("DeletionQueue::flush");
+        std::deque<Deletion> pending;
+        {
+            std::lock_guard<std::mutex> lock{mutex};
+            pending.swap(deletions);
+        }
+        if (!pending.empty())
+        {
+            for (size_t i = 0; i < timelines.size(); i++)
+                timelines[i]->wait(pending.back().timelineValues[i]);
+        }
+        run(pending);
+    }
+
+    size_t DeletionQueue::size()
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        return deletions.size();
+    }
+
+    void DeletionQueue::run(std::deque<Deletion> &batch)
+    {
+        for (Deletion &deletion : batch)
+            deletion.deleter();
+        batch.clear();
+    }
+} // namespace lve
@@ -0,0 +1,55 @@
+#pragma once
+
+#include "lve/core/device.hpp"
+#include "lve/core/queue_timeline.hpp"
+
+// std
+#include <array>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+
+namespace lve
+{
+    /*
+     * Defers the destruction of Vulkan objects until the GPU has passed every submission that may
+     * still use them
+     * push() stores the deleter with the submitted value of each queue timeline, and collect() runs
+     * the deleters whose values have all completed. The destructors of buffers, images, pipelines
+     * and pipeline layouts go through it, so resources can be replaced (e.g. on a window resize)
+     * while frames using the old ones are in flight, without waiting for the device to be idle.
+     * Only submissions made before push() are covered: an object referenced by a frame that is
+     * still being recorded has to be released after the frame was submitted.
+     */
+    class DeletionQueue
+    {
+    public:
+        DeletionQueue(Device &device);
+        ~DeletionQueue(); // runs the remaining deleters, the device must be idle
+
+        DeletionQueue(const DeletionQueue &) = delete;
+        DeletionQueue &operator=(const DeletionQueue &) = delete;
+
+        void push(std::function<void()> deleter);
+        // run the deleters whose submissions have completed, the frame managers call it every frame
+        void collect();
+        // wait for the submissions of all pushed deleters and run them
+        void flush();
+
+        size_t size();
+
+    private:
+        struct Deletion
+        {
+            std::array<uint64_t, 3> timelineValues; // per entry of timelines
+            std::function<void()> deleter;
+        };
+
+        void run(std::deque<Deletion> &batch);
+
+        std::array<QueueTimeline *, 3> timelines; // graphics, compute and transfer, may repeat
+        std::mutex mutex;
+        std::deque<Deletion> deletions; // in push order, so the values never decrease
+    };
+} // namespace lve
@@ -1,6 +1,11 @@
 #include "lve/core/device.hpp"
+#include "lve/core/deletion_queue.hpp"
+#include "lve/core/pipeline/pipeline_cache.hpp"
+#include "lve/core/upload_context.hpp"
 
 // std
+#include <algorithm>
+#include <cstdlib>
 #include <cstring>
 #include <iostream>
 #include <set>
@@ -55,18 +60,46 @@ namespace lve
     }
 
     // class member functions
-    Device::Device(Window &window) : window{window}
+    Device::Device(Window &window) : window{&window}
     {
+        readFramesInFlight();
         createInstance();
         setupDebugMessenger();
         createSurface();
         pickPhysicalDevice();
         createLogicalDevice();
+        createQueueTimelines();
         createCommandPool();
+        createMemoryAllocator();
+        createDeletionQueue();
+        createUploadContext();
+        createPipelineCache();
+    }
+
+    Device::Device()
+    {
+        readFramesInFlight();
+        createInstance();
+        setupDebugMessenger();
+        pickPhysicalDevice();
+        createLogicalDevice();
+        createQueueTimelines();
+        createCommandPool();
+        createMemoryAllocator();
+        createDeletionQueue();
+        createUploadContext();
+        createPipelineCache();
     }
 
     Device::~Device()
     {
+        // staging memory of batches recorded into frames is only released once the GPU is done
+        vkDeviceWaitIdle(device_);
+        uploadContext.reset();
+        deletionQueue.reset(); // after the upload context, its staging buffers are deleted through it
+        memoryAllocator.reset();
+        pipelineCache.reset(); // written to disk while the device is alive
+        queueTimelines.clear();
         vkDestroyCommandPool(device_, commandPool, nullptr);
         vkDestroyDevice(device_, nullptr);
 
@@ -75,7 +108,10 @@ namespace lve
             DestroyDebugUtilsMessengerEXT(instance, debugMessenger, nullptr);
         }
 
-        vkDestroySurfaceKHR(instance, surface_, nullptr);
+        if (!isHeadless())
+        {
+            vkDestroySurfaceKHR(instance, surface_, nullptr);
+        }
         vkDestroyInstance(instance, nullptr);
     }
 
@@ -92,7 +128,7 @@ namespace lve
         appInfo.applicationVersion = VK_MAKE_VERSION(1, 0, 0);
         appInfo.pEngineName = "No Engine";
         appInfo.engineVersion = VK_MAKE_VERSION(1, 0, 0);
-        appInfo.apiVersion = VK_API_VERSION_1_0;
+        appInfo.apiVersion = VK_API_VERSION_1_2;
 
         VkInstanceCreateInfo createInfo = {};
         createInfo.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
@@ -151,7 +187,6 @@ namespace lve
             throw std::runtime_error("failed to find a suitable GPU!");
         }
 
-        VkPhysicalDeviceProperties properties;
         vkGetPhysicalDeviceProperties(physicalDevice, &properties);
         std::cout << "physical device: " << properties.deviceName << std::endl;
     }
@@ -160,32 +195,68 @@ namespace lve
     {
         QueueFamilyIndices indices = findQueueFamilies(physicalDevice);
 
+        uint32_t queueFamilyCount = 0;
+        vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueFamilyCount, nullptr);
+        std::vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
+        vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueFamilyCount, queueFamilies.data());
+
+        // async compute gets a second queue when it shares its family with the transfer queue
+        uint32_t computeQueueIndex = 0;
+        if (indices.hasDedicatedComputeFamily() && indices.computeFamily == indices.transferFamily &&
+            queueFamilies[indices.computeFamily].queueCount > 1)
+        {
+            computeQueueIndex = 1;
+        }
+
         std::vector<VkDeviceQueueCreateInfo> queueCreateInfos;
-        std::set<uint32_t> uniqueQueueFamilies = {indices.graphicsFamily, indices.presentFamily};
+        std::set<uint32_t> uniqueQueueFamilies = {
+            indices.graphicsFamily, indices.presentFamily, indices.transferFamily, indices.computeFamily};
 
-        float queuePriority = 1.0f;
+        float queuePriorities[] = {1.0f, 1.0f};
         for (uint32_t queueFamily : uniqueQueueFamilies)
         {
             VkDeviceQueueCreateInfo queueCreateInfo = {};
             queueCreateInfo.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
             queueCreateInfo.queueFamilyIndex = queueFamily;
-            queueCreateInfo.queueCount = 1;
-            queueCreateInfo.pQueuePriorities = &queuePriority;
+            queueCreateInfo.queueCount = queueFamily == indices.computeFamily ? computeQueueIndex + 1 : 1;
+            queueCreateInfo.pQueuePriorities = queuePriorities;
             queueCreateInfos.push_back(queueCreateInfo);
         }
 
         VkPhysicalDeviceFeatures deviceFeatures = {};
         deviceFeatures.samplerAnisotropy = VK_TRUE;
 
+        // the GPU profiler resets its timestamp queries from the host, so they can be written on any queue
+        VkPhysicalDeviceHostQueryResetFeatures hostQueryResetFeatures = {};
+        hostQueryResetFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_HOST_QUERY_RESET_FEATURES;
+        VkPhysicalDeviceFeatures2 supportedFeatures2 = {};
+        supportedFeatures2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+        supportedFeatures2.pNext = &hostQueryResetFeatures;
+        vkGetPhysicalDeviceFeatures2(physicalDevice, &supportedFeatures2);
+        if (hostQueryResetFeatures.hostQueryReset && properties.limits.timestampPeriod > 0)
+        {
+            timestampValidBits = std::min(
+                queueFamilies[indices.graphicsFamily].timestampValidBits,
+                queueFamilies[indices.computeFamily].timestampValidBits);
+        }
+
+        // compute and frame submissions are ordered by timeline semaphores
+        VkPhysicalDeviceTimelineSemaphoreFeatures timelineSemaphoreFeatures = {};
+        timelineSemaphoreFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES;
+        timelineSemaphoreFeatures.timelineSemaphore = VK_TRUE;
+        timelineSemaphoreFeatures.pNext = &hostQueryResetFeatures;
+
         VkDeviceCreateInfo createInfo = {};
         createInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+        createInfo.pNext = &timelineSemaphoreFeatures;
 
         createInfo.queueCreateInfoCount = static_cast<uint32_t>(queueCreateInfos.size());
         createInfo.pQueueCreateInfos = queueCreateInfos.data();
 
         createInfo.pEnabledFeatures = &deviceFeatures;
-        createInfo.enabledExtensionCount = static_cast<uint32_t>(deviceExtensions.size());
-        createInfo.ppEnabledExtensionNames = deviceExtensions.data();
+        std::vector<const char *> requiredDeviceExtensions = getRequiredDeviceExtensions();
+        createInfo.enabledExtensionCount = static_cast<uint32_t>(requiredDeviceExtensions.size());
+        createInfo.ppEnabledExtensionNames = requiredDeviceExtensions.data();
 
         // might not really be necessary anymore because device specific validation layers
         // have been deprecated
@@ -206,6 +277,44 @@ namespace lve
 
         vkGetDeviceQueue(device_, indices.graphicsFamily, 0, &graphicsQueue_);
         vkGetDeviceQueue(device_, indices.presentFamily, 0, &presentQueue_);
+        vkGetDeviceQueue(device_, indices.transferFamily, 0, &transferQueue_);
+        if (indices.hasDedicatedTransferFamily())
+            std::cout << "Dedicated transfer queue family: " << indices.transferFamily << std::endl;
+        vkGetDeviceQueue(device_, indices.computeFamily, computeQueueIndex, &computeQueue_);
+        if (indices.hasDedicatedComputeFamily())
+            std::cout << "Async compute queue family: " << indices.computeFamily << std::endl;
+    }
+
+    void Device::readFramesInFlight()
+    {
+        const char *value = std::getenv("LVE_FRAMES_IN_FLIGHT");
+        if (value == nullptr)
+            return;
+
+        framesInFlight = std::atoi(value);
+        if (framesInFlight < 1 || framesInFlight > MAX_FRAMES_IN_FLIGHT)
+        {
+            throw std::runtime_error(
+                "LVE_FRAMES_IN_FLIGHT must be between 1 and " + std::to_string(MAX_FRAMES_IN_FLIGHT) + ", got " + value);
+        }
+        std::cout << "Frames in flight: " << framesInFlight << std::endl;
+    }
+
+    void Device::createQueueTimelines()
+    {
+        auto getTimeline = [this](VkQueue queue)
+        {
+            for (auto &timeline : queueTimelines)
+            {
+                if (timeline->getQueue() == queue)
+                    return timeline.get();
+            }
+            queueTimelines.push_back(std::make_unique<QueueTimeline>(device_, queue));
+            return queueTimelines.back().get();
+        };
+        graphicsTimeline_ = getTimeline(graphicsQueue_);
+        computeTimeline_ = getTimeline(computeQueue_);
+        transferTimeline_ = getTimeline(transferQueue_);
     }
 
     void Device::createCommandPool()
@@ -224,7 +333,7 @@ namespace lve
         }
     }
 
-    void Device::createSurface() { window.createWindowSurface(instance, &surface_); }
+    void Device::createSurface() { window->createWindowSurface(instance, &surface_); }
 
     bool Device::isDeviceSuitable(VkPhysicalDevice device)
     {
@@ -232,8 +341,8 @@ namespace lve
 
         bool extensionsSupported = checkDeviceExtensionSupport(device);
 
-        bool swapChainAdequate = false;
-        if (extensionsSupported)
+        bool swapChainAdequate = isHeadless(); // nothing is presented without a surface
+        if (extensionsSupported && !isHeadless())
         {
             SwapChainSupportDetails swapChainSupport = querySwapChainSupport(device);
             swapChainAdequate = !swapChainSupport.formats.empty() && !swapChainSupport.presentModes.empty();
@@ -242,8 +351,22 @@ namespace lve
         VkPhysicalDeviceFeatures supportedFeatures;
         vkGetPhysicalDeviceFeatures(device, &supportedFeatures);
 
+        VkPhysicalDeviceProperties deviceProperties;
+        vkGetPhysicalDeviceProperties(device, &deviceProperties);
+        bool timelineSemaphoreSupported = false;
+        if (deviceProperties.apiVersion >= VK_API_VERSION_1_2)
+        {
+            VkPhysicalDeviceTimelineSemaphoreFeatures timelineSemaphoreFeatures = {};
+            timelineSemaphoreFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES;
+            VkPhysicalDeviceFeatures2 features2 = {};
+            features2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+            features2.pNext = &timelineSemaphoreFeatures;
+            vkGetPhysicalDeviceFeatures2(device, &features2);
+            timelineSemaphoreSupported = timelineSemaphoreFeatures.timelineSemaphore;
+        }
+
         return indices.isComplete() && extensionsSupported && swapChainAdequate &&
-               supportedFeatures.samplerAnisotropy;
+               supportedFeatures.samplerAnisotropy && timelineSemaphoreSupported;
     }
 
     void Device::populateDebugMessengerCreateInfo(VkDebugUtilsMessengerCreateInfoEXT &createInfo)
@@ -303,11 +426,14 @@ namespace lve
 
     std::vector<const char *> Device::getRequiredExtensions()
     {
-        uint32_t glfwExtensionCount = 0;
-        const char **glfwExtensions;
-        glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
-
-        std::vector<const char *> extensions(glfwExtensions, glfwExtensions + glfwExtensionCount);
+        std::vector<const char *> extensions;
+        if (!isHeadless())
+        {
+            uint32_t glfwExtensionCount = 0;
+            const char **glfwExtensions;
+            glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
+            extensions.assign(glfwExtensions, glfwExtensions + glfwExtensionCount);
+        }
 
         if (enableDebugLayers)
         {
@@ -356,7 +482,8 @@ namespace lve
             &extensionCount,
             availableExtensions.data());
 
-        std::set<std::string> requiredExtensions(deviceExtensions.begin(), deviceExtensions.end());
+        std::vector<const char *> requiredDeviceExtensions = getRequiredDeviceExtensions();
+        std::set<std::string> requiredExtensions(requiredDeviceExtensions.begin(), requiredDeviceExtensions.end());
 
         for (const auto &extension : availableExtensions)
         {
@@ -366,6 +493,13 @@ namespace lve
         return requiredExtensions.empty();
     }
 
+    std::vector<const char *> Device::getRequiredDeviceExtensions() const
+    {
+        if (isHeadless())
+            return {};
+        return deviceExtensions;
+    }
+
     QueueFamilyIndices Device::findQueueFamilies(VkPhysicalDevice device)
     {
         QueueFamilyIndices indices;
@@ -385,7 +519,10 @@ namespace lve
                 indices.graphicsFamilyHasValue = true;
             }
             VkBool32 presentSupport = false;
-            vkGetPhysicalDeviceSurfaceSupportKHR(device, i, surface_, &presentSupport);
+            if (isHeadless())
+                presentSupport = (queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT) != 0; // the present queue is just an alias
+            else
+                vkGetPhysicalDeviceSurfaceSupportKHR(device, i, surface_, &presentSupport);
             if (queueFamily.queueCount > 0 && presentSupport)
             {
                 indices.presentFamily = i;
@@ -399,6 +536,43 @@ namespace lve
             i++;
         }
 
+        /*
+         * Prefer a family that only does transfers (the DMA engine), then any transfer family
+         * without graphics. Setting LVE_NO_TRANSFER_QUEUE keeps all copies on the graphics queue,
+         * e.g. to compare both paths on the same GPU.
+         */
+        indices.transferFamily = indices.graphicsFamily;
+        if (indices.graphicsFamilyHasValue && std::getenv("LVE_NO_TRANSFER_QUEUE") == nullptr)
+        {
+            bool foundTransferOnly = false;
+            for (uint32_t family = 0; family < queueFamilyCount && !foundTransferOnly; family++)
+            {
+                VkQueueFlags flags = queueFamilies[family].queueFlags;
+                if (queueFamilies[family].queueCount == 0 || (flags & VK_QUEUE_TRANSFER_BIT) == 0 || (flags & VK_QUEUE_GRAPHICS_BIT) != 0)
+                    continue;
+                foundTransferOnly = (flags & VK_QUEUE_COMPUTE_BIT) == 0;
+                if (foundTransferOnly || !indices.hasDedicatedTransferFamily())
+                    indices.transferFamily = family;
+            }
+        }
+
+        /*
+         * Async compute runs on a compute family without graphics, preferably another one than
+         * the transfer family. Setting LVE_NO_ASYNC_COMPUTE keeps compute on the graphics queue.
+         */
+        indices.computeFamily = indices.graphicsFamily;
+        if (indices.graphicsFamilyHasValue && std::getenv("LVE_NO_ASYNC_COMPUTE") == nullptr)
+        {
+            for (uint32_t family = 0; family < queueFamilyCount; family++)
+            {
+                VkQueueFlags flags = queueFamilies[family].queueFlags;
+                if (queueFamilies[family].queueCount == 0 || (flags & VK_QUEUE_COMPUTE_BIT) == 0 || (flags & VK_QUEUE_GRAPHICS_BIT) != 0)
+                    continue;
+                if (!indices.hasDedicatedComputeFamily() || indices.computeFamily == indices.transferFamily)
+                    indices.computeFamily = family;
+            }
+        }
+
         return indices;
     }
 
@@ -452,6 +626,19 @@ namespace lve
         throw std::runtime_error("failed to find supported format!");
     }
 
+    // every heap is device local on integrated GPUs, host visible memory is then as fast for the GPU as any other
+    bool Device::hasUnifiedMemory()
+    {
+        VkPhysicalDeviceMemoryProperties memProperties;
+        vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memProperties);
+        for (uint32_t i = 0; i < memProperties.memoryHeapCount; i++)
+        {
+            if (!(memProperties.memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT))
+                return false;
+        }
+        return true;
+    }
+
     uint32_t Device::findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties)
     {
         VkPhysicalDeviceMemoryProperties memProperties;
@@ -468,6 +655,29 @@ namespace lve
         throw std::runtime_error("failed to find suitable memory type!");
     }
 
+    void Device::createMemoryAllocator()
+    {
+        VkPhysicalDeviceMemoryProperties memProperties;
+        vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memProperties);
+        memoryBackend = std::make_unique<VulkanMemoryBackend>(device_, memProperties, properties.limits.nonCoherentAtomSize);
+        memoryAllocator = std::make_unique<MemoryAllocator>(*memoryBackend, properties.limits.bufferImageGranularity);
+    }
+
+    void Device::createUploadContext() { uploadContext = std::make_unique<UploadContext>(*this); }
+
+    void Device::createDeletionQueue() { deletionQueue = std::make_unique<DeletionQueue>(*this); }
+
+    void Device::createPipelineCache() { pipelineCache = std::make_unique<PipelineCache>(device_, properties); }
+
+    MemoryAllocation Device::allocateMemory(
+        const VkMemoryRequirements &requirements, VkMemoryPropertyFlags properties, MemoryResourceKind kind)
+    {
+        uint32_t memoryTypeIndex = findMemoryType(requirements.memoryTypeBits, properties);
+        return memoryAllocator->allocate(memoryTypeIndex, requirements.size, requirements.alignment, kind);
+    }
+
+    void Device::freeMemory(MemoryAllocation &allocation) { memoryAllocator->free(allocation); }
+
     VkCommandBuffer Device::beginSingleTimeCommands()
     {
         VkCommandBufferAllocateInfo allocInfo{};
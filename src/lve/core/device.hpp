@@ -1,13 +1,20 @@
 #pragma once
 
+#include "lve/core/queue_timeline.hpp"
+#include "lve/core/resource/memory_allocator.hpp"
+#include "lve/core/resource/vulkan_memory_backend.hpp"
 #include "lve/core/window.hpp"
 
 // std
+#include <memory>
 #include <string>
 #include <vector>
 
 namespace lve
 {
+    class DeletionQueue;
+    class PipelineCache;
+    class UploadContext;
 
     struct SwapChainSupportDetails
     {
@@ -20,14 +27,21 @@ namespace lve
     {
         uint32_t graphicsFamily;
         uint32_t presentFamily;
+        uint32_t transferFamily; // the graphics family unless a family without graphics supports transfers
+        uint32_t computeFamily;  // the graphics family unless a family without graphics supports compute
         bool graphicsFamilyHasValue = false;
         bool presentFamilyHasValue = false;
         bool isComplete() { return graphicsFamilyHasValue && presentFamilyHasValue; }
+        bool hasDedicatedTransferFamily() const { return transferFamily != graphicsFamily; }
+        bool hasDedicatedComputeFamily() const { return computeFamily != graphicsFamily; }
     };
 
     class Device
     {
     public:
+        static constexpr int DEFAULT_FRAMES_IN_FLIGHT = 2;
+        static constexpr int MAX_FRAMES_IN_FLIGHT = 4;
+
 #ifdef NDEBUG
         const bool enableDebugLayers = false;
 #else
@@ -35,6 +49,7 @@ namespace lve
 #endif
 
         Device(Window &window);
+        Device(); // headless, no surface or swap chain, see OffscreenFrameManager
         ~Device();
 
         // Not copyable or movable
@@ -48,16 +63,58 @@ namespace lve
         VkSurfaceKHR surface() { return surface_; }
         VkQueue graphicsQueue() { return graphicsQueue_; }
         VkQueue presentQueue() { return presentQueue_; }
+        // DMA queue running copies next to rendering, the graphics queue when there is none
+        VkQueue transferQueue() { return transferQueue_; }
+        bool hasDedicatedTransferQueue() const { return transferQueue_ != graphicsQueue_; }
+        // async compute queue running next to the graphics queue, the graphics queue when there is none
+        VkQueue computeQueue() { return computeQueue_; }
+        bool hasDedicatedComputeQueue() const { return computeQueue_ != graphicsQueue_; }
+        bool isHeadless() const { return window == nullptr; }
+
+        // every submission through a queue's timeline signals its next value, queues sharing a VkQueue share the timeline
+        QueueTimeline &graphicsTimeline() { return *graphicsTimeline_; }
+        QueueTimeline &computeTimeline() { return *computeTimeline_; }
+        QueueTimeline &transferTimeline() { return *transferTimeline_; }
+
+        /*
+         * Number of frames recorded while earlier ones are still executing, and so the number of
+         * copies of per frame resources
+         * Set per deployment by the LVE_FRAMES_IN_FLIGHT environment variable (1 to
+         * MAX_FRAMES_IN_FLIGHT): fewer frames lower the input latency, more keep the GPU busy when
+         * frame times vary.
+         */
+        int getFramesInFlight() const { return framesInFlight; }
+
+        // timestamp queries on the graphics and compute queues with host query reset, see GpuProfiler
+        bool supportsGpuTimestamps() const { return timestampValidBits > 0; }
+        uint32_t getTimestampValidBits() const { return timestampValidBits; } // of both queues
 
         SwapChainSupportDetails getSwapChainSupport() { return querySwapChainSupport(physicalDevice); }
         uint32_t findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties);
+        bool hasUnifiedMemory();
         QueueFamilyIndices findPhysicalQueueFamilies() { return findQueueFamilies(physicalDevice); }
         VkFormat findSupportedFormat(
             const std::vector<VkFormat> &candidates, VkImageTiling tiling, VkFormatFeatureFlags features);
 
+        // sub-allocated from the pooled blocks of the memory type matching requirements and properties
+        MemoryAllocation allocateMemory(
+            const VkMemoryRequirements &requirements, VkMemoryPropertyFlags properties, MemoryResourceKind kind);
+        void freeMemory(MemoryAllocation &allocation);
+        MemoryAllocator &getMemoryAllocator() { return *memoryAllocator; }
+
+        // batches uploads and layout transitions into the next frame or an own submission
+        UploadContext &getUploadContext() { return *uploadContext; }
+        // destroys objects once the submissions that may use them have completed
+        DeletionQueue &getDeletionQueue() { return *deletionQueue; }
+        // passed to every pipeline creation, persisted across runs
+        PipelineCache &getPipelineCache() { return *pipelineCache; }
+
+        // blocking, waits for the graphics queue to go idle
         VkCommandBuffer beginSingleTimeCommands();
         void endSingleTimeCommands(VkCommandBuffer commandBuffer);
 
+        VkPhysicalDeviceProperties properties;
+
     private:
         void createInstance();
         void setupDebugMessenger();
@@ -65,6 +122,12 @@ namespace lve
         void pickPhysicalDevice();
         void createLogicalDevice();
         void createCommandPool();
+        void createMemoryAllocator();
+        void createUploadContext();
+        void createDeletionQueue();
+        void createPipelineCache();
+        void createQueueTimelines();
+        void readFramesInFlight();
 
         // helper functions
         bool isDeviceSuitable(VkPhysicalDevice device);
@@ -79,16 +142,31 @@ namespace lve
         VkInstance instance;
         VkDebugUtilsMessengerEXT debugMessenger;
         VkPhysicalDevice physicalDevice = VK_NULL_HANDLE;
-        Window &window;
+        Window *window = nullptr;
         VkCommandPool commandPool;
 
         VkDevice device_;
         VkSurfaceKHR surface_;
         VkQueue graphicsQueue_;
         VkQueue presentQueue_;
+        VkQueue transferQueue_;
+        VkQueue computeQueue_;
+        std::vector<std::unique_ptr<QueueTimeline>> queueTimelines; // one per distinct queue
+        QueueTimeline *graphicsTimeline_;
+        QueueTimeline *computeTimeline_;
+        QueueTimeline *transferTimeline_;
+        int framesInFlight = DEFAULT_FRAMES_IN_FLIGHT;
+        uint32_t timestampValidBits = 0;
+
+        std::unique_ptr<VulkanMemoryBackend> memoryBackend;
+        std::unique_ptr<MemoryAllocator> memoryAllocator;
+        std::unique_ptr<UploadContext> uploadContext;
+        std::unique_ptr<DeletionQueue> deletionQueue;
+        std::unique_ptr<PipelineCache> pipelineCache;
 
         const std::vector<const char *> debugLayers = {"VK_LAYER_KHRONOS_validation"}; // add VK_LAYER_LUNARG_monitor to show frame rate
         const std::vector<const char *> deviceExtensions = {VK_KHR_SWAPCHAIN_EXTENSION_NAME};
+        std::vector<const char *> getRequiredDeviceExtensions() const;
     };
 
 } // namespace lve
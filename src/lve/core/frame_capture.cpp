@@ -0,0 +1,279 @@
+#include "lve/core/frame_capture.hpp"
+#include "lve/util/image_io.hpp"
+#include "lve/util/stats.hpp"
+#include "lve/util/trace.hpp"
+
+// std
+#include <cassert>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+
+namespace lve
+{
+    FrameCapture::FrameCapture(Device &device, const FrameCaptureConfigInfo &configInfo)
+        : lveDevice{device}, configInfo{configInfo}, encoderPool{configInfo.encoderThreadCount}
+    {
+        if (configInfo.slotCount == 0)
+            throw std::runtime_error("Frame capture needs at least one slot");
+
+        std::filesystem::create_directories(configInfo.outputDirectory);
+        slots.resize(configInfo.slotCount);
+    }
+
+    FrameCapture::~FrameCapture()
+    {
+        // encoding errors are only reported by finish, a destructor must not throw
+        try
+        {
+            finish();
+        }
+        catch (const std::exception &)
+        {
+        }
+    }
+
+    bool FrameCapture::recordCapture(VkCommandBuffer commandBuffer, VkImage image, VkImageLayout imageLayout, VkFormat format, VkExtent2D extent)
+    {
+        assert(recordedSlot == nullptr && "Previous capture was not submitted");
+        LVE_TRACE_ZONE("FrameCapture::recordCapture");
+        uint64_t frameNumber = requestedFrameCount++;
+
+        bool isBgra;
+        if (format == VK_FORMAT_R8G8B8A8_UNORM || format == VK_FORMAT_R8G8B8A8_SRGB)
+            isBgra = false;
+        else if (format == VK_FORMAT_B8G8R8A8_UNORM || format == VK_FORMAT_B8G8R8A8_SRGB)
+            isBgra = true;
+        else
+            throw std::runtime_error("Frame capture only supports 8 bit RGBA and BGRA images");
+
+        Slot *slot = acquireSlot();
+        if (slot == nullptr)
+        {
+            droppedFrameCount++;
+            LVE_STATS_RECORD("capture/dropped_frames", droppedFrameCount);
+            return false;
+        }
+
+        // the slot is free, so its buffer can be replaced when the extent changed
+        VkDeviceSize imageSize = static_cast<VkDeviceSize>(extent.width) * extent.height * 4;
+        if (!slot->readbackBuffer || slot->readbackBuffer->getBufferSize() != imageSize)
+        {
+            slot->readbackBuffer = std::make_unique<Buffer>(
+                lveDevice,
+                sizeof(uint32_t), // one 8 bit RGBA texel
+                extent.width * extent.height,
+                VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT);
+            slot->readbackBuffer->map();
+        }
+        slot->extent = extent;
+        slot->isBgra = isBgra;
+        slot->frameNumber = frameNumber;
+
+        /*
+         * The image barrier only changes the layout when it isn't a transfer source yet
+         * Its transfer source stage chains it after the render pass's dependency into
+         * VK_SUBPASS_EXTERNAL, which orders the pass's final layout transition before the copy.
+         */
+        VkImageMemoryBarrier imageBarrier{};
+        imageBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        imageBarrier.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+        imageBarrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+        imageBarrier.oldLayout = imageLayout;
+        imageBarrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+        imageBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        imageBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        imageBarrier.image = image;
+        imageBarrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        imageBarrier.subresourceRange.baseMipLevel = 0;
+        imageBarrier.subresourceRange.levelCount = 1;
+        imageBarrier.subresourceRange.baseArrayLayer = 0;
+        imageBarrier.subresourceRange.layerCount = 1;
+        vkCmdPipelineBarrier(
+            commandBuffer,
+            VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT,
+            VK_PIPELINE_STAGE_TRANSFER_BIT,
+            0,
+            0, nullptr,
+            0, nullptr,
+            1, &imageBarrier);
+
+        VkBufferImageCopy region{};
+        region.bufferOffset = 0;
+        region.bufferRowLength = 0; // tightly packed
+        region.bufferImageHeight = 0;
+        region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        region.imageSubresource.mipLevel = 0;
+        region.imageSubresource.baseArrayLayer = 0;
+        region.imageSubresource.layerCount = 1;
+        region.imageOffset = {0, 0, 0};
+        region.imageExtent = {extent.width, extent.height, 1};
+        vkCmdCopyImageToBuffer(
+            commandBuffer,
+            image,
+            VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+            slot->readbackBuffer->getBuffer(),
+            1,
+            &region);
+
+        if (imageLayout != VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL)
+        {
+            imageBarrier.srcAccessMask = 0; // reads need no availability
+            imageBarrier.dstAccessMask = 0;
+            imageBarrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+            imageBarrier.newLayout = imageLayout;
+            vkCmdPipelineBarrier(
+                commandBuffer,
+                VK_PIPELINE_STAGE_TRANSFER_BIT,
+                VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+                0,
+                0, nullptr,
+                0, nullptr,
+                1, &imageBarrier);
+        }
+
+        VkBufferMemoryBarrier bufferBarrier{};
+        bufferBarrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+        bufferBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        bufferBarrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+        bufferBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        bufferBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        bufferBarrier.buffer = slot->readbackBuffer->getBuffer();
+        bufferBarrier.offset = 0;
+        bufferBarrier.size = VK_WHOLE_SIZE;
+        vkCmdPipelineBarrier(
+            commandBuffer,
+            VK_PIPELINE_STAGE_TRANSFER_BIT,
+            VK_PIPELINE_STAGE_HOST_BIT,
+            0,
+            0, nullptr,
+            1, &bufferBarrier,
+            0, nullptr);
+
+        slot->state = SlotState::RECORDED;
+        recordedSlot = slot;
+        return true;
+    }
+
+    // values complete in submission order, so the latest graphics value covers the frame holding the copy
+    void FrameCapture::submit()
+    {
+        if (recordedSlot == nullptr)
+            return;
+
+        recordedSlot->frameValue = lveDevice.graphicsTimeline().getSubmittedValue();
+        recordedSlot->state = SlotState::IN_FLIGHT;
+        recordedSlot = nullptr;
+    }
+
+    void FrameCapture::poll()
+    {
+        for (Slot &slot : slots)
+        {
+            if (slot.state == SlotState::IN_FLIGHT && lveDevice.graphicsTimeline().isComplete(slot.frameValue))
+                startEncoding(slot);
+            if (slot.state == SlotState::ENCODING &&
+                slot.encodeTask.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+                finishEncoding(slot);
+        }
+    }
+
+    void FrameCapture::finish()
+    {
+        assert(recordedSlot == nullptr && "Cannot finish with a recorded but unsubmitted capture");
+        for (Slot &slot : slots)
+            waitForSlot(slot);
+    }
+
+    FrameCapture::Slot *FrameCapture::acquireSlot()
+    {
+        poll();
+        for (Slot &slot : slots)
+        {
+            if (slot.state == SlotState::FREE)
+                return &slot;
+        }
+
+        if (configInfo.overflowPolicy == CaptureOverflowPolicy::DROP)
+            return nullptr;
+
+        // every slot is in flight or encoding, the oldest one finishes first
+        Slot *oldestSlot = &slots[0];
+        for (Slot &slot : slots)
+        {
+            if (slot.frameNumber < oldestSlot->frameNumber)
+                oldestSlot = &slot;
+        }
+        LVE_TRACE_ZONE("FrameCapture wait for slot");
+        waitForSlot(*oldestSlot);
+        return oldestSlot;
+    }
+
+    void FrameCapture::waitForSlot(Slot &slot)
+    {
+        if (slot.state == SlotState::IN_FLIGHT)
+        {
+            lveDevice.graphicsTimeline().wait(slot.frameValue);
+            startEncoding(slot);
+        }
+        if (slot.state == SlotState::ENCODING)
+            finishEncoding(slot);
+    }
+
+    // the frame has completed, the encoder reads the mapped buffer directly and the slot stays busy until it is done
+    void FrameCapture::startEncoding(Slot &slot)
+    {
+        slot.readbackBuffer->invalidate(); // no-op on coherent memory
+        slot.state = SlotState::ENCODING;
+
+        std::string filePath = getFilePath(slot.frameNumber);
+        CaptureEncoding encoding = configInfo.encoding;
+        const uint8_t *pixels = static_cast<const uint8_t *>(slot.readbackBuffer->getMappedMemory());
+        VkExtent2D extent = slot.extent;
+        bool isBgra = slot.isBgra;
+        slot.encodeTask = encoderPool.submit(
+            [filePath, encoding, pixels, extent, isBgra]()
+            {
+                LVE_STATS_SCOPE("capture/encode_ms");
+                LVE_TRACE_ZONE("FrameCapture encode");
+                std::vector<uint8_t> rgbaPixels;
+                const uint8_t *encoderInput = pixels;
+                if (isBgra)
+                {
+                    rgbaPixels.resize(static_cast<size_t>(extent.width) * extent.height * 4);
+                    for (size_t i = 0; i < rgbaPixels.size(); i += 4)
+                    {
+                        rgbaPixels[i + 0] = pixels[i + 2];
+                        rgbaPixels[i + 1] = pixels[i + 1];
+                        rgbaPixels[i + 2] = pixels[i + 0];
+                        rgbaPixels[i + 3] = pixels[i + 3];
+                    }
+                    encoderInput = rgbaPixels.data();
+                }
+
+                if (encoding == CaptureEncoding::PNG)
+                    io::writePng(filePath, extent.width, extent.height, encoderInput);
+                else
+                    io::writeYuv420(filePath, extent.width, extent.height, encoderInput);
+            });
+    }
+
+    void FrameCapture::finishEncoding(Slot &slot)
+    {
+        slot.state = SlotState::FREE;
+        slot.encodeTask.get(); // rethrows encoder errors on the render thread
+        capturedFrameCount++;
+    }
+
+    std::string FrameCapture::getFilePath(uint64_t frameNumber) const
+    {
+        std::ostringstream filePath;
+        filePath << configInfo.outputDirectory << "/frame_" << std::setw(6) << std::setfill('0') << frameNumber
+                 << (configInfo.encoding == CaptureEncoding::PNG ? ".png" : ".yuv");
+        return filePath.str();
+    }
+} // namespace lve
@@ -0,0 +1,111 @@
+#pragma once
+
+#include "lve/core/device.hpp"
+#include "lve/core/resource/buffer.hpp"
+#include "lve/util/thread_pool.hpp"
+
+// std
+#include <future>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace lve
+{
+    enum class CaptureEncoding
+    {
+        PNG,
+        YUV420 // raw I420, one file per frame
+    };
+
+    enum class CaptureOverflowPolicy
+    {
+        DROP, // skip frames while every slot is busy, the render thread never waits
+        QUEUE // wait for the oldest slot, no frame is lost
+    };
+
+    struct FrameCaptureConfigInfo
+    {
+        std::string outputDirectory = "capture";
+        CaptureEncoding encoding = CaptureEncoding::PNG;
+        CaptureOverflowPolicy overflowPolicy = CaptureOverflowPolicy::DROP;
+        uint32_t slotCount = 4;          // host readback buffers, each holds one frame until it is encoded
+        size_t encoderThreadCount = 2;
+    };
+
+    /*
+     * Captures rendered frames to an image sequence on disk
+     * The copy of the frame image into a free host visible slot is recorded into the frame's own
+     * command buffer, and the slot keeps the frame's graphics timeline value. Finished slots are
+     * handed to encoder threads from poll, so neither the GPU copy nor the encoding stalls the
+     * render thread; when every slot is busy the overflow policy decides between dropping and
+     * waiting. Files are numbered by capture request, dropped frames leave gaps.
+     */
+    class FrameCapture
+    {
+    public:
+        FrameCapture(Device &device, const FrameCaptureConfigInfo &configInfo);
+        ~FrameCapture();
+
+        FrameCapture(const FrameCapture &) = delete;
+        FrameCapture &operator=(const FrameCapture &) = delete;
+
+        /*
+         * Record the copy of image into a free slot, call after the render pass that wrote it
+         * The render pass needs a dependency into VK_SUBPASS_EXTERNAL with the transfer stage and
+         * TRANSFER_READ access as destination, see SwapChain::createRenderPass.
+         * @param imageLayout: layout the image is in, it is restored after the copy
+         * @param format: 8 bit RGBA or BGRA
+         * @return false if the frame was dropped
+         */
+        bool recordCapture(VkCommandBuffer commandBuffer, VkImage image, VkImageLayout imageLayout, VkFormat format, VkExtent2D extent);
+
+        // call once the frame holding the recorded copy was submitted to the graphics queue
+        void submit();
+
+        // hand finished copies to the encoders and free encoded slots, never blocks
+        void poll();
+
+        // wait for every copy and encoding in flight
+        void finish();
+
+        uint64_t getCapturedFrameCount() const { return capturedFrameCount; }
+        uint64_t getDroppedFrameCount() const { return droppedFrameCount; }
+
+    private:
+        enum class SlotState
+        {
+            FREE,
+            RECORDED,  // copy recorded, not submitted yet
+            IN_FLIGHT, // copy submitted, frame value not completed yet
+            ENCODING
+        };
+
+        struct Slot
+        {
+            SlotState state = SlotState::FREE;
+            std::unique_ptr<Buffer> readbackBuffer;
+            uint64_t frameValue = 0; // graphics timeline value the copy has completed at
+            VkExtent2D extent{0, 0};
+            bool isBgra = false;
+            uint64_t frameNumber = 0;
+            std::future<void> encodeTask;
+        };
+
+        Slot *acquireSlot();
+        void waitForSlot(Slot &slot);
+        void startEncoding(Slot &slot);
+        void finishEncoding(Slot &slot);
+        std::string getFilePath(uint64_t frameNumber) const;
+
+        Device &lveDevice;
+        FrameCaptureConfigInfo configInfo;
+        std::vector<Slot> slots;
+        Slot *recordedSlot = nullptr;
+        ThreadPool encoderPool;
+
+        uint64_t requestedFrameCount = 0;
+        uint64_t capturedFrameCount = 0;
+        uint64_t droppedFrameCount = 0;
+    };
+} // namespace lve
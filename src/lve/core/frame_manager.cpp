@@ -1,4 +1,7 @@
 #include "lve/core/frame_manager.hpp"
+#include "lve/core/deletion_queue.hpp"
+#include "lve/core/upload_context.hpp"
+#include "lve/util/trace.hpp"
 
 // std
 #include <array>
@@ -16,12 +19,17 @@ namespace lve
     {
         recreateSwapChain();
         createCommandBuffers();
+#ifdef LVE_ENABLE_STATS
+        if (lveDevice.supportsGpuTimestamps())
+            gpuProfiler = std::make_unique<GpuProfiler>(lveDevice);
+#endif
     }
 
     FrameManager::~FrameManager() { freeCommandBuffers(); }
 
     bool FrameManager::recreateSwapChain()
     {
+        LVE_TRACE_ZONE("FrameManager::recreateSwapChain");
         if (lveWindow.isWindowMinimized())
         {
             std::unique_lock<std::mutex> renderLock(lveWindow.renderMutex);
@@ -32,8 +40,6 @@ namespace lve
         VkExtent2D windowExtent = lveWindow.getExtent();
         VkExtent2D swapChainExtent = lveSwapChain == nullptr ? VkExtent2D{0, 0} : lveSwapChain->getSwapChainExtent();
 
-        vkDeviceWaitIdle(lveDevice.device());
-
         if (lveSwapChain == nullptr)
         {
             lveSwapChain = std::make_unique<SwapChain>(lveDevice, windowExtent);
@@ -48,6 +54,9 @@ namespace lve
             {
                 throw std::runtime_error("Swap chain image(or depth) format has changed!");
             }
+
+            // destroyed once the frames presenting its images have completed, instead of waiting for them here
+            lveDevice.getDeletionQueue().push([oldSwapChain]() {});
         }
 
         return true;
@@ -55,7 +64,7 @@ namespace lve
 
     void FrameManager::createCommandBuffers()
     {
-        commandBuffers.resize(SwapChain::MAX_FRAMES_IN_FLIGHT);
+        commandBuffers.resize(lveDevice.getFramesInFlight());
 
         VkCommandBufferAllocateInfo allocInfo{};
         allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
@@ -83,6 +92,7 @@ namespace lve
     VkCommandBuffer FrameManager::beginFrame()
     {
         assert(!isFrameStarted && "Can't call beginFrame while already in progress");
+        LVE_TRACE_ZONE("FrameManager::beginFrame");
 
         auto result = lveSwapChain->acquireNextImage(&currentImageIndex);
         if (result == VK_ERROR_OUT_OF_DATE_KHR)
@@ -97,6 +107,8 @@ namespace lve
         }
 
         isFrameStarted = true;
+        lveDevice.getUploadContext().beginFrame(currentFrameIndex); // the slot's previous frame has completed
+        lveDevice.getDeletionQueue().collect();
 
         auto commandBuffer = getCurrentCommandBuffer();
         VkCommandBufferBeginInfo beginInfo{};
@@ -106,19 +118,27 @@ namespace lve
         {
             throw std::runtime_error("failed to begin recording command buffer!");
         }
+        LVE_STATS_ONLY(beginGpuFrame(commandBuffer));
+
+        // uploads queued since the last frame, e.g. by resource creation
+        lveDevice.getUploadContext().record(commandBuffer);
         return commandBuffer;
     }
 
     void FrameManager::endFrame()
     {
         assert(isFrameStarted && "Can't call endFrame while frame is not in progress");
+        LVE_TRACE_ZONE("FrameManager::endFrame");
         auto commandBuffer = getCurrentCommandBuffer();
+        LVE_STATS_ONLY(endGpuFrame(commandBuffer));
         if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS)
         {
             throw std::runtime_error("failed to record command buffer!");
         }
 
-        auto result = lveSwapChain->submitCommandBuffers(&commandBuffer, &currentImageIndex);
+        lveDevice.getUploadContext().takeWaitSemaphores(frameWaitSemaphores);
+        auto result = lveSwapChain->submitCommandBuffers(&commandBuffer, &currentImageIndex, frameWaitSemaphores);
+        frameWaitSemaphores.clear();
 
         if (
             result == VK_ERROR_OUT_OF_DATE_KHR || // The swap chain has become incompatible with
@@ -147,7 +167,28 @@ namespace lve
         }
 
         isFrameStarted = false;
-        currentFrameIndex = (currentFrameIndex + 1) % SwapChain::MAX_FRAMES_IN_FLIGHT;
+        currentFrameIndex = (currentFrameIndex + 1) % lveDevice.getFramesInFlight();
+    }
+
+    // GPU time of the frame's command buffer, after the zones of the slot's previous frame are recorded
+    void FrameManager::beginGpuFrame(VkCommandBuffer commandBuffer)
+    {
+        if (gpuProfiler == nullptr)
+            return;
+        gpuProfiler->beginFrame(currentFrameIndex);
+        gpuFrameZone = gpuProfiler->beginZone(commandBuffer, "gpu/frame_ms");
+    }
+
+    void FrameManager::endGpuFrame(VkCommandBuffer commandBuffer)
+    {
+        if (gpuProfiler != nullptr)
+            gpuProfiler->endZone(commandBuffer, gpuFrameZone);
+    }
+
+    void FrameManager::addWaitSemaphore(VkSemaphore semaphore, VkPipelineStageFlags waitStage, uint64_t value)
+    {
+        assert(isFrameStarted && "Can't add a wait semaphore while frame is not in progress");
+        frameWaitSemaphores.push_back({semaphore, value, waitStage});
     }
 
     void FrameManager::beginSwapChainRenderPass(VkCommandBuffer commandBuffer)
@@ -157,6 +198,9 @@ namespace lve
             commandBuffer == getCurrentCommandBuffer() &&
             "Can't begin render pass on command buffer from a different frame");
 
+        // uploads queued during this frame, copies are not allowed inside the render pass
+        lveDevice.getUploadContext().record(commandBuffer);
+
         VkRenderPassBeginInfo renderPassInfo{};
         renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
         renderPassInfo.renderPass = lveSwapChain->getRenderPass();
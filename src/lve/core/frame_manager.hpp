@@ -1,6 +1,8 @@
 #pragma once
 
 #include "lve/core/device.hpp"
+#include "lve/core/gpu_profiler.hpp"
+#include "lve/core/queue_timeline.hpp"
 #include "lve/core/swap_chain.hpp"
 #include "lve/core/window.hpp"
 
@@ -24,6 +26,9 @@ namespace lve
 
         VkRenderPass getSwapChainRenderPass() const { return lveSwapChain->getRenderPass(); }
         float getAspectRatio() const { return lveSwapChain->extentAspectRatio(); }
+        VkExtent2D getExtent() const { return lveSwapChain->getSwapChainExtent(); }
+        VkFormat getImageFormat() const { return lveSwapChain->getSwapChainImageFormat(); }
+        bool supportsImageCopy() const { return lveSwapChain->supportsImageCopy(); }
         bool isFrameInProgress() const { return isFrameStarted; }
 
         VkCommandBuffer getCurrentCommandBuffer() const
@@ -38,11 +43,24 @@ namespace lve
             return currentFrameIndex;
         }
 
+        // swap chain image the frame in progress renders to, in PRESENT_SRC_KHR layout after the render pass
+        VkImage getCurrentImage() const
+        {
+            assert(isFrameStarted && "Cannot get swap chain image when frame not in progress");
+            return lveSwapChain->getSwapChainImage(currentImageIndex);
+        }
+
         VkCommandBuffer beginFrame();
         void endFrame();
         void beginSwapChainRenderPass(VkCommandBuffer commandBuffer);
         void endSwapChainRenderPass(VkCommandBuffer commandBuffer);
 
+        // the submission of the frame in progress waits on semaphore, value is the one of a timeline semaphore
+        void addWaitSemaphore(VkSemaphore semaphore, VkPipelineStageFlags waitStage, uint64_t value = 0);
+
+        // null unless stats are enabled and the device supports timestamps, for LVE_GPU_ZONE
+        GpuProfiler *getGpuProfiler() const { return gpuProfiler.get(); }
+
         using SwapChainResizedCallback = std::function<void(VkExtent2D)>;
         void registerSwapChainResizedCallback(const std::string &name, SwapChainResizedCallback callback) { swapChainResizedCallbacks[name] = callback; }
         void unregisterSwapChainResizedCallback(const std::string &name) { swapChainResizedCallbacks.erase(name); }
@@ -51,6 +69,8 @@ namespace lve
         void createCommandBuffers();
         void freeCommandBuffers();
         bool recreateSwapChain();
+        void beginGpuFrame(VkCommandBuffer commandBuffer);
+        void endGpuFrame(VkCommandBuffer commandBuffer);
 
         Window &lveWindow;
         Device &lveDevice;
@@ -61,6 +81,11 @@ namespace lve
         int currentFrameIndex{0};
         bool isFrameStarted{false};
 
+        std::vector<SemaphoreSubmit> frameWaitSemaphores; // waits of the frame in progress
+
+        std::unique_ptr<GpuProfiler> gpuProfiler;
+        int gpuFrameZone = -1; // the whole command buffer of the frame in progress
+
         std::unordered_map<std::string, SwapChainResizedCallback> swapChainResizedCallbacks;
     };
 } // namespace lve
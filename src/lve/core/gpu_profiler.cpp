@@ -0,0 +1,107 @@
+#include "lve/core/gpu_profiler.hpp"
+#include "lve/core/deletion_queue.hpp"
+
+// std
+#include <stdexcept>
+#include <string>
+
+namespace lve
+{
+    GpuProfiler::GpuProfiler(Device &device)
+        : lveDevice{device}
+    {
+        if (!lveDevice.supportsGpuTimestamps())
+            throw std::runtime_error("GpuProfiler needs timestamp queries with host query reset");
+
+        // durations are differences of timestamps from the same queue, wrapped to the valid bits
+        uint32_t validBits = lveDevice.getTimestampValidBits();
+        timestampMask = validBits >= 64 ? ~uint64_t{0} : (uint64_t{1} << validBits) - 1;
+        timestampPeriod = lveDevice.properties.limits.timestampPeriod;
+
+        int frameCount = lveDevice.getFramesInFlight();
+        frameZones.resize(frameCount);
+
+        VkQueryPoolCreateInfo queryPoolInfo{};
+        queryPoolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+        queryPoolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+        queryPoolInfo.queryCount = frameCount * MAX_ZONES_PER_FRAME * 2;
+        if (vkCreateQueryPool(lveDevice.device(), &queryPoolInfo, nullptr, &queryPool) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to create timestamp query pool!");
+        }
+        vkResetQueryPool(lveDevice.device(), queryPool, 0, queryPoolInfo.queryCount);
+    }
+
+    GpuProfiler::~GpuProfiler()
+    {
+        lveDevice.getDeletionQueue().push(
+            [device = lveDevice.device(), queryPool = queryPool]()
+            { vkDestroyQueryPool(device, queryPool, nullptr); });
+    }
+
+    void GpuProfiler::beginFrame(int frameIndex)
+    {
+        if (frameIndex < 0 || frameIndex >= static_cast<int>(frameZones.size()))
+            throw std::runtime_error("GpuProfiler frame index out of range: " + std::to_string(frameIndex));
+
+        recordResults(frameIndex);
+        vkResetQueryPool(lveDevice.device(), queryPool, frameIndex * MAX_ZONES_PER_FRAME * 2, MAX_ZONES_PER_FRAME * 2);
+        frameZones[frameIndex].clear();
+        currentFrameIndex = frameIndex;
+    }
+
+    int GpuProfiler::beginZone(VkCommandBuffer commandBuffer, const char *name)
+    {
+        if (currentFrameIndex < 0)
+            throw std::runtime_error("GpuProfiler::beginFrame must be called before recording zones");
+
+        std::vector<Zone> &zones = frameZones[currentFrameIndex];
+        if (zones.size() == MAX_ZONES_PER_FRAME)
+            return -1;
+
+        uint32_t query = (currentFrameIndex * MAX_ZONES_PER_FRAME + static_cast<uint32_t>(zones.size())) * 2;
+        vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, queryPool, query);
+        zones.push_back({name, false});
+        return static_cast<int>(zones.size()) - 1;
+    }
+
+    void GpuProfiler::endZone(VkCommandBuffer commandBuffer, int zone)
+    {
+        if (zone < 0)
+            return;
+
+        uint32_t query = (currentFrameIndex * MAX_ZONES_PER_FRAME + zone) * 2 + 1;
+        vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, queryPool, query);
+        frameZones[currentFrameIndex][zone].isEnded = true;
+    }
+
+    void GpuProfiler::recordResults(int frameIndex)
+    {
+        const std::vector<Zone> &zones = frameZones[frameIndex];
+        if (zones.empty())
+            return;
+
+        // value and availability per query, without waiting
+        std::vector<uint64_t> results(zones.size() * 2 * 2);
+        vkGetQueryPoolResults(
+            lveDevice.device(),
+            queryPool,
+            frameIndex * MAX_ZONES_PER_FRAME * 2,
+            static_cast<uint32_t>(zones.size() * 2),
+            results.size() * sizeof(uint64_t),
+            results.data(),
+            2 * sizeof(uint64_t),
+            VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT);
+
+        for (size_t i = 0; i < zones.size(); i++)
+        {
+            const uint64_t *begin = &results[i * 4];
+            const uint64_t *end = &results[i * 4 + 2];
+            if (!zones[i].isEnded || begin[1] == 0 || end[1] == 0)
+                continue;
+
+            uint64_t ticks = (end[0] - begin[0]) & timestampMask;
+            LVE_STATS_RECORD(zones[i].name, ticks * timestampPeriod / 1e6);
+        }
+    }
+} // namespace lve
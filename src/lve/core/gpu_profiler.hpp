@@ -0,0 +1,96 @@
+#pragma once
+
+#include "lve/core/device.hpp"
+#include "lve/util/stats.hpp"
+
+// libs
+#include <vulkan/vulkan.h>
+
+// std
+#include <cstdint>
+#include <vector>
+
+namespace lve
+{
+    /*
+     * GPU durations of command buffer ranges, measured with timestamp queries
+     * Every frame slot owns a range of a query pool. A zone writes a timestamp at its begin and end,
+     * and the results are read back when the slot begins again, after its previous frame has
+     * completed, so reading never waits for the GPU. Durations are recorded in milliseconds under
+     * the zone's name in the StatsRecorder, whose history provides the rolling averages. Queries are
+     * reset from the host, so zones can be recorded into graphics and compute command buffers of
+     * the frame alike.
+     * The frame managers own one when stats are enabled (LVE_ENABLE_STATS) and the device supports
+     * it, zones are recorded through LVE_GPU_ZONE.
+     */
+    class GpuProfiler
+    {
+    public:
+        static constexpr uint32_t MAX_ZONES_PER_FRAME = 32;
+
+        GpuProfiler(Device &device);
+        ~GpuProfiler();
+
+        GpuProfiler(const GpuProfiler &) = delete;
+        GpuProfiler &operator=(const GpuProfiler &) = delete;
+
+        // records the zones of the slot's previous frame, which must have completed, and reuses its queries
+        void beginFrame(int frameIndex);
+
+        /*
+         * Zones of the frame started by beginFrame()
+         * @param name: stats name, must outlive the readback (e.g. a string literal)
+         * @return zone to end, -1 when the frame has no zones left
+         */
+        int beginZone(VkCommandBuffer commandBuffer, const char *name);
+        void endZone(VkCommandBuffer commandBuffer, int zone);
+
+    private:
+        void recordResults(int frameIndex);
+
+        struct Zone
+        {
+            const char *name;
+            bool isEnded;
+        };
+
+        Device &lveDevice;
+        VkQueryPool queryPool = VK_NULL_HANDLE;
+        double timestampPeriod;  // nanoseconds per tick
+        uint64_t timestampMask;  // valid bits of the timestamps
+        std::vector<std::vector<Zone>> frameZones;
+        int currentFrameIndex = -1;
+    };
+
+    // zone of the enclosing scope, does nothing without a profiler
+    class GpuZone
+    {
+    public:
+        GpuZone(GpuProfiler *profiler, VkCommandBuffer commandBuffer, const char *name)
+            : profiler{profiler}, commandBuffer{commandBuffer}
+        {
+            if (profiler != nullptr)
+                zone = profiler->beginZone(commandBuffer, name);
+        }
+        ~GpuZone()
+        {
+            if (profiler != nullptr)
+                profiler->endZone(commandBuffer, zone);
+        }
+
+        GpuZone(const GpuZone &) = delete;
+        GpuZone &operator=(const GpuZone &) = delete;
+
+    private:
+        GpuProfiler *profiler;
+        VkCommandBuffer commandBuffer;
+        int zone = -1;
+    };
+} // namespace lve
+
+#ifdef LVE_ENABLE_STATS
+#define LVE_GPU_ZONE(profiler, commandBuffer, name) \
+    lve::GpuZone LVE_STATS_CONCAT(lveGpuZone_, __LINE__)(profiler, commandBuffer, name)
+#else
+#define LVE_GPU_ZONE(profiler, commandBuffer, name)
+#endif
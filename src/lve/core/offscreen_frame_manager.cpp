@@ -0,0 +1,440 @@
+#include "lve/core/offscreen_frame_manager.hpp"
+#include "lve/core/deletion_queue.hpp"
+#include "lve/core/upload_context.hpp"
+#include "lve/util/trace.hpp"
+
+// std
+#include <array>
+#include <stdexcept>
+
+namespace lve
+{
+    OffscreenFrameManager::OffscreenFrameManager(Device &device, VkExtent2D extent)
+        : lveDevice{device}, extent{extent}
+    {
+        if (extent.width == 0 || extent.height == 0)
+            throw std::runtime_error("Offscreen frame extent must be greater than 0");
+
+        depthFormat = lveDevice.findSupportedFormat(
+            {VK_FORMAT_D32_SFLOAT, VK_FORMAT_D32_SFLOAT_S8_UINT, VK_FORMAT_D24_UNORM_S8_UINT},
+            VK_IMAGE_TILING_OPTIMAL,
+            VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT);
+
+        createRenderPass();
+        createImages();
+        createFramebuffers();
+        createCommandBuffers();
+        createSyncObjects();
+#ifdef LVE_ENABLE_STATS
+        if (lveDevice.supportsGpuTimestamps())
+            gpuProfiler = std::make_unique<GpuProfiler>(lveDevice);
+#endif
+    }
+
+    OffscreenFrameManager::~OffscreenFrameManager()
+    {
+        // the callbacks may reference their owner, so pending readbacks are dropped rather than delivered
+        lveDevice.graphicsTimeline().wait(lastFrameValue);
+
+        vkFreeCommandBuffers(
+            lveDevice.device(),
+            lveDevice.getCommandPool(),
+            static_cast<uint32_t>(commandBuffers.size()),
+            commandBuffers.data());
+        for (VkFramebuffer framebuffer : framebuffers)
+            vkDestroyFramebuffer(lveDevice.device(), framebuffer, nullptr);
+        vkDestroyRenderPass(lveDevice.device(), renderPass, nullptr);
+    }
+
+    /*
+     * Same attachments as the swap chain render pass, except the color image ends in
+     * TRANSFER_SRC_OPTIMAL so a readback copy can follow it directly
+     */
+    void OffscreenFrameManager::createRenderPass()
+    {
+        VkAttachmentDescription colorAttachment{};
+        colorAttachment.format = COLOR_FORMAT;
+        colorAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
+        colorAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+        colorAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+        colorAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+        colorAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+        colorAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        colorAttachment.finalLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+
+        VkAttachmentDescription depthAttachment{};
+        depthAttachment.format = depthFormat;
+        depthAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
+        depthAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+        depthAttachment.storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+        depthAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+        depthAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+        depthAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        depthAttachment.finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
+        VkAttachmentReference colorAttachmentRef{};
+        colorAttachmentRef.attachment = 0;
+        colorAttachmentRef.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+
+        VkAttachmentReference depthAttachmentRef{};
+        depthAttachmentRef.attachment = 1;
+        depthAttachmentRef.layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
+        VkSubpassDescription subpass{};
+        subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+        subpass.colorAttachmentCount = 1;
+        subpass.pColorAttachments = &colorAttachmentRef;
+        subpass.pDepthStencilAttachment = &depthAttachmentRef;
+
+        std::array<VkSubpassDependency, 2> dependencies{};
+        dependencies[0].srcSubpass = VK_SUBPASS_EXTERNAL;
+        dependencies[0].dstSubpass = 0;
+        dependencies[0].srcStageMask =
+            VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
+        dependencies[0].srcAccessMask = 0;
+        dependencies[0].dstStageMask =
+            VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
+        dependencies[0].dstAccessMask =
+            VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+
+        // color writes are visible to the readback copy
+        dependencies[1].srcSubpass = 0;
+        dependencies[1].dstSubpass = VK_SUBPASS_EXTERNAL;
+        dependencies[1].srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+        dependencies[1].srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+        dependencies[1].dstStageMask = VK_PIPELINE_STAGE_TRANSFER_BIT;
+        dependencies[1].dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+
+        std::array<VkAttachmentDescription, 2> attachments = {colorAttachment, depthAttachment};
+        VkRenderPassCreateInfo renderPassInfo{};
+        renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+        renderPassInfo.attachmentCount = static_cast<uint32_t>(attachments.size());
+        renderPassInfo.pAttachments = attachments.data();
+        renderPassInfo.subpassCount = 1;
+        renderPassInfo.pSubpasses = &subpass;
+        renderPassInfo.dependencyCount = static_cast<uint32_t>(dependencies.size());
+        renderPassInfo.pDependencies = dependencies.data();
+
+        if (vkCreateRenderPass(lveDevice.device(), &renderPassInfo, nullptr, &renderPass) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to create offscreen render pass!");
+        }
+    }
+
+    void OffscreenFrameManager::createImages()
+    {
+        for (int i = 0; i < lveDevice.getFramesInFlight(); i++)
+        {
+            VkImageCreateInfo imageInfo{};
+            imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+            imageInfo.imageType = VK_IMAGE_TYPE_2D;
+            imageInfo.extent.width = extent.width;
+            imageInfo.extent.height = extent.height;
+            imageInfo.extent.depth = 1;
+            imageInfo.mipLevels = 1;
+            imageInfo.arrayLayers = 1;
+            imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+            imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+            imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+            imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+            VkImageViewCreateInfo viewInfo{};
+            viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+            viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+            viewInfo.subresourceRange.baseMipLevel = 0;
+            viewInfo.subresourceRange.levelCount = 1;
+            viewInfo.subresourceRange.baseArrayLayer = 0;
+            viewInfo.subresourceRange.layerCount = 1;
+
+            imageInfo.format = COLOR_FORMAT;
+            imageInfo.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+            Image colorImage{lveDevice, imageInfo, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT};
+            viewInfo.image = colorImage.getImage();
+            viewInfo.format = COLOR_FORMAT;
+            viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+            colorImage.createImageView(0, &viewInfo);
+            colorImages.push_back(std::move(colorImage));
+
+            imageInfo.format = depthFormat;
+            imageInfo.usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
+            Image depthImage{lveDevice, imageInfo, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT};
+            viewInfo.image = depthImage.getImage();
+            viewInfo.format = depthFormat;
+            viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT;
+            depthImage.createImageView(0, &viewInfo);
+            depthImages.push_back(std::move(depthImage));
+
+            // host visible copy target, read by the callback once the frame's timeline value has completed
+            readbackBuffers.push_back(std::make_unique<Buffer>(
+                lveDevice,
+                sizeof(uint32_t), // one RGBA8 texel
+                extent.width * extent.height,
+                VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT));
+            readbackBuffers.back()->map();
+        }
+    }
+
+    void OffscreenFrameManager::createFramebuffers()
+    {
+        framebuffers.resize(lveDevice.getFramesInFlight());
+        for (size_t i = 0; i < framebuffers.size(); i++)
+        {
+            std::array<VkImageView, 2> attachments = {colorImages[i].getImageView(0), depthImages[i].getImageView(0)};
+
+            VkFramebufferCreateInfo framebufferInfo{};
+            framebufferInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+            framebufferInfo.renderPass = renderPass;
+            framebufferInfo.attachmentCount = static_cast<uint32_t>(attachments.size());
+            framebufferInfo.pAttachments = attachments.data();
+            framebufferInfo.width = extent.width;
+            framebufferInfo.height = extent.height;
+            framebufferInfo.layers = 1;
+
+            if (vkCreateFramebuffer(lveDevice.device(), &framebufferInfo, nullptr, &framebuffers[i]) != VK_SUCCESS)
+            {
+                throw std::runtime_error("failed to create offscreen framebuffer!");
+            }
+        }
+    }
+
+    void OffscreenFrameManager::createCommandBuffers()
+    {
+        commandBuffers.resize(lveDevice.getFramesInFlight());
+
+        VkCommandBufferAllocateInfo allocInfo{};
+        allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+        allocInfo.commandPool = lveDevice.getCommandPool();
+        allocInfo.commandBufferCount = static_cast<uint32_t>(commandBuffers.size());
+
+        if (vkAllocateCommandBuffers(lveDevice.device(), &allocInfo, commandBuffers.data()) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to allocate command buffers!");
+        }
+    }
+
+    void OffscreenFrameManager::createSyncObjects()
+    {
+        frameValues.assign(lveDevice.getFramesInFlight(), 0);
+        pendingReadbacks.resize(lveDevice.getFramesInFlight());
+        submittedFrameNumbers.assign(lveDevice.getFramesInFlight(), 0);
+    }
+
+    VkCommandBuffer OffscreenFrameManager::beginFrame()
+    {
+        assert(!isFrameStarted && "Can't call beginFrame while already in progress");
+        LVE_TRACE_ZONE("OffscreenFrameManager::beginFrame");
+
+        {
+            LVE_TRACE_ZONE("wait frame in flight");
+            lveDevice.graphicsTimeline().wait(frameValues[currentFrameIndex]);
+        }
+        completeReadback(currentFrameIndex); // the slot is reused, deliver its image first
+
+        isFrameStarted = true;
+        lveDevice.getUploadContext().beginFrame(currentFrameIndex); // the slot's previous frame has completed
+        lveDevice.getDeletionQueue().collect();
+
+        auto commandBuffer = getCurrentCommandBuffer();
+        VkCommandBufferBeginInfo beginInfo{};
+        beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+
+        if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to begin recording command buffer!");
+        }
+        LVE_STATS_ONLY(beginGpuFrame(commandBuffer));
+
+        // uploads queued since the last frame, e.g. by resource creation
+        lveDevice.getUploadContext().record(commandBuffer);
+        return commandBuffer;
+    }
+
+    void OffscreenFrameManager::endFrame()
+    {
+        assert(isFrameStarted && "Can't call endFrame while frame is not in progress");
+        LVE_TRACE_ZONE("OffscreenFrameManager::endFrame");
+        auto commandBuffer = getCurrentCommandBuffer();
+
+        if (requestedReadback)
+            recordReadback(commandBuffer);
+
+        LVE_STATS_ONLY(endGpuFrame(commandBuffer));
+        if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to record command buffer!");
+        }
+
+        lveDevice.getUploadContext().takeWaitSemaphores(frameWaitSemaphores);
+        lastFrameValue = lveDevice.graphicsTimeline().submit({commandBuffer}, frameWaitSemaphores);
+        frameValues[currentFrameIndex] = lastFrameValue;
+        frameWaitSemaphores.clear();
+
+        pendingReadbacks[currentFrameIndex] = std::move(requestedReadback);
+        requestedReadback = nullptr;
+        submittedFrameNumbers[currentFrameIndex] = frameNumber;
+
+        frameNumber++;
+        isFrameStarted = false;
+        currentFrameIndex = (currentFrameIndex + 1) % lveDevice.getFramesInFlight();
+    }
+
+    // GPU time of the frame's command buffer, after the zones of the slot's previous frame are recorded
+    void OffscreenFrameManager::beginGpuFrame(VkCommandBuffer commandBuffer)
+    {
+        if (gpuProfiler == nullptr)
+            return;
+        gpuProfiler->beginFrame(currentFrameIndex);
+        gpuFrameZone = gpuProfiler->beginZone(commandBuffer, "gpu/frame_ms");
+    }
+
+    void OffscreenFrameManager::endGpuFrame(VkCommandBuffer commandBuffer)
+    {
+        if (gpuProfiler != nullptr)
+            gpuProfiler->endZone(commandBuffer, gpuFrameZone);
+    }
+
+    void OffscreenFrameManager::addWaitSemaphore(VkSemaphore semaphore, VkPipelineStageFlags waitStage, uint64_t value)
+    {
+        assert(isFrameStarted && "Can't add a wait semaphore while frame is not in progress");
+        frameWaitSemaphores.push_back({semaphore, value, waitStage});
+    }
+
+    void OffscreenFrameManager::beginSwapChainRenderPass(VkCommandBuffer commandBuffer)
+    {
+        assert(isFrameStarted && "Can't call beginSwapChainRenderPass if frame is not in progress");
+        assert(
+            commandBuffer == getCurrentCommandBuffer() &&
+            "Can't begin render pass on command buffer from a different frame");
+
+        // uploads queued during this frame, copies are not allowed inside the render pass
+        lveDevice.getUploadContext().record(commandBuffer);
+
+        VkRenderPassBeginInfo renderPassInfo{};
+        renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+        renderPassInfo.renderPass = renderPass;
+        renderPassInfo.framebuffer = framebuffers[currentFrameIndex];
+
+        renderPassInfo.renderArea.offset = {0, 0};
+        renderPassInfo.renderArea.extent = extent;
+
+        std::array<VkClearValue, 2> clearValues{};
+        clearValues[0].color = {0.01f, 0.01f, 0.01f, 1.0f};
+        clearValues[1].depthStencil = {1.0f, 0};
+        renderPassInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
+        renderPassInfo.pClearValues = clearValues.data();
+
+        vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+
+        VkViewport viewport{};
+        viewport.x = 0.0f;
+        viewport.y = 0.0f;
+        viewport.width = static_cast<float>(extent.width);
+        viewport.height = static_cast<float>(extent.height);
+        viewport.minDepth = 0.0f;
+        viewport.maxDepth = 1.0f;
+        VkRect2D scissor{{0, 0}, extent};
+        vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+        vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+    }
+
+    void OffscreenFrameManager::endSwapChainRenderPass(VkCommandBuffer commandBuffer)
+    {
+        assert(isFrameStarted && "Can't call endSwapChainRenderPass if frame is not in progress");
+        assert(
+            commandBuffer == getCurrentCommandBuffer() &&
+            "Can't end render pass on command buffer from a different frame");
+        vkCmdEndRenderPass(commandBuffer);
+    }
+
+    void OffscreenFrameManager::requestReadback(ReadbackCallback callback)
+    {
+        assert(isFrameStarted && "Can't request a readback if frame is not in progress");
+        requestedReadback = std::move(callback);
+    }
+
+    // recorded after the render pass, which leaves the color image in TRANSFER_SRC_OPTIMAL
+    void OffscreenFrameManager::recordReadback(VkCommandBuffer commandBuffer)
+    {
+        VkBufferImageCopy region{};
+        region.bufferOffset = 0;
+        region.bufferRowLength = 0; // tightly packed
+        region.bufferImageHeight = 0;
+        region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        region.imageSubresource.mipLevel = 0;
+        region.imageSubresource.baseArrayLayer = 0;
+        region.imageSubresource.layerCount = 1;
+        region.imageOffset = {0, 0, 0};
+        region.imageExtent = {extent.width, extent.height, 1};
+
+        VkBuffer readbackBuffer = readbackBuffers[currentFrameIndex]->getBuffer();
+        vkCmdCopyImageToBuffer(
+            commandBuffer,
+            colorImages[currentFrameIndex].getImage(),
+            VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+            readbackBuffer,
+            1,
+            &region);
+
+        VkBufferMemoryBarrier barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.buffer = readbackBuffer;
+        barrier.offset = 0;
+        barrier.size = VK_WHOLE_SIZE;
+        vkCmdPipelineBarrier(
+            commandBuffer,
+            VK_PIPELINE_STAGE_TRANSFER_BIT,
+            VK_PIPELINE_STAGE_HOST_BIT,
+            0,
+            0, nullptr,
+            1, &barrier,
+            0, nullptr);
+    }
+
+    // the graphics timeline must have reached the frame's value
+    void OffscreenFrameManager::completeReadback(int frameIndex)
+    {
+        if (!pendingReadbacks[frameIndex])
+            return;
+
+        LVE_TRACE_ZONE("OffscreenFrameManager::completeReadback");
+        Buffer &readbackBuffer = *readbackBuffers[frameIndex];
+        readbackBuffer.invalidate(); // no-op on coherent memory
+
+        ReadbackImage image{};
+        image.width = extent.width;
+        image.height = extent.height;
+        image.frameNumber = submittedFrameNumbers[frameIndex];
+        image.pixels = static_cast<const uint8_t *>(readbackBuffer.getMappedMemory());
+
+        // moved out first so the slot is free even if the callback throws
+        ReadbackCallback callback = std::move(pendingReadbacks[frameIndex]);
+        pendingReadbacks[frameIndex] = nullptr;
+        callback(image);
+    }
+
+    void OffscreenFrameManager::pollReadbacks()
+    {
+        for (int i = 0; i < lveDevice.getFramesInFlight(); i++)
+        {
+            if (pendingReadbacks[i] && lveDevice.graphicsTimeline().isComplete(frameValues[i]))
+                completeReadback(i);
+        }
+    }
+
+    void OffscreenFrameManager::waitIdle()
+    {
+        assert(!isFrameStarted && "Can't call waitIdle while a frame is in progress");
+        lveDevice.graphicsTimeline().wait(lastFrameValue);
+
+        // oldest frame first
+        int framesInFlight = lveDevice.getFramesInFlight();
+        for (int i = 0; i < framesInFlight; i++)
+            completeReadback((currentFrameIndex + i) % framesInFlight);
+    }
+} // namespace lve
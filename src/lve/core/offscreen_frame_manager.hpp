@@ -0,0 +1,126 @@
+#pragma once
+
+#include "lve/core/device.hpp"
+#include "lve/core/gpu_profiler.hpp"
+#include "lve/core/queue_timeline.hpp"
+#include "lve/core/resource/buffer.hpp"
+#include "lve/core/resource/image.hpp"
+
+// std
+#include <cassert>
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace lve
+{
+    /*
+     * FrameManager counterpart without a window: frames are rendered into offscreen color images
+     * and nothing is presented, so it runs on a headless Device (e.g. lavapipe in CI)
+     * The method names match FrameManager so render code works with either. A frame can request a
+     * readback of its color image, the copy into a host buffer is recorded after the render pass
+     * and the callback runs once the graphics timeline has reached the frame's value, without
+     * stalling the frames in flight.
+     */
+    class OffscreenFrameManager
+    {
+    public:
+        static constexpr VkFormat COLOR_FORMAT = VK_FORMAT_R8G8B8A8_UNORM;
+
+        // tightly packed RGBA8 rows, top row first, only valid during the callback
+        struct ReadbackImage
+        {
+            uint32_t width;
+            uint32_t height;
+            uint64_t frameNumber;
+            const uint8_t *pixels;
+        };
+        using ReadbackCallback = std::function<void(const ReadbackImage &)>;
+
+        OffscreenFrameManager(Device &device, VkExtent2D extent);
+        ~OffscreenFrameManager();
+
+        OffscreenFrameManager(const OffscreenFrameManager &) = delete;
+        OffscreenFrameManager &operator=(const OffscreenFrameManager &) = delete;
+
+        VkRenderPass getSwapChainRenderPass() const { return renderPass; }
+        VkExtent2D getExtent() const { return extent; }
+        float getAspectRatio() const { return static_cast<float>(extent.width) / static_cast<float>(extent.height); }
+        bool isFrameInProgress() const { return isFrameStarted; }
+        uint64_t getFrameNumber() const { return frameNumber; } // frames ended so far
+        VkFormat getImageFormat() const { return COLOR_FORMAT; }
+
+        VkCommandBuffer getCurrentCommandBuffer() const
+        {
+            assert(isFrameStarted && "Cannot get command buffer when frame not in progress");
+            return commandBuffers[currentFrameIndex];
+        }
+
+        int getFrameIndex() const
+        {
+            assert(isFrameStarted && "Cannot get frame index when frame not in progress");
+            return currentFrameIndex;
+        }
+
+        // color image the frame in progress renders to, in TRANSFER_SRC_OPTIMAL layout after the render pass
+        VkImage getCurrentImage() const
+        {
+            assert(isFrameStarted && "Cannot get color image when frame not in progress");
+            return colorImages[currentFrameIndex].getImage();
+        }
+
+        VkCommandBuffer beginFrame();
+        void endFrame();
+        void beginSwapChainRenderPass(VkCommandBuffer commandBuffer);
+        void endSwapChainRenderPass(VkCommandBuffer commandBuffer);
+
+        // the submission of the frame in progress waits on semaphore, value is the one of a timeline semaphore
+        void addWaitSemaphore(VkSemaphore semaphore, VkPipelineStageFlags waitStage, uint64_t value = 0);
+        // null unless stats are enabled and the device supports timestamps, for LVE_GPU_ZONE
+        GpuProfiler *getGpuProfiler() const { return gpuProfiler.get(); }
+
+        // copy the color image of the frame in progress back to the host, callback runs on the calling thread of a later beginFrame, pollReadbacks or waitIdle
+        void requestReadback(ReadbackCallback callback);
+        // run the callbacks of finished frames without blocking
+        void pollReadbacks();
+        // wait for every submitted frame and run all pending callbacks
+        void waitIdle();
+
+    private:
+        void createRenderPass();
+        void createImages();
+        void createFramebuffers();
+        void createCommandBuffers();
+        void createSyncObjects();
+        void recordReadback(VkCommandBuffer commandBuffer);
+        void completeReadback(int frameIndex);
+        void beginGpuFrame(VkCommandBuffer commandBuffer);
+        void endGpuFrame(VkCommandBuffer commandBuffer);
+
+        Device &lveDevice;
+        VkExtent2D extent;
+        VkFormat depthFormat;
+        VkRenderPass renderPass;
+
+        std::vector<Image> colorImages;
+        std::vector<Image> depthImages;
+        std::vector<VkFramebuffer> framebuffers;
+        std::vector<VkCommandBuffer> commandBuffers;
+        std::vector<uint64_t> frameValues; // graphics timeline value of each slot's last frame
+        uint64_t lastFrameValue = 0;
+        std::vector<std::unique_ptr<Buffer>> readbackBuffers;
+
+        ReadbackCallback requestedReadback;             // for the frame in progress
+        std::vector<ReadbackCallback> pendingReadbacks; // per frame in flight, submitted and not yet delivered
+        std::vector<uint64_t> submittedFrameNumbers;
+
+        int currentFrameIndex{0};
+        uint64_t frameNumber{0};
+        bool isFrameStarted{false};
+
+        std::vector<SemaphoreSubmit> frameWaitSemaphores; // waits of the frame in progress
+
+        std::unique_ptr<GpuProfiler> gpuProfiler;
+        int gpuFrameZone = -1; // the whole command buffer of the frame in progress
+    };
+} // namespace lve
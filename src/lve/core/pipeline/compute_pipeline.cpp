@@ -1,10 +1,12 @@
 #include "lve/core/pipeline/compute_pipeline.hpp"
+#include "lve/core/deletion_queue.hpp"
+#include "lve/core/pipeline/pipeline_cache.hpp"
 #include "lve/core/pipeline/pipeline_op.hpp"
 #include "lve/go/geo/model.hpp"
-#include "lve/util/file_io.hpp"
 
 // std
 #include <cassert>
+#include <chrono>
 #include <fstream>
 #include <iostream>
 #include <stdexcept>
@@ -19,8 +21,12 @@ namespace lve
 
     ComputePipeline::~ComputePipeline()
     {
-        vkDestroyShaderModule(lveDevice.device(), compShaderModule, nullptr);
-        vkDestroyPipeline(lveDevice.device(), computePipeline, nullptr);
+        lveDevice.getDeletionQueue().push(
+            [device = lveDevice.device(), compShaderModule = compShaderModule, computePipeline = computePipeline]()
+            {
+                vkDestroyShaderModule(device, compShaderModule, nullptr);
+                vkDestroyPipeline(device, computePipeline, nullptr);
+            });
     }
 
     void ComputePipeline::createComputePipeline(const std::string &compFilepath, const ComputePipelineConfigInfo &configInfo)
@@ -29,10 +35,10 @@ namespace lve
             configInfo.pipelineLayout != VK_NULL_HANDLE &&
             "Cannot create compute pipeline: no pipelineLayout provided in configInfo");
 
-        io::YamlConfig generalConfig{"config/general.yaml"};
-        std::string shaderRoot = generalConfig.get<std::string>("shaderRoot") + "/";
-        std::vector<char> compCode = io::readBinaryFile(shaderRoot + compFilepath);
-        createShaderModule(lveDevice, compCode, &compShaderModule);
+        std::shared_ptr<const std::vector<char>> compCode = configInfo.compCode;
+        if (compCode == nullptr)
+            compCode = std::make_shared<const std::vector<char>>(readShaderFile(compFilepath));
+        createShaderModule(lveDevice, *compCode, &compShaderModule);
 
         VkPipelineShaderStageCreateInfo shaderStageInfo{};
         shaderStageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
@@ -47,13 +53,17 @@ namespace lve
         pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
         pipelineInfo.basePipelineIndex = -1;
 
-        if (vkCreateComputePipelines(
-                lveDevice.device(),
-                VK_NULL_HANDLE,
-                1,
-                &pipelineInfo,
-                nullptr,
-                &computePipeline) != VK_SUCCESS)
+        PipelineCache &pipelineCache = lveDevice.getPipelineCache();
+        auto startTime = std::chrono::steady_clock::now();
+        VkResult result = vkCreateComputePipelines(
+            lveDevice.device(),
+            pipelineCache.getCache(),
+            1,
+            &pipelineInfo,
+            nullptr,
+            &computePipeline);
+        pipelineCache.recordCreation(std::chrono::steady_clock::now() - startTime);
+        if (result != VK_SUCCESS)
         {
             throw std::runtime_error("failed to create compute pipeline");
         }
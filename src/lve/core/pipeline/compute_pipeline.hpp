@@ -3,6 +3,7 @@
 #include "lve/core/device.hpp"
 
 // std
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -15,6 +16,8 @@ namespace lve
         ComputePipelineConfigInfo &operator=(const ComputePipelineConfigInfo &) = delete;
 
         VkPipelineLayout pipelineLayout = nullptr;
+        // SPIR-V read ahead, e.g. by PipelineBuilder, the file is read when null
+        std::shared_ptr<const std::vector<char>> compCode;
     };
 
     class ComputePipeline
@@ -1,10 +1,12 @@
 #include "lve/core/pipeline/graphics_pipeline.hpp"
+#include "lve/core/deletion_queue.hpp"
+#include "lve/core/pipeline/pipeline_cache.hpp"
 #include "lve/core/pipeline/pipeline_op.hpp"
 #include "lve/go/geo/model.hpp"
-#include "lve/util/file_io.hpp"
 
 // std
 #include <cassert>
+#include <chrono>
 #include <fstream>
 #include <iostream>
 #include <stdexcept>
@@ -116,9 +118,16 @@ namespace lve
 
     GraphicPipeline::~GraphicPipeline()
     {
-        vkDestroyShaderModule(lveDevice.device(), vertShaderModule, nullptr);
-        vkDestroyShaderModule(lveDevice.device(), fragShaderModule, nullptr);
-        vkDestroyPipeline(lveDevice.device(), graphicPipeline, nullptr);
+        lveDevice.getDeletionQueue().push(
+            [device = lveDevice.device(),
+             vertShaderModule = vertShaderModule,
+             fragShaderModule = fragShaderModule,
+             graphicPipeline = graphicPipeline]()
+            {
+                vkDestroyShaderModule(device, vertShaderModule, nullptr);
+                vkDestroyShaderModule(device, fragShaderModule, nullptr);
+                vkDestroyPipeline(device, graphicPipeline, nullptr);
+            });
     }
 
     void GraphicPipeline::createGraphicsPipeline(const GraphicPipelineConfigInfo &configInfo)
@@ -130,13 +139,15 @@ namespace lve
             configInfo.renderPass != VK_NULL_HANDLE &&
             "Cannot create graphics pipeline: no renderPass provided in configInfo");
 
-        io::YamlConfig generalConfig{"config/general.yaml"};
-        std::string shaderRoot = generalConfig.get<std::string>("shaderRoot") + "/";
-        std::vector<char> vertCode = io::readBinaryFile(shaderRoot + configInfo.vertFilepath);
-        std::vector<char> fragCode = io::readBinaryFile(shaderRoot + configInfo.fragFilepath);
+        std::shared_ptr<const std::vector<char>> vertCode = configInfo.vertCode;
+        if (vertCode == nullptr)
+            vertCode = std::make_shared<const std::vector<char>>(readShaderFile(configInfo.vertFilepath));
+        std::shared_ptr<const std::vector<char>> fragCode = configInfo.fragCode;
+        if (fragCode == nullptr)
+            fragCode = std::make_shared<const std::vector<char>>(readShaderFile(configInfo.fragFilepath));
 
-        createShaderModule(lveDevice, vertCode, &vertShaderModule);
-        createShaderModule(lveDevice, fragCode, &fragShaderModule);
+        createShaderModule(lveDevice, *vertCode, &vertShaderModule);
+        createShaderModule(lveDevice, *fragCode, &fragShaderModule);
 
         VkPipelineShaderStageCreateInfo shaderStages[2];
         shaderStages[0].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
@@ -184,13 +195,17 @@ namespace lve
         pipelineInfo.basePipelineIndex = -1;
         pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
 
-        if (vkCreateGraphicsPipelines(
-                lveDevice.device(),
-                VK_NULL_HANDLE,
-                1,
-                &pipelineInfo,
-                nullptr,
-                &graphicPipeline) != VK_SUCCESS)
+        PipelineCache &pipelineCache = lveDevice.getPipelineCache();
+        auto startTime = std::chrono::steady_clock::now();
+        VkResult result = vkCreateGraphicsPipelines(
+            lveDevice.device(),
+            pipelineCache.getCache(),
+            1,
+            &pipelineInfo,
+            nullptr,
+            &graphicPipeline);
+        pipelineCache.recordCreation(std::chrono::steady_clock::now() - startTime);
+        if (result != VK_SUCCESS)
         {
             throw std::runtime_error("failed to create graphics pipeline");
         }
@@ -3,6 +3,7 @@
 #include "lve/core/device.hpp"
 
 // std
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -32,6 +33,9 @@ namespace lve
         std::vector<VkVertexInputAttributeDescription> vertexAttributeDescriptions;
         std::string vertFilepath;
         std::string fragFilepath;
+        // SPIR-V read ahead, e.g. by PipelineBuilder, the files are read when null
+        std::shared_ptr<const std::vector<char>> vertCode;
+        std::shared_ptr<const std::vector<char>> fragCode;
     };
 
     class GraphicPipeline
@@ -0,0 +1,70 @@
+#include "lve/core/pipeline/pipeline_builder.hpp"
+#include "lve/core/pipeline/pipeline_op.hpp"
+#include "lve/util/trace.hpp"
+
+// std
+#include <utility>
+
+namespace lve
+{
+    PipelineBuilder::PipelineBuilder(Device &device, ThreadPool &threadPool)
+        : lveDevice{device}, threadPool{threadPool}
+    {
+    }
+
+    PipelineBuilder::~PipelineBuilder()
+    {
+        std::unique_lock<std::mutex> lock{buildMutex};
+        buildCondVar.wait(lock, [this]() { return runningBuildCount == 0; });
+    }
+
+    std::future<RenderSystem> PipelineBuilder::buildRenderSystem(
+        VkRenderPass renderPass,
+        std::vector<VkDescriptorSetLayout> descriptorSetLayouts,
+        GraphicPipelineConfigInfo &configInfo)
+    {
+        return submitBuild(
+            [this, renderPass, descriptorSetLayouts = std::move(descriptorSetLayouts), &configInfo]()
+            {
+                BuildScope scope{*this};
+                LVE_TRACE_ZONE("PipelineBuilder::buildRenderSystem");
+                configInfo.vertCode = getShaderCode(configInfo.vertFilepath);
+                configInfo.fragCode = getShaderCode(configInfo.fragFilepath);
+                return RenderSystem(lveDevice, renderPass, descriptorSetLayouts, configInfo);
+            });
+    }
+
+    std::future<ComputeSystem> PipelineBuilder::buildComputeSystem(
+        std::vector<VkDescriptorSetLayout> descriptorSetLayouts,
+        const std::string &compFilepath)
+    {
+        return submitBuild(
+            [this, descriptorSetLayouts = std::move(descriptorSetLayouts), compFilepath]()
+            {
+                BuildScope scope{*this};
+                LVE_TRACE_ZONE("PipelineBuilder::buildComputeSystem");
+                return ComputeSystem(lveDevice, descriptorSetLayouts, compFilepath, getShaderCode(compFilepath));
+            });
+    }
+
+    std::shared_ptr<const std::vector<char>> PipelineBuilder::getShaderCode(const std::string &filepath)
+    {
+        // files are small, reading under the lock keeps a file from being read twice
+        std::lock_guard<std::mutex> lock{shaderMutex};
+        auto it = shaderCodes.find(filepath);
+        if (it != shaderCodes.end())
+            return it->second;
+
+        auto code = std::make_shared<const std::vector<char>>(readShaderFile(filepath));
+        shaderCodes.emplace(filepath, code);
+        return code;
+    }
+
+    void PipelineBuilder::endBuild()
+    {
+        // notified under the lock, the destructor may return as soon as it is released
+        std::lock_guard<std::mutex> lock{buildMutex};
+        runningBuildCount--;
+        buildCondVar.notify_all();
+    }
+} // namespace lve
@@ -0,0 +1,81 @@
+#pragma once
+
+#include "lve/core/device.hpp"
+#include "lve/core/system/compute_system.hpp"
+#include "lve/core/system/render_system.hpp"
+#include "lve/util/thread_pool.hpp"
+
+// std
+#include <condition_variable>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace lve
+{
+    /*
+     * Builds render and compute systems concurrently on a thread pool
+     * Each build runs as a task creating the pipeline layout, shader modules and pipeline, and the
+     * caller collects the system from the returned future. SPIR-V is read once per file and shared
+     * between builds, the shader root is parsed once (getShaderRoot()) and all pipelines go through
+     * the device's PipelineCache, so a warm start mostly costs the longest build instead of the sum.
+     * The destructor waits for the builds still running, which reference the builder and the
+     * config infos.
+     */
+    class PipelineBuilder
+    {
+    public:
+        PipelineBuilder(Device &device, ThreadPool &threadPool);
+        ~PipelineBuilder();
+
+        PipelineBuilder(const PipelineBuilder &) = delete;
+        PipelineBuilder &operator=(const PipelineBuilder &) = delete;
+
+        // configInfo is completed by the build and must outlive it
+        std::future<RenderSystem> buildRenderSystem(
+            VkRenderPass renderPass,
+            std::vector<VkDescriptorSetLayout> descriptorSetLayouts,
+            GraphicPipelineConfigInfo &configInfo);
+        std::future<ComputeSystem> buildComputeSystem(
+            std::vector<VkDescriptorSetLayout> descriptorSetLayouts,
+            const std::string &compFilepath);
+
+        // SPIR-V of a file relative to the shader root, read on first use, thread safe
+        std::shared_ptr<const std::vector<char>> getShaderCode(const std::string &filepath);
+
+    private:
+        // counts a build as running until it is destroyed
+        class BuildScope
+        {
+        public:
+            BuildScope(PipelineBuilder &builder) : builder{builder} {}
+            ~BuildScope() { builder.endBuild(); }
+
+            BuildScope(const BuildScope &) = delete;
+            BuildScope &operator=(const BuildScope &) = delete;
+
+        private:
+            PipelineBuilder &builder;
+        };
+
+        // counts the build as running from now on, the task has to hold a BuildScope
+        template <typename Build>
+        auto submitBuild(Build &&build) -> std::future<decltype(build())>;
+        void endBuild();
+
+        Device &lveDevice;
+        ThreadPool &threadPool;
+
+        std::mutex shaderMutex;
+        std::unordered_map<std::string, std::shared_ptr<const std::vector<char>>> shaderCodes;
+
+        std::mutex buildMutex;
+        std::condition_variable buildCondVar;
+        size_t runningBuildCount = 0;
+    };
+} // namespace lve
+
+#include "lve/core/pipeline/pipeline_builder.tpp"
@@ -0,0 +1,28 @@
+#pragma once
+
+#include "lve/core/pipeline/pipeline_builder.hpp"
+
+// std
+#include <utility>
+
+namespace lve
+{
+    template <typename Build>
+    auto PipelineBuilder::submitBuild(Build &&build) -> std::future<decltype(build())>
+    {
+        {
+            std::lock_guard<std::mutex> lock{buildMutex};
+            runningBuildCount++;
+        }
+
+        try
+        {
+            return threadPool.submit(std::forward<Build>(build));
+        }
+        catch (...)
+        {
+            endBuild(); // the task never runs
+            throw;
+        }
+    }
+} // namespace lve
@@ -0,0 +1,113 @@
+#include "lve/core/pipeline/pipeline_cache.hpp"
+#include "lve/util/file_io.hpp"
+
+// std
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <stdexcept>
+
+namespace lve
+{
+    PipelineCache::PipelineCache(VkDevice device, const VkPhysicalDeviceProperties &properties)
+        : device{device}, properties{properties}
+    {
+        char key[64];
+        std::snprintf(
+            key, sizeof(key), "%04x_%04x_%08x_", properties.vendorID, properties.deviceID, properties.driverVersion);
+        filepath = std::string(DIRECTORY) + "/" + key;
+        for (uint8_t byte : properties.pipelineCacheUUID)
+        {
+            char hex[3];
+            std::snprintf(hex, sizeof(hex), "%02x", byte);
+            filepath += hex;
+        }
+        filepath += ".bin";
+
+        std::vector<char> data;
+        if (std::getenv("LVE_NO_PIPELINE_CACHE") == nullptr && io::fileExists(filepath))
+        {
+            data = io::readBinaryFile(filepath);
+            if (!isCompatible(data))
+            {
+                std::cout << "Ignoring incompatible pipeline cache " << filepath << std::endl;
+                data.clear();
+            }
+        }
+
+        VkPipelineCacheCreateInfo cacheInfo{};
+        cacheInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+        cacheInfo.initialDataSize = data.size();
+        cacheInfo.pInitialData = data.empty() ? nullptr : data.data();
+        if (vkCreatePipelineCache(device, &cacheInfo, nullptr, &cache) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to create pipeline cache!");
+        }
+        loadedSize = data.size();
+    }
+
+    PipelineCache::~PipelineCache()
+    {
+        // a failed write only costs the next start its warm cache
+        try
+        {
+            save();
+        }
+        catch (const std::exception &e)
+        {
+            std::cerr << "failed to save pipeline cache: " << e.what() << std::endl;
+        }
+        vkDestroyPipelineCache(device, cache, nullptr);
+    }
+
+    void PipelineCache::save()
+    {
+        size_t size = 0;
+        if (vkGetPipelineCacheData(device, cache, &size, nullptr) != VK_SUCCESS || size == 0)
+            return;
+
+        std::vector<char> data(size);
+        if (vkGetPipelineCacheData(device, cache, &size, data.data()) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to get pipeline cache data!");
+        }
+        data.resize(size);
+
+        // written next to the cache and renamed, so an interrupted write never leaves a truncated cache
+        std::filesystem::create_directories(DIRECTORY);
+        std::string tempFilepath = filepath + ".tmp";
+        io::writeFile(tempFilepath, data);
+        std::filesystem::rename(tempFilepath, filepath);
+    }
+
+    void PipelineCache::recordCreation(std::chrono::steady_clock::duration duration)
+    {
+        pipelineCount++;
+        creationNanoseconds += std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count();
+    }
+
+    void PipelineCache::printCreationSummary() const
+    {
+        std::cout << "Created " << pipelineCount << " pipelines in " << creationNanoseconds / 1e6 << " ms, ";
+        if (isWarm())
+            std::cout << "warm pipeline cache (" << loadedSize << " bytes)" << std::endl;
+        else
+            std::cout << "cold pipeline cache" << std::endl;
+    }
+
+    bool PipelineCache::isCompatible(const std::vector<char> &data) const
+    {
+        VkPipelineCacheHeaderVersionOne header{};
+        if (data.size() < sizeof(header))
+            return false;
+
+        std::memcpy(&header, data.data(), sizeof(header));
+        return header.headerSize >= sizeof(header) &&
+               header.headerVersion == VK_PIPELINE_CACHE_HEADER_VERSION_ONE &&
+               header.vendorID == properties.vendorID &&
+               header.deviceID == properties.deviceID &&
+               std::memcmp(header.pipelineCacheUUID, properties.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+    }
+} // namespace lve
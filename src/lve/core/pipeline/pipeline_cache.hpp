@@ -0,0 +1,59 @@
+#pragma once
+
+// libs
+#include <vulkan/vulkan.h>
+
+// std
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace lve
+{
+    /*
+     * Driver pipeline cache kept on disk between runs
+     * The cache is loaded when the device is created and written back when it is destroyed. The
+     * file is keyed by the vendor, device, driver version and pipeline cache UUID, so a driver
+     * update starts from an empty cache instead of handing the driver data it cannot use, and a
+     * file whose header does not match the device is ignored. Every pipeline is created through it,
+     * so a warm start skips the shader compilation of the driver.
+     * LVE_NO_PIPELINE_CACHE skips loading to measure a cold start, see printCreationSummary().
+     */
+    class PipelineCache
+    {
+    public:
+        static constexpr const char *DIRECTORY = "pipeline_cache";
+
+        PipelineCache(VkDevice device, const VkPhysicalDeviceProperties &properties);
+        ~PipelineCache(); // saves the cache, before the device is destroyed
+
+        PipelineCache(const PipelineCache &) = delete;
+        PipelineCache &operator=(const PipelineCache &) = delete;
+
+        VkPipelineCache getCache() { return cache; }
+        bool isWarm() const { return loadedSize > 0; }
+        size_t getLoadedSize() const { return loadedSize; }
+        const std::string &getFilepath() const { return filepath; }
+
+        void save();
+
+        // time spent in vkCreate*Pipelines, thread safe
+        void recordCreation(std::chrono::steady_clock::duration duration);
+        // pipelines created so far, their creation time and the cache state, for startup benchmarks
+        void printCreationSummary() const;
+
+    private:
+        bool isCompatible(const std::vector<char> &data) const;
+
+        VkDevice device;
+        VkPhysicalDeviceProperties properties;
+        VkPipelineCache cache = VK_NULL_HANDLE;
+        std::string filepath;
+        size_t loadedSize = 0;
+
+        std::atomic<uint32_t> pipelineCount{0};
+        std::atomic<int64_t> creationNanoseconds{0};
+    };
+} // namespace lve
@@ -1,10 +1,24 @@
 #include "lve/core/pipeline/pipeline_op.hpp"
+#include "lve/util/file_io.hpp"
 
 // std
 #include <stdexcept>
 
 namespace lve
 {
+    const std::string &getShaderRoot()
+    {
+        // initialized once, also when pipelines are built on several threads
+        static const std::string shaderRoot =
+            io::YamlConfig{"config/general.yaml"}.get<std::string>("shaderRoot") + "/";
+        return shaderRoot;
+    }
+
+    std::vector<char> readShaderFile(const std::string &filepath)
+    {
+        return io::readBinaryFile(getShaderRoot() + filepath);
+    }
+
     void createShaderModule(Device &lveDevice, const std::vector<char> &code, VkShaderModule *shaderModule)
     {
         VkShaderModuleCreateInfo createInfo{};
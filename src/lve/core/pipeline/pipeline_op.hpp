@@ -5,9 +5,15 @@
 // std
 #include <string>
 #include <stdexcept>
+#include <vector>
 
 namespace lve
 {
+    // shaderRoot of config/general.yaml with a trailing slash, parsed once
+    const std::string &getShaderRoot();
+    // SPIR-V of a file relative to the shader root
+    std::vector<char> readShaderFile(const std::string &filepath);
+
     void createShaderModule(Device &lveDevice, const std::vector<char> &code, VkShaderModule *shaderModule);
 
     void bind(VkCommandBuffer commandBuffer, VkPipeline pipeline);
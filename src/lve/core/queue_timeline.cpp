@@ -0,0 +1,115 @@
+#include "lve/core/queue_timeline.hpp"
+#include "lve/util/trace.hpp"
+
+// std
+#include <limits>
+#include <stdexcept>
+
+namespace lve
+{
+    QueueTimeline::QueueTimeline(VkDevice device, VkQueue queue)
+        : device{device}, queue{queue}
+    {
+        VkSemaphoreTypeCreateInfo typeInfo{};
+        typeInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+        typeInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+        typeInfo.initialValue = 0;
+
+        VkSemaphoreCreateInfo semaphoreInfo{};
+        semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+        semaphoreInfo.pNext = &typeInfo;
+
+        if (vkCreateSemaphore(device, &semaphoreInfo, nullptr, &semaphore) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to create queue timeline semaphore!");
+        }
+    }
+
+    QueueTimeline::~QueueTimeline()
+    {
+        waitIdle();
+        vkDestroySemaphore(device, semaphore, nullptr);
+    }
+
+    uint64_t QueueTimeline::submit(
+        const std::vector<VkCommandBuffer> &commandBuffers,
+        const std::vector<SemaphoreSubmit> &waitSemaphores,
+        const std::vector<SemaphoreSubmit> &signalSemaphores,
+        VkFence fence)
+    {
+        std::vector<VkSemaphore> waits;
+        std::vector<VkPipelineStageFlags> waitStages;
+        std::vector<uint64_t> waitValues;
+        for (const SemaphoreSubmit &wait : waitSemaphores)
+        {
+            waits.push_back(wait.semaphore);
+            waitStages.push_back(wait.stageMask);
+            waitValues.push_back(wait.value);
+        }
+
+        std::lock_guard<std::mutex> lock{mutex};
+        uint64_t value = submittedValue + 1;
+
+        // the timeline signal comes first, the other signals follow
+        std::vector<VkSemaphore> signals{semaphore};
+        std::vector<uint64_t> signalValues{value};
+        for (const SemaphoreSubmit &signal : signalSemaphores)
+        {
+            signals.push_back(signal.semaphore);
+            signalValues.push_back(signal.value);
+        }
+
+        VkTimelineSemaphoreSubmitInfo timelineInfo{};
+        timelineInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+        timelineInfo.waitSemaphoreValueCount = static_cast<uint32_t>(waitValues.size());
+        timelineInfo.pWaitSemaphoreValues = waitValues.data();
+        timelineInfo.signalSemaphoreValueCount = static_cast<uint32_t>(signalValues.size());
+        timelineInfo.pSignalSemaphoreValues = signalValues.data();
+
+        VkSubmitInfo submitInfo{};
+        submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+        submitInfo.pNext = &timelineInfo;
+        submitInfo.waitSemaphoreCount = static_cast<uint32_t>(waits.size());
+        submitInfo.pWaitSemaphores = waits.data();
+        submitInfo.pWaitDstStageMask = waitStages.data();
+        submitInfo.commandBufferCount = static_cast<uint32_t>(commandBuffers.size());
+        submitInfo.pCommandBuffers = commandBuffers.data();
+        submitInfo.signalSemaphoreCount = static_cast<uint32_t>(signals.size());
+        submitInfo.pSignalSemaphores = signals.data();
+
+        LVE_TRACE_ZONE("vkQueueSubmit");
+        if (vkQueueSubmit(queue, 1, &submitInfo, fence) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to submit to queue!");
+        }
+        submittedValue = value;
+        return value;
+    }
+
+    uint64_t QueueTimeline::getSubmittedValue()
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        return submittedValue;
+    }
+
+    uint64_t QueueTimeline::getCompletedValue()
+    {
+        uint64_t value = 0;
+        vkGetSemaphoreCounterValue(device, semaphore, &value);
+        return value;
+    }
+
+    void QueueTimeline::wait(uint64_t value)
+    {
+        if (value == 0 || isComplete(value))
+            return;
+
+        LVE_TRACE_ZONE("QueueTimeline::wait");
+        VkSemaphoreWaitInfo waitInfo{};
+        waitInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+        waitInfo.semaphoreCount = 1;
+        waitInfo.pSemaphores = &semaphore;
+        waitInfo.pValues = &value;
+        vkWaitSemaphores(device, &waitInfo, std::numeric_limits<uint64_t>::max());
+    }
+} // namespace lve
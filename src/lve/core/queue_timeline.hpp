@@ -0,0 +1,58 @@
+#pragma once
+
+// libs
+#include <vulkan/vulkan.h>
+
+// std
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+namespace lve
+{
+    // semaphore a submission waits on or signals, value is ignored for binary semaphores
+    struct SemaphoreSubmit
+    {
+        VkSemaphore semaphore = VK_NULL_HANDLE;
+        uint64_t value = 0;
+        VkPipelineStageFlags stageMask = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT; // for waits
+    };
+
+    /*
+     * Timeline semaphore of one queue, every submission through submit() signals the next value
+     * Values complete in submission order, so "value N has completed" means every submission up to
+     * N on the queue is done. Subsystems keep the value of the submission that last used a
+     * resource and poll or wait for it, instead of keeping a fence per submission or frame.
+     */
+    class QueueTimeline
+    {
+    public:
+        QueueTimeline(VkDevice device, VkQueue queue);
+        ~QueueTimeline();
+
+        QueueTimeline(const QueueTimeline &) = delete;
+        QueueTimeline &operator=(const QueueTimeline &) = delete;
+
+        // submit to the queue and signal the next value, returns that value
+        uint64_t submit(
+            const std::vector<VkCommandBuffer> &commandBuffers,
+            const std::vector<SemaphoreSubmit> &waitSemaphores = {},
+            const std::vector<SemaphoreSubmit> &signalSemaphores = {},
+            VkFence fence = VK_NULL_HANDLE);
+
+        VkQueue getQueue() const { return queue; }
+        VkSemaphore getSemaphore() const { return semaphore; }
+        uint64_t getSubmittedValue();
+        uint64_t getCompletedValue();
+        bool isComplete(uint64_t value) { return value <= getCompletedValue(); }
+        void wait(uint64_t value);
+        void waitIdle() { wait(getSubmittedValue()); }
+
+    private:
+        VkDevice device;
+        VkQueue queue;
+        VkSemaphore semaphore = VK_NULL_HANDLE;
+        std::mutex mutex; // queue submissions need external synchronization
+        uint64_t submittedValue = 0;
+    };
+} // namespace lve
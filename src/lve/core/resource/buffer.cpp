@@ -6,11 +6,15 @@
  */
 
 #include "lve/core/resource/buffer.hpp"
+#include "lve/core/deletion_queue.hpp"
+#include "lve/core/upload_context.hpp"
 
 // std
+#include <algorithm>
 #include <cassert>
 #include <cstring>
 #include <stdexcept>
+#include <utility>
 
 namespace lve
 {
@@ -54,8 +58,13 @@ namespace lve
     Buffer::~Buffer()
     {
         unmap();
-        vkDestroyBuffer(lveDevice.device(), buffer, nullptr);
-        vkFreeMemory(lveDevice.device(), memory, nullptr);
+        // frames in flight may still read the buffer
+        lveDevice.getDeletionQueue().push(
+            [&device = lveDevice, buffer = buffer, memory = memory]() mutable
+            {
+                vkDestroyBuffer(device.device(), buffer, nullptr);
+                device.freeMemory(memory);
+            });
     }
 
     void Buffer::createBuffer(
@@ -63,7 +72,7 @@ namespace lve
         VkBufferUsageFlags usage,
         VkMemoryPropertyFlags properties,
         VkBuffer &buffer,
-        VkDeviceMemory &bufferMemory)
+        MemoryAllocation &bufferMemory)
     {
         VkBufferCreateInfo bufferInfo{};
         bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
@@ -79,22 +88,19 @@ namespace lve
         VkMemoryRequirements memRequirements;
         vkGetBufferMemoryRequirements(lveDevice.device(), buffer, &memRequirements);
 
-        VkMemoryAllocateInfo allocInfo{};
-        allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-        allocInfo.allocationSize = memRequirements.size;
-        allocInfo.memoryTypeIndex = lveDevice.findMemoryType(memRequirements.memoryTypeBits, properties);
-
-        if (vkAllocateMemory(lveDevice.device(), &allocInfo, nullptr, &bufferMemory) != VK_SUCCESS)
-        {
-            throw std::runtime_error("failed to allocate vertex buffer memory!");
-        }
-
-        vkBindBufferMemory(lveDevice.device(), buffer, bufferMemory, 0);
+        bufferMemory = lveDevice.allocateMemory(memRequirements, properties, MemoryResourceKind::LINEAR);
+        vkBindBufferMemory(
+            lveDevice.device(),
+            buffer,
+            VulkanMemoryBackend::toDeviceMemory(bufferMemory.memory),
+            bufferMemory.offset);
     }
 
     /**
      * Map a memory range of this buffer. If successful, mapped points to the specified buffer range.
      *
+     * @note Host visible blocks are mapped once by the allocator, this only points into that mapping
+     *
      * @param size (Optional) Size of the memory range to map. Pass VK_WHOLE_SIZE to map the complete
      * buffer range.
      * @param offset (Optional) Byte offset from beginning
@@ -103,37 +109,31 @@ namespace lve
      */
     VkResult Buffer::map(VkDeviceSize size, VkDeviceSize offset)
     {
-        assert(buffer && memory && "Called map on buffer before create");
-        return vkMapMemory(lveDevice.device(), memory, offset, size, 0, &mapped);
+        assert(buffer && memory.isValid() && "Called map on buffer before create");
+        if (memory.mapped == nullptr)
+            return VK_ERROR_MEMORY_MAP_FAILED; // not host visible
+        mapped = static_cast<char *>(memory.mapped) + offset;
+        return VK_SUCCESS;
     }
 
     /**
      * Unmap a mapped memory range
      *
-     * @note Does not return a result as vkUnmapMemory can't fail
+     * @note The block stays mapped as other buffers may share it
      */
     void Buffer::unmap()
     {
-        if (mapped)
-        {
-            vkUnmapMemory(lveDevice.device(), memory);
-            mapped = nullptr;
-        }
+        mapped = nullptr;
     }
 
-    void Buffer::copyBufferFrom(VkBuffer srcBuffer, VkDeviceSize size)
+    /**
+     * Queue a copy from srcBuffer into this buffer on the device's upload context
+     *
+     * @note Does not wait, the upload batch keeps srcBuffer alive until the copy has completed
+     */
+    void Buffer::copyBufferFrom(std::shared_ptr<Buffer> srcBuffer, VkDeviceSize size)
     {
-        VkCommandBuffer commandBuffer = lveDevice.beginSingleTimeCommands();
-
-        VkBufferCopy copyRegion{};
-        /* Optional
-        copyRegion.srcOffset = 0;
-        copyRegion.dstOffset = 0;
-        */
-        copyRegion.size = size;
-        vkCmdCopyBuffer(commandBuffer, srcBuffer, buffer, 1, &copyRegion);
-
-        lveDevice.endSingleTimeCommands(commandBuffer);
+        lveDevice.getUploadContext().copyBuffer(std::move(srcBuffer), buffer, size);
     }
 
     /**
@@ -152,13 +152,98 @@ namespace lve
         if (size == VK_WHOLE_SIZE)
         {
             memcpy(mapped, data, bufferSize);
+            markDirty(bufferSize, 0);
         }
         else
         {
             char *memOffset = (char *)mapped;
             memOffset += offset;
             memcpy(memOffset, data, size);
+            markDirty(size, offset);
+        }
+    }
+
+    /**
+     * Record a byte range as written since the last flushDirtyRanges call, overlapping or touching
+     * ranges are merged
+     *
+     * @param size Size of the range, VK_WHOLE_SIZE marks everything from offset to the end
+     * @param offset Byte offset from beginning
+     */
+    void Buffer::markDirty(VkDeviceSize size, VkDeviceSize offset)
+    {
+        if (size == VK_WHOLE_SIZE)
+            size = bufferSize - offset;
+        if (size == 0)
+            return;
+
+        VkDeviceSize begin = offset;
+        VkDeviceSize end = offset + size;
+
+        // first range that ends at or after the new begin, everything before it stays untouched
+        auto first = std::lower_bound(
+            dirtyRanges.begin(), dirtyRanges.end(), begin,
+            [](const DirtyRange &range, VkDeviceSize value) { return range.offset + range.size < value; });
+        auto last = first;
+        while (last != dirtyRanges.end() && last->offset <= end)
+        {
+            begin = std::min(begin, last->offset);
+            end = std::max(end, last->offset + last->size);
+            last++;
+        }
+
+        first = dirtyRanges.erase(first, last);
+        dirtyRanges.insert(first, DirtyRange{begin, end - begin});
+    }
+
+    /**
+     * Flush only the ranges written since the last call, in a single vkFlushMappedMemoryRanges call
+     *
+     * @note Ranges are widened to nonCoherentAtomSize. Host coherent memory needs no flush, the
+     * ranges are just cleared
+     *
+     * @return VkResult of the flush call
+     */
+    VkResult Buffer::flushDirtyRanges()
+    {
+        if (dirtyRanges.empty() || (memoryPropertyFlags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT))
+        {
+            dirtyRanges.clear();
+            return VK_SUCCESS;
         }
+
+        VkDeviceSize atomSize = lveDevice.properties.limits.nonCoherentAtomSize;
+        std::vector<VkMappedMemoryRange> mappedRanges;
+        mappedRanges.reserve(dirtyRanges.size());
+        for (const DirtyRange &range : dirtyRanges)
+        {
+            VkDeviceSize begin = range.offset / atomSize * atomSize;
+            VkDeviceSize end = (range.offset + range.size + atomSize - 1) / atomSize * atomSize;
+
+            // widening can make neighbouring ranges overlap again
+            if (!mappedRanges.empty() && begin <= mappedRanges.back().offset + mappedRanges.back().size)
+            {
+                mappedRanges.back().size = end - mappedRanges.back().offset;
+                continue;
+            }
+
+            VkMappedMemoryRange mappedRange = {};
+            mappedRange.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
+            mappedRange.memory = VulkanMemoryBackend::toDeviceMemory(memory.memory);
+            mappedRange.offset = begin;
+            mappedRange.size = end - begin;
+            mappedRanges.push_back(mappedRange);
+        }
+
+        // the allocation is atom aligned and sized, so widened ranges only need clamping to it
+        for (VkMappedMemoryRange &mappedRange : mappedRanges)
+        {
+            mappedRange.size = std::min(mappedRange.size, memory.size - mappedRange.offset);
+            mappedRange.offset += memory.offset;
+        }
+
+        dirtyRanges.clear();
+        return vkFlushMappedMemoryRanges(lveDevice.device(), static_cast<uint32_t>(mappedRanges.size()), mappedRanges.data());
     }
 
     /**
@@ -174,11 +259,7 @@ namespace lve
      */
     VkResult Buffer::flush(VkDeviceSize size, VkDeviceSize offset)
     {
-        VkMappedMemoryRange mappedRange = {};
-        mappedRange.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
-        mappedRange.memory = memory;
-        mappedRange.offset = offset;
-        mappedRange.size = size;
+        VkMappedMemoryRange mappedRange = getMappedMemoryRange(size, offset);
         return vkFlushMappedMemoryRanges(lveDevice.device(), 1, &mappedRange);
     }
 
@@ -194,13 +275,38 @@ namespace lve
      * @return VkResult of the invalidate call
      */
     VkResult Buffer::invalidate(VkDeviceSize size, VkDeviceSize offset)
+    {
+        VkMappedMemoryRange mappedRange = getMappedMemoryRange(size, offset);
+        return vkInvalidateMappedMemoryRanges(lveDevice.device(), 1, &mappedRange);
+    }
+
+    /**
+     * Translate a range of the buffer into a range of the shared memory block
+     *
+     * @note VK_WHOLE_SIZE ends at the end of this buffer's allocation, not of the block
+     */
+    VkMappedMemoryRange Buffer::getMappedMemoryRange(VkDeviceSize size, VkDeviceSize offset) const
     {
         VkMappedMemoryRange mappedRange = {};
         mappedRange.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
-        mappedRange.memory = memory;
-        mappedRange.offset = offset;
-        mappedRange.size = size;
-        return vkInvalidateMappedMemoryRanges(lveDevice.device(), 1, &mappedRange);
+        mappedRange.memory = VulkanMemoryBackend::toDeviceMemory(memory.memory);
+        mappedRange.offset = memory.offset + offset;
+        mappedRange.size = size == VK_WHOLE_SIZE ? memory.size - offset : size;
+        return mappedRange;
+    }
+
+    /**
+     * Describe the dirty ranges as copy regions into a buffer with the same layout
+     *
+     * @return One VkBufferCopy per dirty range, source and destination offsets are equal
+     */
+    std::vector<VkBufferCopy> Buffer::getDirtyCopyRegions() const
+    {
+        std::vector<VkBufferCopy> regions;
+        regions.reserve(dirtyRanges.size());
+        for (const DirtyRange &range : dirtyRanges)
+            regions.push_back(VkBufferCopy{range.offset, range.offset, range.size});
+        return regions;
     }
 
     /**
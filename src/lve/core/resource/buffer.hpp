@@ -2,6 +2,10 @@
 
 #include "lve/core/device.hpp"
 
+// std
+#include <memory>
+#include <vector>
+
 namespace lve
 {
 
@@ -25,12 +29,12 @@ namespace lve
             VkBufferUsageFlags usage,
             VkMemoryPropertyFlags properties,
             VkBuffer &buffer,
-            VkDeviceMemory &bufferMemory);
+            MemoryAllocation &bufferMemory);
 
         VkResult map(VkDeviceSize size = VK_WHOLE_SIZE, VkDeviceSize offset = 0);
         void unmap();
 
-        void copyBufferFrom(VkBuffer srcBuffer, VkDeviceSize size);
+        void copyBufferFrom(std::shared_ptr<Buffer> srcBuffer, VkDeviceSize size);
         void writeToBuffer(void *data, VkDeviceSize size = VK_WHOLE_SIZE, VkDeviceSize offset = 0);
         VkResult flush(VkDeviceSize size = VK_WHOLE_SIZE, VkDeviceSize offset = 0);
         VkDescriptorBufferInfo descriptorInfo(VkDeviceSize size = VK_WHOLE_SIZE, VkDeviceSize offset = 0);
@@ -40,12 +44,23 @@ namespace lve
         void setRecordedOffset(uint64_t offset) { recordedOffset = offset; }
         void addRecordedOffset(uint64_t offset) { recordedOffset += offset; }
 
+        // dirty range tracking: every write marks its byte range, flushDirtyRanges only flushes those
+        void markDirty(VkDeviceSize size, VkDeviceSize offset);
+        bool isDirty() const { return !dirtyRanges.empty(); }
+        VkResult flushDirtyRanges();
+        std::vector<VkBufferCopy> getDirtyCopyRegions() const; // dirty ranges at the same offset in a mirror buffer
+
+        // version of the data last written, lets callers skip uploads of unchanged data
+        uint64_t getContentVersion() const { return contentVersion; }
+        void setContentVersion(uint64_t version) { contentVersion = version; }
+
         void writeToIndex(void *data, int index);
         VkResult flushIndex(int index);
         VkDescriptorBufferInfo descriptorInfoForIndex(int index);
         VkResult invalidateIndex(int index);
 
         VkBuffer getBuffer() const { return buffer; }
+        const MemoryAllocation &getMemoryAllocation() const { return memory; }
         void *getMappedMemory() const { return mapped; }
         uint32_t getInstanceCount() const { return instanceCount; }
         VkDeviceSize getInstanceSize() const { return instanceSize; }
@@ -56,14 +71,23 @@ namespace lve
 
     private:
         static VkDeviceSize getAlignment(VkDeviceSize instanceSize, VkDeviceSize minOffsetAlignment);
+        VkMappedMemoryRange getMappedMemoryRange(VkDeviceSize size, VkDeviceSize offset) const;
 
         Device &lveDevice;
         void *mapped = nullptr;
         VkBuffer buffer = VK_NULL_HANDLE;
-        VkDeviceMemory memory = VK_NULL_HANDLE;
+        MemoryAllocation memory; // range of a pooled block, the buffer is bound at its offset
 
         uint64_t recordedOffset = 0;
 
+        struct DirtyRange
+        {
+            VkDeviceSize offset;
+            VkDeviceSize size;
+        };
+        std::vector<DirtyRange> dirtyRanges; // sorted by offset, never overlapping or touching
+        uint64_t contentVersion = 0;
+
         VkDeviceSize bufferSize;
         uint32_t instanceCount;
         VkDeviceSize instanceSize;
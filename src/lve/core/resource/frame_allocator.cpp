@@ -0,0 +1,73 @@
+#include "lve/core/resource/frame_allocator.hpp"
+#include "lve/util/stats.hpp"
+
+// std
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+namespace lve
+{
+    FrameAllocator::FrameAllocator(
+        Device &device,
+        VkDeviceSize frameSize,
+        VkBufferUsageFlags usageFlags)
+        : frameCount{device.getFramesInFlight()}
+    {
+        // every allocation may be bound as a dynamic uniform or storage buffer
+        const VkPhysicalDeviceLimits &limits = device.properties.limits;
+        alignment = std::max<VkDeviceSize>(
+            {limits.minUniformBufferOffsetAlignment, limits.minStorageBufferOffsetAlignment, 16});
+        this->frameSize = (frameSize + alignment - 1) / alignment * alignment;
+
+        buffer = std::make_unique<Buffer>(
+            device,
+            this->frameSize,
+            static_cast<uint32_t>(frameCount),
+            usageFlags,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+        buffer->map();
+    }
+
+    void FrameAllocator::beginFrame(int frameIndex)
+    {
+        if (frameIndex < 0 || frameIndex >= frameCount)
+            throw std::runtime_error("FrameAllocator frame index out of range: " + std::to_string(frameIndex));
+
+        LVE_STATS_RECORD("render/frame_allocator_bytes", getUsedSize()); // use of the previous frame
+        this->frameIndex = frameIndex;
+        head = frameIndex * frameSize;
+    }
+
+    FrameAllocation FrameAllocator::allocate(VkDeviceSize size)
+    {
+        VkDeviceSize offset = head;
+        VkDeviceSize end = offset + size;
+        if (end > (frameIndex + 1) * frameSize)
+        {
+            throw std::runtime_error(
+                "FrameAllocator partition of " + std::to_string(frameSize) + " bytes is exhausted");
+        }
+        head = (end + alignment - 1) / alignment * alignment;
+
+        FrameAllocation allocation;
+        allocation.buffer = buffer->getBuffer();
+        allocation.offset = offset;
+        allocation.size = size;
+        allocation.mapped = static_cast<char *>(buffer->getMappedMemory()) + offset;
+        return allocation;
+    }
+
+    FrameAllocation FrameAllocator::write(const void *data, VkDeviceSize size)
+    {
+        FrameAllocation allocation = allocate(size);
+        std::memcpy(allocation.mapped, data, size);
+        return allocation;
+    }
+
+    VkDescriptorBufferInfo FrameAllocator::descriptorInfo(VkDeviceSize range) const
+    {
+        return VkDescriptorBufferInfo{buffer->getBuffer(), 0, range};
+    }
+} // namespace lve
@@ -0,0 +1,67 @@
+#pragma once
+
+#include "lve/core/device.hpp"
+#include "lve/core/resource/buffer.hpp"
+
+// libs
+#include <vulkan/vulkan.h>
+
+// std
+#include <memory>
+
+namespace lve
+{
+    // range of the frame allocator's buffer, valid until the same frame slot begins again
+    struct FrameAllocation
+    {
+        VkBuffer buffer = VK_NULL_HANDLE;
+        VkDeviceSize offset = 0;
+        VkDeviceSize size = 0;
+        void *mapped = nullptr;
+
+        uint32_t dynamicOffset() const { return static_cast<uint32_t>(offset); }
+    };
+
+    /*
+     * Linear allocator for data written by the CPU once per frame (uniforms, transient vertices)
+     * One persistently mapped host visible buffer is split into a partition per frame in flight
+     * (Device::getFramesInFlight).
+     * Allocating bumps an offset inside the current frame's partition, and the whole partition is
+     * reclaimed by beginFrame() once the frame that last used it has completed. Descriptors point
+     * at the whole buffer as *_DYNAMIC types and select the allocation with its dynamic offset, so
+     * neither buffers nor descriptor sets are created per frame.
+     */
+    class FrameAllocator
+    {
+    public:
+        FrameAllocator(
+            Device &device,
+            VkDeviceSize frameSize,
+            VkBufferUsageFlags usageFlags);
+
+        FrameAllocator(const FrameAllocator &) = delete;
+        FrameAllocator &operator=(const FrameAllocator &) = delete;
+
+        // call once the frame slot's previous submission has completed, e.g. right after FrameManager::beginFrame
+        void beginFrame(int frameIndex);
+
+        // throws when the frame's partition is exhausted
+        FrameAllocation allocate(VkDeviceSize size);
+        FrameAllocation write(const void *data, VkDeviceSize size);
+
+        // descriptor for a dynamic binding reading range bytes at the dynamic offset
+        VkDescriptorBufferInfo descriptorInfo(VkDeviceSize range) const;
+
+        VkBuffer getBuffer() const { return buffer->getBuffer(); }
+        VkDeviceSize getFrameSize() const { return frameSize; }
+        VkDeviceSize getUsedSize() const { return head - frameIndex * frameSize; }
+
+    private:
+        std::unique_ptr<Buffer> buffer;
+        VkDeviceSize alignment;
+        VkDeviceSize frameSize; // partition size, a multiple of alignment
+        int frameCount;
+        int frameIndex = 0;
+        VkDeviceSize head = 0; // next free byte, absolute in the buffer
+    };
+} // namespace lve
@@ -1,4 +1,6 @@
 #include "lve/core/resource/image.hpp"
+#include "lve/core/deletion_queue.hpp"
+#include "lve/core/upload_context.hpp"
 
 // std
 #include <stdexcept>
@@ -21,7 +23,7 @@ namespace lve
             throw std::runtime_error("Failed to create image");
         }
 
-        allocateMemory(memPropertyFlags);
+        allocateMemory(memPropertyFlags, imageCreateInfo.tiling);
 
         initialized = true;
 
@@ -43,10 +45,12 @@ namespace lve
           extent{other.extent},
           imageViews{std::move(other.imageViews)},
           imageLayout{other.imageLayout},
+          accessMask{other.accessMask},
+          stageMask{other.stageMask},
           initialized{other.initialized}
     {
         other.image = nullptr;
-        other.imageMemory = nullptr;
+        other.imageMemory = MemoryAllocation{};
     }
 
     Image &Image::operator=(Image &&other)
@@ -65,12 +69,14 @@ namespace lve
             image = other.image;
             imageViews = std::move(other.imageViews);
             imageLayout = other.imageLayout;
+            accessMask = other.accessMask;
+            stageMask = other.stageMask;
             extent = other.extent;
             initialized = other.initialized;
 
             // Reset other object
             other.image = nullptr;
-            other.imageMemory = nullptr;
+            other.imageMemory = MemoryAllocation{};
         }
 
         return *this;
@@ -121,25 +127,34 @@ namespace lve
             throw std::runtime_error("Image must be initialized before converting layout");
         }
 
-        VkCommandBuffer commandBuffer = lveDevice.beginSingleTimeCommands();
+        // the next use is unknown, so everything after the barrier waits for it
+        VkPipelineStageFlags srcStageMask = stageMask;
+        VkImageMemoryBarrier imageMemoryBarrier = makeTransitionBarrier(
+            newLayout,
+            VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT,
+            VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+            false);
+        lveDevice.getUploadContext().imageBarrier(imageMemoryBarrier, srcStageMask, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT);
+    }
 
-        VkImageMemoryBarrier imageMemoryBarrier{};
-        imageMemoryBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-        imageMemoryBarrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-        imageMemoryBarrier.newLayout = newLayout;
-        imageMemoryBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-        imageMemoryBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-        imageMemoryBarrier.image = image;
-        imageMemoryBarrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-        imageMemoryBarrier.subresourceRange.baseMipLevel = 0;
-        imageMemoryBarrier.subresourceRange.levelCount = 1;
-        imageMemoryBarrier.subresourceRange.baseArrayLayer = 0;
-        imageMemoryBarrier.subresourceRange.layerCount = 1;
+    void Image::transition(
+        VkCommandBuffer commandBuffer,
+        VkImageLayout newLayout,
+        VkAccessFlags dstAccessMask,
+        VkPipelineStageFlags dstStageMask,
+        bool discardContents)
+    {
+        if (!initialized)
+        {
+            throw std::runtime_error("Image must be initialized before recording a transition");
+        }
 
+        VkPipelineStageFlags srcStageMask = stageMask;
+        VkImageMemoryBarrier imageMemoryBarrier = makeTransitionBarrier(newLayout, dstAccessMask, dstStageMask, discardContents);
         vkCmdPipelineBarrier(
             commandBuffer,
-            VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
-            VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+            srcStageMask,
+            dstStageMask,
             0,
             0,
             nullptr,
@@ -147,10 +162,34 @@ namespace lve
             nullptr,
             1,
             &imageMemoryBarrier);
+    }
 
-        lveDevice.endSingleTimeCommands(commandBuffer);
+    // barrier from the tracked state to newLayout, the tracked state becomes the one after it
+    VkImageMemoryBarrier Image::makeTransitionBarrier(
+        VkImageLayout newLayout,
+        VkAccessFlags dstAccessMask,
+        VkPipelineStageFlags dstStageMask,
+        bool discardContents)
+    {
+        VkImageMemoryBarrier imageMemoryBarrier{};
+        imageMemoryBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        imageMemoryBarrier.srcAccessMask = accessMask;
+        imageMemoryBarrier.dstAccessMask = dstAccessMask;
+        imageMemoryBarrier.oldLayout = discardContents ? VK_IMAGE_LAYOUT_UNDEFINED : imageLayout;
+        imageMemoryBarrier.newLayout = newLayout;
+        imageMemoryBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        imageMemoryBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        imageMemoryBarrier.image = image;
+        imageMemoryBarrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        imageMemoryBarrier.subresourceRange.baseMipLevel = 0;
+        imageMemoryBarrier.subresourceRange.levelCount = 1;
+        imageMemoryBarrier.subresourceRange.baseArrayLayer = 0;
+        imageMemoryBarrier.subresourceRange.layerCount = 1;
 
         imageLayout = newLayout;
+        accessMask = dstAccessMask;
+        stageMask = dstStageMask;
+        return imageMemoryBarrier;
     }
 
     VkDescriptorImageInfo Image::getDescriptorImageInfo(int imageViewId, VkSampler sampler) const
@@ -161,38 +200,48 @@ namespace lve
             .imageLayout = imageLayout};
     }
 
-    void Image::allocateMemory(VkMemoryPropertyFlags memPropertyFlags)
+    VkDescriptorImageInfo Image::getDescriptorImageInfo(int imageViewId, VkSampler sampler, VkImageLayout layout) const
+    {
+        return VkDescriptorImageInfo{
+            .sampler = sampler,
+            .imageView = getImageView(imageViewId),
+            .imageLayout = layout};
+    }
+
+    void Image::allocateMemory(VkMemoryPropertyFlags memPropertyFlags, VkImageTiling tiling)
     {
         VkMemoryRequirements memoryRequirements;
         vkGetImageMemoryRequirements(lveDevice.device(), image, &memoryRequirements);
 
-        VkMemoryAllocateInfo memoryAllocateInfo{};
-        memoryAllocateInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-        memoryAllocateInfo.allocationSize = memoryRequirements.size;
-        memoryAllocateInfo.memoryTypeIndex = lveDevice.findMemoryType(
-            memoryRequirements.memoryTypeBits,
-            memPropertyFlags);
-
-        if (vkAllocateMemory(lveDevice.device(), &memoryAllocateInfo, nullptr, &imageMemory) != VK_SUCCESS)
-        {
-            throw std::runtime_error("Failed to allocate image memory");
-        }
+        // optimal tiling images may not share a granularity page with linear resources
+        MemoryResourceKind kind = tiling == VK_IMAGE_TILING_OPTIMAL ? MemoryResourceKind::OPTIMAL : MemoryResourceKind::LINEAR;
+        imageMemory = lveDevice.allocateMemory(memoryRequirements, memPropertyFlags, kind);
 
-        vkBindImageMemory(lveDevice.device(), image, imageMemory, 0);
+        vkBindImageMemory(
+            lveDevice.device(),
+            image,
+            VulkanMemoryBackend::toDeviceMemory(imageMemory.memory),
+            imageMemory.offset);
     }
 
     void Image::cleanUp()
     {
-        if (!initialized)
+        if (!initialized || image == VK_NULL_HANDLE) // never created or moved from
         {
             return;
         }
 
-        for (auto imageView : imageViews)
-        {
-            vkDestroyImageView(lveDevice.device(), imageView.second, nullptr);
-        }
-        vkDestroyImage(lveDevice.device(), image, nullptr);
-        vkFreeMemory(lveDevice.device(), imageMemory, nullptr);
+        // frames in flight may still use the image, e.g. when it is replaced on a resize
+        lveDevice.getDeletionQueue().push(
+            [&device = lveDevice, imageViews = std::move(imageViews), image = image, imageMemory = imageMemory]() mutable
+            {
+                for (auto imageView : imageViews)
+                {
+                    vkDestroyImageView(device.device(), imageView.second, nullptr);
+                }
+                vkDestroyImage(device.device(), image, nullptr);
+                device.freeMemory(imageMemory);
+            });
+        imageViews.clear();
     }
 } // namespace lve
\ No newline at end of file
@@ -10,7 +10,7 @@
 
 namespace lve
 {
-    class Image // wrapper for VkImage, VkDeviceMemory, and VkImageView
+    class Image // wrapper for VkImage, its memory allocation, and VkImageView
     {
     public:
         Image(
@@ -35,25 +35,57 @@ namespace lve
 
         VkImageView getImageView(int id) const;
 
+        /*
+         * One time transition from the tracked layout, for setup outside of a frame
+         * Queued on the device's upload context, so it is recorded at the start of the next frame
+         * (or the next UploadContext::submit) rather than waited for.
+         */
         void convertLayout(VkImageLayout newLayout);
 
+        /*
+         * Record a barrier into commandBuffer that moves the image to newLayout and makes prior
+         * accesses visible to the next ones. The layout, access mask and stage of the last
+         * transition are tracked, so only the upcoming use has to be described.
+         * @param dstAccessMask: how the image is accessed next
+         * @param dstStageMask: stages of the next access
+         * @param discardContents: transition from UNDEFINED, for images that are fully overwritten
+         */
+        void transition(
+            VkCommandBuffer commandBuffer,
+            VkImageLayout newLayout,
+            VkAccessFlags dstAccessMask,
+            VkPipelineStageFlags dstStageMask,
+            bool discardContents = false);
+
+        VkImageLayout getLayout() const { return imageLayout; }
+
         VkImage getImage() const { return image; }
 
         VkExtent3D getExtent() const { return extent; }
 
         VkDescriptorImageInfo getDescriptorImageInfo(int imageViewId, VkSampler sampler) const;
+        // for descriptors used while the image is in a layout other than the current one
+        VkDescriptorImageInfo getDescriptorImageInfo(int imageViewId, VkSampler sampler, VkImageLayout layout) const;
 
     private:
-        void allocateMemory(VkMemoryPropertyFlags memPropertyFlags);
+        void allocateMemory(VkMemoryPropertyFlags memPropertyFlags, VkImageTiling tiling);
+        VkImageMemoryBarrier makeTransitionBarrier(
+            VkImageLayout newLayout,
+            VkAccessFlags dstAccessMask,
+            VkPipelineStageFlags dstStageMask,
+            bool discardContents);
 
         void cleanUp();
 
         Device &lveDevice;
-        VkDeviceMemory imageMemory;
+        MemoryAllocation imageMemory;
         VkImage image;
         VkExtent3D extent;
         std::unordered_map<int, VkImageView> imageViews;
         VkImageLayout imageLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        // access and stages of the last transition, the source scope of the next one
+        VkAccessFlags accessMask = 0;
+        VkPipelineStageFlags stageMask = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
         bool initialized = false;
     };
 } // namespace lve
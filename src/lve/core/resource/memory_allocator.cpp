@@ -0,0 +1,241 @@
+#include "lve/core/resource/memory_allocator.hpp"
+
+// std
+#include <algorithm>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+namespace lve
+{
+    namespace
+    {
+        uint64_t alignUp(uint64_t value, uint64_t alignment)
+        {
+            return (value + alignment - 1) & ~(alignment - 1);
+        }
+
+        bool isPowerOfTwo(uint64_t value) { return value != 0 && (value & (value - 1)) == 0; }
+    } // namespace
+
+    MemoryAllocator::MemoryAllocator(MemoryBackend &backend, uint64_t bufferImageGranularity, uint64_t blockSize)
+        : backend{backend}, bufferImageGranularity{bufferImageGranularity}, blockSize{blockSize}
+    {
+        if (blockSize == 0)
+            throw std::runtime_error("Memory allocator block size must be greater than 0");
+    }
+
+    MemoryAllocator::~MemoryAllocator()
+    {
+        for (auto &pool : pools)
+        {
+            for (std::unique_ptr<Block> &block : pool.second)
+                backend.freeBlock(block->info);
+        }
+    }
+
+    // a memory type has one pool, or two when linear and optimal resources have to be kept apart
+    uint32_t MemoryAllocator::getPoolKey(uint32_t memoryTypeIndex, MemoryResourceKind kind) const
+    {
+        bool separateOptimal = bufferImageGranularity > 1 && kind == MemoryResourceKind::OPTIMAL;
+        return memoryTypeIndex * 2 + (separateOptimal ? 1 : 0);
+    }
+
+    MemoryAllocation MemoryAllocator::allocate(uint32_t memoryTypeIndex, uint64_t size, uint64_t alignment, MemoryResourceKind kind)
+    {
+        if (size == 0)
+            throw std::runtime_error("Cannot allocate 0 bytes of device memory");
+        if (!isPowerOfTwo(alignment))
+            throw std::runtime_error("Memory alignment must be a power of two, got " + std::to_string(alignment));
+
+        std::lock_guard<std::mutex> lock{mutex};
+        uint64_t minAlignment = backend.getMinAlignment(memoryTypeIndex);
+        alignment = std::max(alignment, minAlignment);
+        size = alignUp(size, minAlignment); // non coherent flushes of whole atoms stay inside the allocation
+        uint32_t poolKey = getPoolKey(memoryTypeIndex, kind);
+
+        MemoryAllocation allocation{};
+        if (size > blockSize / 2)
+        {
+            Block *block = createBlock(poolKey, size, size, true);
+            allocateFromBlock(*block, size, alignment, allocation);
+            return allocation;
+        }
+
+        for (std::unique_ptr<Block> &block : pools[poolKey])
+        {
+            if (!block->isDedicated && allocateFromBlock(*block, size, alignment, allocation))
+                return allocation;
+        }
+
+        Block *block = createBlock(poolKey, blockSize, size, false);
+        allocateFromBlock(*block, size, alignment, allocation);
+        return allocation;
+    }
+
+    void MemoryAllocator::free(MemoryAllocation &allocation)
+    {
+        if (!allocation.isValid())
+            return;
+
+        std::lock_guard<std::mutex> lock{mutex};
+        Block *block = static_cast<Block *>(allocation.block);
+
+        // give the range back and merge it with touching free ranges
+        uint64_t offset = allocation.offset;
+        uint64_t size = allocation.size;
+        auto next = block->freeRanges.lower_bound(offset);
+        if (next != block->freeRanges.end() && offset + size == next->first)
+        {
+            size += next->second;
+            next = block->freeRanges.erase(next);
+        }
+        if (next != block->freeRanges.begin())
+        {
+            auto previous = std::prev(next);
+            if (previous->first + previous->second == offset)
+            {
+                offset = previous->first;
+                size += previous->second;
+                block->freeRanges.erase(previous);
+            }
+        }
+        block->freeRanges[offset] = size;
+
+        block->usedBytes -= allocation.size;
+        block->allocationCount--;
+        allocation = MemoryAllocation{};
+
+        if (block->allocationCount > 0)
+            return;
+        if (block->isDedicated)
+        {
+            destroyBlock(block);
+            return;
+        }
+
+        // keep a single empty block per pool
+        for (std::unique_ptr<Block> &other : pools[block->poolKey])
+        {
+            if (other.get() != block && !other->isDedicated && other->allocationCount == 0)
+            {
+                destroyBlock(block);
+                return;
+            }
+        }
+    }
+
+    /*
+     * Halves the block size on out of memory, down to the size of the allocation that needs it
+     * @param minSize: smallest acceptable block
+     */
+    MemoryAllocator::Block *MemoryAllocator::createBlock(uint32_t poolKey, uint64_t size, uint64_t minSize, bool isDedicated)
+    {
+        uint32_t memoryTypeIndex = getMemoryTypeIndex(poolKey);
+        MemoryBlockInfo info{};
+        while (!backend.allocateBlock(memoryTypeIndex, size, info))
+        {
+            if (size == minSize)
+            {
+                throw std::runtime_error(
+                    "Out of device memory: " + std::to_string(size) + " bytes of memory type " + std::to_string(memoryTypeIndex));
+            }
+            size = std::max(size / 2, minSize);
+        }
+        backendAllocationCount++;
+
+        auto block = std::make_unique<Block>();
+        block->info = info;
+        block->size = size;
+        block->isDedicated = isDedicated;
+        block->poolKey = poolKey;
+        block->freeRanges[0] = size;
+
+        Block *blockPtr = block.get();
+        pools[poolKey].push_back(std::move(block));
+        return blockPtr;
+    }
+
+    void MemoryAllocator::destroyBlock(Block *block)
+    {
+        std::vector<std::unique_ptr<Block>> &pool = pools[block->poolKey];
+        auto it = std::find_if(pool.begin(), pool.end(), [block](const std::unique_ptr<Block> &b) { return b.get() == block; });
+        backend.freeBlock(block->info);
+        pool.erase(it);
+    }
+
+    // best fit: the free range that leaves the least space after placing the aligned allocation
+    bool MemoryAllocator::allocateFromBlock(Block &block, uint64_t size, uint64_t alignment, MemoryAllocation &allocation)
+    {
+        auto bestRange = block.freeRanges.end();
+        uint64_t bestOffset = 0;
+        uint64_t bestWaste = UINT64_MAX;
+        for (auto it = block.freeRanges.begin(); it != block.freeRanges.end(); ++it)
+        {
+            uint64_t alignedOffset = alignUp(it->first, alignment);
+            uint64_t rangeEnd = it->first + it->second;
+            if (alignedOffset + size > rangeEnd)
+                continue;
+
+            uint64_t waste = it->second - size;
+            if (waste < bestWaste)
+            {
+                bestRange = it;
+                bestOffset = alignedOffset;
+                bestWaste = waste;
+            }
+        }
+        if (bestRange == block.freeRanges.end())
+            return false;
+
+        // the alignment padding in front and the rest behind stay free
+        uint64_t rangeOffset = bestRange->first;
+        uint64_t rangeEnd = bestRange->first + bestRange->second;
+        block.freeRanges.erase(bestRange);
+        if (bestOffset > rangeOffset)
+            block.freeRanges[rangeOffset] = bestOffset - rangeOffset;
+        if (bestOffset + size < rangeEnd)
+            block.freeRanges[bestOffset + size] = rangeEnd - (bestOffset + size);
+
+        block.usedBytes += size;
+        block.allocationCount++;
+
+        allocation.memory = block.info.handle;
+        allocation.offset = bestOffset;
+        allocation.size = size;
+        allocation.mapped = block.info.mapped == nullptr ? nullptr : static_cast<char *>(block.info.mapped) + bestOffset;
+        allocation.block = &block;
+        return true;
+    }
+
+    MemoryAllocatorStats MemoryAllocator::getStats() const
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        MemoryAllocatorStats stats{};
+        stats.backendAllocationCount = backendAllocationCount;
+        for (const auto &pool : pools)
+        {
+            for (const std::unique_ptr<Block> &block : pool.second)
+            {
+                stats.blockCount++;
+                stats.dedicatedBlockCount += block->isDedicated ? 1 : 0;
+                stats.allocationCount += block->allocationCount;
+                stats.reservedBytes += block->size;
+                stats.usedBytes += block->usedBytes;
+                for (const auto &range : block->freeRanges)
+                    stats.largestFreeRange = std::max(stats.largestFreeRange, range.second);
+            }
+        }
+        return stats;
+    }
+
+    void MemoryAllocator::printStats() const
+    {
+        MemoryAllocatorStats stats = getStats();
+        const double MIB = 1024.0 * 1024.0;
+        std::cout << "  device memory: " << stats.allocationCount << " allocations in " << stats.blockCount << " blocks ("
+                  << stats.dedicatedBlockCount << " dedicated), " << stats.usedBytes / MIB << " / " << stats.reservedBytes / MIB
+                  << " MiB used, largest free range " << stats.largestFreeRange / MIB << " MiB, "
+                  << stats.backendAllocationCount << " driver allocations so far" << std::endl;
+    }
+} // namespace lve
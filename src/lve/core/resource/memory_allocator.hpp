@@ -0,0 +1,124 @@
+#pragma once
+
+// std
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace lve
+{
+    // device memory block as seen by MemoryAllocator, handle is the VkDeviceMemory on the Vulkan backend
+    struct MemoryBlockInfo
+    {
+        uint64_t handle = 0;
+        void *mapped = nullptr; // persistent mapping of host visible blocks, nullptr otherwise
+    };
+
+    /*
+     * Source of the large blocks MemoryAllocator sub-allocates from
+     * Kept free of Vulkan types so the pooling logic runs against a mock backend on the CPU
+     * (tests/mock_memory_backend.hpp).
+     */
+    class MemoryBackend
+    {
+    public:
+        virtual ~MemoryBackend() = default;
+
+        // false when the memory type is out of memory
+        virtual bool allocateBlock(uint32_t memoryTypeIndex, uint64_t size, MemoryBlockInfo &block) = 0;
+        virtual void freeBlock(const MemoryBlockInfo &block) = 0;
+
+        // alignment every sub-allocation of the type must have, e.g. nonCoherentAtomSize for non coherent host memory
+        virtual uint64_t getMinAlignment(uint32_t memoryTypeIndex) const = 0;
+    };
+
+    // how a resource uses its memory, linear and optimal resources must respect bufferImageGranularity
+    enum class MemoryResourceKind
+    {
+        LINEAR, // buffers and linear tiling images
+        OPTIMAL // optimal tiling images
+    };
+
+    struct MemoryAllocation
+    {
+        uint64_t memory = 0; // block handle, VkDeviceMemory on the Vulkan backend
+        uint64_t offset = 0;
+        uint64_t size = 0;
+        void *mapped = nullptr; // points at offset, nullptr unless host visible
+
+        bool isValid() const { return memory != 0; }
+
+        // owning block, only used by MemoryAllocator
+        void *block = nullptr;
+    };
+
+    struct MemoryAllocatorStats
+    {
+        uint64_t blockCount = 0;
+        uint64_t dedicatedBlockCount = 0; // blocks holding a single large allocation
+        uint64_t allocationCount = 0;
+        uint64_t reservedBytes = 0; // sum of the block sizes
+        uint64_t usedBytes = 0;     // sum of the allocation sizes
+        uint64_t largestFreeRange = 0;
+        uint64_t backendAllocationCount = 0; // allocateBlock calls so far
+    };
+
+    /*
+     * Pooled device memory: resources are placed into large blocks per memory type instead of getting
+     * one driver allocation each
+     * Free space of a block is a list of ranges sorted by offset, allocations take the best fitting
+     * range and freed ranges are merged with their neighbors. Allocations larger than half a block
+     * get a dedicated block. One empty block per pool is kept, so recreating a resource (e.g. on
+     * resize) does not go back to the driver. When bufferImageGranularity is larger than 1, linear
+     * and optimal resources are pooled separately so they never share a granularity page.
+     */
+    class MemoryAllocator
+    {
+    public:
+        static constexpr uint64_t DEFAULT_BLOCK_SIZE = 64ull * 1024 * 1024;
+
+        MemoryAllocator(MemoryBackend &backend, uint64_t bufferImageGranularity, uint64_t blockSize = DEFAULT_BLOCK_SIZE);
+        ~MemoryAllocator();
+
+        MemoryAllocator(const MemoryAllocator &) = delete;
+        MemoryAllocator &operator=(const MemoryAllocator &) = delete;
+
+        /*
+         * @param alignment: power of two, from the resource's memory requirements
+         * @throws std::runtime_error if the backend is out of memory
+         */
+        MemoryAllocation allocate(uint32_t memoryTypeIndex, uint64_t size, uint64_t alignment, MemoryResourceKind kind);
+        void free(MemoryAllocation &allocation); // resets allocation, invalid allocations are ignored
+
+        MemoryAllocatorStats getStats() const;
+        void printStats() const;
+
+    private:
+        struct Block
+        {
+            MemoryBlockInfo info;
+            uint64_t size;
+            uint64_t usedBytes = 0;
+            uint32_t allocationCount = 0;
+            bool isDedicated = false;
+            uint32_t poolKey;
+            std::map<uint64_t, uint64_t> freeRanges; // offset -> size
+        };
+
+        uint32_t getPoolKey(uint32_t memoryTypeIndex, MemoryResourceKind kind) const;
+        uint32_t getMemoryTypeIndex(uint32_t poolKey) const { return poolKey / 2; }
+        Block *createBlock(uint32_t poolKey, uint64_t size, uint64_t minSize, bool isDedicated);
+        void destroyBlock(Block *block);
+        bool allocateFromBlock(Block &block, uint64_t size, uint64_t alignment, MemoryAllocation &allocation);
+
+        MemoryBackend &backend;
+        uint64_t bufferImageGranularity;
+        uint64_t blockSize;
+
+        mutable std::mutex mutex;
+        std::map<uint32_t, std::vector<std::unique_ptr<Block>>> pools;
+        uint64_t backendAllocationCount = 0;
+    };
+} // namespace lve
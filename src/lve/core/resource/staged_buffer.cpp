@@ -0,0 +1,76 @@
+#include "lve/core/resource/staged_buffer.hpp"
+
+// std
+#include <vector>
+
+namespace lve
+{
+    StagedBuffer::StagedBuffer(Device &device, VkDeviceSize size, VkBufferUsageFlags usageFlags, bool direct)
+        : direct{direct}
+    {
+        if (direct)
+        {
+            hostBuffer = std::make_unique<Buffer>(
+                device,
+                size,
+                1,
+                usageFlags,
+                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+        }
+        else
+        {
+            hostBuffer = std::make_unique<Buffer>(
+                device,
+                size,
+                1,
+                VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+            deviceBuffer = std::make_unique<Buffer>(
+                device,
+                size,
+                1,
+                usageFlags | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+        }
+        hostBuffer->map();
+    }
+
+    bool StagedBuffer::recordUpload(VkCommandBuffer cmdBuffer, VkPipelineStageFlags dstStageMask)
+    {
+        if (!hostBuffer->isDirty())
+            return false;
+
+        std::vector<VkBufferCopy> regions = hostBuffer->getDirtyCopyRegions();
+        hostBuffer->flushDirtyRanges();
+        if (direct)
+            return false;
+
+        vkCmdCopyBuffer(
+            cmdBuffer,
+            hostBuffer->getBuffer(),
+            deviceBuffer->getBuffer(),
+            static_cast<uint32_t>(regions.size()),
+            regions.data());
+
+        // host writes are made visible to the copy by the queue submission itself
+        VkBufferMemoryBarrier barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.buffer = deviceBuffer->getBuffer();
+        barrier.offset = 0;
+        barrier.size = VK_WHOLE_SIZE;
+
+        vkCmdPipelineBarrier(
+            cmdBuffer,
+            VK_PIPELINE_STAGE_TRANSFER_BIT,
+            dstStageMask,
+            0,
+            0, nullptr,
+            1, &barrier,
+            0, nullptr);
+        return true;
+    }
+} // namespace lve
@@ -0,0 +1,48 @@
+#pragma once
+
+#include "lve/core/device.hpp"
+#include "lve/core/resource/buffer.hpp"
+
+// libs
+#include <vulkan/vulkan.h>
+
+// std
+#include <memory>
+
+namespace lve
+{
+    /*
+     * Buffer the GPU reads from device local memory, written by the CPU through a persistently
+     * mapped host buffer of the same layout
+     * Writes go to getHostBuffer(), recordUpload() then copies only the dirty ranges into the device
+     * buffer and makes them visible to the shaders. In direct mode (e.g. on unified memory devices)
+     * the host buffer is bound as is and recordUpload() only flushes it.
+     */
+    class StagedBuffer
+    {
+    public:
+        StagedBuffer(Device &device, VkDeviceSize size, VkBufferUsageFlags usageFlags, bool direct);
+
+        StagedBuffer(const StagedBuffer &) = delete;
+        StagedBuffer &operator=(const StagedBuffer &) = delete;
+
+        /*
+         * Record the copy of everything written since the last upload, must be outside a render pass
+         * @param dstStageMask: stages reading the buffer afterwards
+         * @return whether a copy was recorded
+         */
+        bool recordUpload(
+            VkCommandBuffer cmdBuffer,
+            VkPipelineStageFlags dstStageMask = VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);
+
+        Buffer &getHostBuffer() { return *hostBuffer; }
+        Buffer &getDeviceBuffer() { return direct ? *hostBuffer : *deviceBuffer; }
+        VkDescriptorBufferInfo descriptorInfo() { return getDeviceBuffer().descriptorInfo(); }
+        bool isDirect() const { return direct; }
+
+    private:
+        bool direct;
+        std::unique_ptr<Buffer> hostBuffer;
+        std::unique_ptr<Buffer> deviceBuffer;
+    };
+} // namespace lve
@@ -0,0 +1,53 @@
+#include "lve/core/resource/vulkan_memory_backend.hpp"
+
+// std
+#include <stdexcept>
+
+namespace lve
+{
+    VulkanMemoryBackend::VulkanMemoryBackend(
+        VkDevice device, const VkPhysicalDeviceMemoryProperties &memoryProperties, VkDeviceSize nonCoherentAtomSize)
+        : device{device}, memoryProperties{memoryProperties}, nonCoherentAtomSize{nonCoherentAtomSize}
+    {
+    }
+
+    bool VulkanMemoryBackend::allocateBlock(uint32_t memoryTypeIndex, uint64_t size, MemoryBlockInfo &block)
+    {
+        VkMemoryAllocateInfo allocInfo{};
+        allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+        allocInfo.allocationSize = size;
+        allocInfo.memoryTypeIndex = memoryTypeIndex;
+
+        VkDeviceMemory memory;
+        VkResult result = vkAllocateMemory(device, &allocInfo, nullptr, &memory);
+        if (result == VK_ERROR_OUT_OF_DEVICE_MEMORY || result == VK_ERROR_OUT_OF_HOST_MEMORY)
+            return false;
+        if (result != VK_SUCCESS)
+            throw std::runtime_error("failed to allocate device memory block!");
+
+        block.handle = (uint64_t)memory;
+        block.mapped = nullptr;
+        if (memoryProperties.memoryTypes[memoryTypeIndex].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT)
+        {
+            if (vkMapMemory(device, memory, 0, VK_WHOLE_SIZE, 0, &block.mapped) != VK_SUCCESS)
+            {
+                vkFreeMemory(device, memory, nullptr);
+                throw std::runtime_error("failed to map device memory block!");
+            }
+        }
+        return true;
+    }
+
+    void VulkanMemoryBackend::freeBlock(const MemoryBlockInfo &block)
+    {
+        // freeing implicitly unmaps
+        vkFreeMemory(device, toDeviceMemory(block.handle), nullptr);
+    }
+
+    uint64_t VulkanMemoryBackend::getMinAlignment(uint32_t memoryTypeIndex) const
+    {
+        VkMemoryPropertyFlags flags = memoryProperties.memoryTypes[memoryTypeIndex].propertyFlags;
+        bool isNonCoherent = (flags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) && !(flags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+        return isNonCoherent ? nonCoherentAtomSize : 1;
+    }
+} // namespace lve
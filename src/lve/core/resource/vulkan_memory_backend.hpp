@@ -0,0 +1,27 @@
+#pragma once
+
+#include "lve/core/resource/memory_allocator.hpp"
+
+// libs
+#include <vulkan/vulkan.h>
+
+namespace lve
+{
+    // MemoryAllocator blocks as VkDeviceMemory, host visible blocks stay mapped for their lifetime
+    class VulkanMemoryBackend : public MemoryBackend
+    {
+    public:
+        VulkanMemoryBackend(VkDevice device, const VkPhysicalDeviceMemoryProperties &memoryProperties, VkDeviceSize nonCoherentAtomSize);
+
+        bool allocateBlock(uint32_t memoryTypeIndex, uint64_t size, MemoryBlockInfo &block) override;
+        void freeBlock(const MemoryBlockInfo &block) override;
+        uint64_t getMinAlignment(uint32_t memoryTypeIndex) const override;
+
+        static VkDeviceMemory toDeviceMemory(uint64_t handle) { return (VkDeviceMemory)handle; }
+
+    private:
+        VkDevice device;
+        VkPhysicalDeviceMemoryProperties memoryProperties;
+        VkDeviceSize nonCoherentAtomSize;
+    };
+} // namespace lve
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "lve/core/device.hpp"
+#include "lve/core/queue_timeline.hpp"
 #include "lve/core/resource/image.hpp"
 
 // libs
@@ -14,11 +15,14 @@
 namespace lve
 {
 
+    /*
+     * Frames are paced by the graphics queue's timeline: every submitted frame records the value it
+     * signals for its frame slot and swap chain image, and a slot or image is reused once that value
+     * has completed. The number of slots is Device::getFramesInFlight().
+     */
     class SwapChain
     {
     public:
-        static constexpr int MAX_FRAMES_IN_FLIGHT = 2;
-
         SwapChain(Device &deviceRef, VkExtent2D windowExtent);
         SwapChain(
             Device &deviceRef, VkExtent2D windowExtent, std::shared_ptr<SwapChain> previous);
@@ -31,6 +35,8 @@ namespace lve
         VkFramebuffer getFrameBuffer(int index) { return swapChainFramebuffers[index]; }
         VkRenderPass getRenderPass() { return renderPass; }
         VkImageView getSwapChainImageView(int index) { return swapChainImageViews[index]; }
+        VkImage getSwapChainImage(int index) { return swapChainImages[index]; }
+        bool supportsImageCopy() const { return canCopyImages; } // images can be a transfer source, e.g. for frame capture
         size_t imageCount() { return swapChainImages.size(); }
         VkFormat getSwapChainImageFormat() { return swapChainImageFormat; }
         VkExtent2D getSwapChainExtent() { return swapChainExtent; }
@@ -42,7 +48,11 @@ namespace lve
         VkFormat findDepthFormat();
 
         VkResult acquireNextImage(uint32_t *imageIndex);
-        VkResult submitCommandBuffers(const VkCommandBuffer *buffers, uint32_t *imageIndex);
+        // the submission also waits on extraWaitSemaphores, e.g. transfers acquired by the frame
+        VkResult submitCommandBuffers(
+            const VkCommandBuffer *buffers,
+            uint32_t *imageIndex,
+            const std::vector<SemaphoreSubmit> &extraWaitSemaphores = {});
 
         bool compareSwapFormats(const SwapChain &swapChain) const
         {
@@ -68,6 +78,7 @@ namespace lve
 
         VkFormat swapChainImageFormat;
         VkFormat swapChainDepthFormat;
+        bool canCopyImages = false;
         VkExtent2D swapChainExtent;
 
         std::vector<VkFramebuffer> swapChainFramebuffers;
@@ -85,8 +96,8 @@ namespace lve
 
         std::vector<VkSemaphore> imageAvailableSemaphores;
         std::vector<VkSemaphore> renderFinishedSemaphores;
-        std::vector<VkFence> inFlightFences;
-        std::vector<VkFence> imagesInFlight;
+        std::vector<uint64_t> frameValues; // per frame slot, the graphics timeline value of its last submission
+        std::vector<uint64_t> imageValues; // per swap chain image
         size_t currentFrame = 0;
     };
 
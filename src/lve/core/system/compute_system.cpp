@@ -1,23 +1,27 @@
 #include "lve/core/system/compute_system.hpp"
+#include "lve/core/deletion_queue.hpp"
 
 // std
 #include <cassert>
+#include <utility>
 
 namespace lve
 {
     ComputeSystem::ComputeSystem(
         Device &device,
         std::vector<VkDescriptorSetLayout> descriptorSetLayouts,
-        const std::string &compFilepath)
+        const std::string &compFilepath,
+        std::shared_ptr<const std::vector<char>> compCode)
         : lveDevice{device}
     {
         createComputePipelineLayout(descriptorSetLayouts);
-        createComputePipeline(compFilepath);
+        createComputePipeline(compFilepath, std::move(compCode));
+        initialized = true;
     }
 
     ComputeSystem::~ComputeSystem()
     {
-        vkDestroyPipelineLayout(lveDevice.device(), computePipelineLayout, nullptr);
+        cleanUp();
     }
 
     ComputeSystem::ComputeSystem(ComputeSystem &&other) noexcept
@@ -55,7 +59,8 @@ namespace lve
     void ComputeSystem::dispatchComputePipeline(
         VkCommandBuffer cmdBuffer,
         const VkDescriptorSet *pGlobalDescriptorSet,
-        uint32_t width, uint32_t height)
+        uint32_t width, uint32_t height,
+        const std::vector<uint32_t> &dynamicOffsets)
     {
         vkCmdBindPipeline(cmdBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, lveComputePipeline->getPipeline());
         vkCmdBindDescriptorSets(
@@ -65,16 +70,18 @@ namespace lve
             0,
             1,
             pGlobalDescriptorSet,
-            0,
-            nullptr);
+            static_cast<uint32_t>(dynamicOffsets.size()),
+            dynamicOffsets.data());
         vkCmdDispatch(cmdBuffer, width, height, 1);
     }
 
     void ComputeSystem::cleanUp()
     {
-        if (initialized)
+        if (initialized && computePipelineLayout != VK_NULL_HANDLE)
         {
-            vkDestroyPipelineLayout(lveDevice.device(), computePipelineLayout, nullptr);
+            lveDevice.getDeletionQueue().push(
+                [device = lveDevice.device(), computePipelineLayout = computePipelineLayout]()
+                { vkDestroyPipelineLayout(device, computePipelineLayout, nullptr); });
         }
     }
 
@@ -93,12 +100,13 @@ namespace lve
         }
     }
 
-    void ComputeSystem::createComputePipeline(const std::string &compFilepath)
+    void ComputeSystem::createComputePipeline(const std::string &compFilepath, std::shared_ptr<const std::vector<char>> compCode)
     {
         assert(computePipelineLayout != nullptr && "Cannot create pipeline before pipeline layout");
 
         ComputePipelineConfigInfo computePipelineConfig{};
         computePipelineConfig.pipelineLayout = computePipelineLayout;
+        computePipelineConfig.compCode = std::move(compCode);
         lveComputePipeline = std::make_unique<ComputePipeline>(
             lveDevice,
             compFilepath,
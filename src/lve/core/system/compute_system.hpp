@@ -16,7 +16,8 @@ namespace lve
         ComputeSystem(
             Device &device,
             std::vector<VkDescriptorSetLayout> descriptorSetLayouts,
-            const std::string &compFilepath);
+            const std::string &compFilepath,
+            std::shared_ptr<const std::vector<char>> compCode = nullptr); // SPIR-V of compFilepath if already read
         ComputeSystem(Device &device) : lveDevice(device) {}
         ~ComputeSystem();
 
@@ -29,13 +30,14 @@ namespace lve
         void dispatchComputePipeline(
             VkCommandBuffer cmdBuffer,
             const VkDescriptorSet *pGlobalDescriptorSet,
-            uint32_t width, uint32_t height);
+            uint32_t width, uint32_t height,
+            const std::vector<uint32_t> &dynamicOffsets = {});
 
     private:
         void cleanUp();
 
         void createComputePipelineLayout(std::vector<VkDescriptorSetLayout> descriptorSetLayouts);
-        void createComputePipeline(const std::string &compFilepath);
+        void createComputePipeline(const std::string &compFilepath, std::shared_ptr<const std::vector<char>> compCode);
 
         Device &lveDevice;
         std::unique_ptr<ComputePipeline> lveComputePipeline;
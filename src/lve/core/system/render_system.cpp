@@ -1,4 +1,5 @@
 #include "lve/core/system/render_system.hpp"
+#include "lve/core/deletion_queue.hpp"
 #include "lve/core/pipeline/pipeline_op.hpp"
 
 // libs
@@ -25,12 +26,20 @@ namespace lve
         glm::vec2 screenExtent;
     };
 
+    struct InstancedQuadPushConstantData
+    {
+        glm::vec2 screenExtent;
+        float quadRadius;
+        float quadDepth;
+    };
+
     void renderGameObjects(
         VkCommandBuffer cmdBuffer,
         const VkDescriptorSet *pGlobalDescriptorSet,
         GameObject::Map &gameObjects,
         VkPipelineLayout graphicPipelineLayout,
-        GraphicPipeline *graphicPipeline)
+        GraphicPipeline *graphicPipeline,
+        const std::vector<uint32_t> &dynamicOffsets)
     {
         bind(cmdBuffer, graphicPipeline->getPipeline());
 
@@ -41,8 +50,8 @@ namespace lve
             0,
             1,
             pGlobalDescriptorSet,
-            0,
-            nullptr);
+            static_cast<uint32_t>(dynamicOffsets.size()),
+            dynamicOffsets.data());
 
         for (auto &kv : gameObjects)
         {
@@ -70,7 +79,8 @@ namespace lve
         const VkDescriptorSet *pGlobalDescriptorSet,
         VkPipelineLayout graphicPipelineLayout,
         GraphicPipeline *graphicPipeline,
-        VkExtent2D extent)
+        VkExtent2D extent,
+        const std::vector<uint32_t> &dynamicOffsets)
     {
         bind(cmdBuffer, graphicPipeline->getPipeline());
 
@@ -81,8 +91,8 @@ namespace lve
             0,
             1,
             pGlobalDescriptorSet,
-            0,
-            nullptr);
+            static_cast<uint32_t>(dynamicOffsets.size()),
+            dynamicOffsets.data());
 
         ScreenExtentPushConstantData push{};
         push.screenExtent = glm::vec2(extent.width, extent.height);
@@ -98,13 +108,20 @@ namespace lve
         vkCmdDraw(cmdBuffer, 6, 1, 0, 0);
     }
 
-    void renderLines(
+    void renderInstancedQuads(
         VkCommandBuffer cmdBuffer,
         const VkDescriptorSet *pGlobalDescriptorSet,
         VkPipelineLayout graphicPipelineLayout,
         GraphicPipeline *graphicPipeline,
-        LineCollection &lineCollection)
+        VkExtent2D extent,
+        float quadRadius,
+        float quadDepth,
+        uint32_t instanceCount,
+        const std::vector<uint32_t> &dynamicOffsets)
     {
+        if (instanceCount == 0)
+            return;
+
         bind(cmdBuffer, graphicPipeline->getPipeline());
 
         vkCmdBindDescriptorSets(
@@ -114,8 +131,44 @@ namespace lve
             0,
             1,
             pGlobalDescriptorSet,
+            static_cast<uint32_t>(dynamicOffsets.size()),
+            dynamicOffsets.data());
+
+        InstancedQuadPushConstantData push{};
+        push.screenExtent = glm::vec2(extent.width, extent.height);
+        push.quadRadius = quadRadius;
+        push.quadDepth = quadDepth;
+
+        vkCmdPushConstants(
+            cmdBuffer,
+            graphicPipelineLayout,
+            VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
             0,
-            nullptr);
+            sizeof(InstancedQuadPushConstantData),
+            &push);
+
+        vkCmdDraw(cmdBuffer, 6, instanceCount, 0, 0);
+    }
+
+    void renderLines(
+        VkCommandBuffer cmdBuffer,
+        const VkDescriptorSet *pGlobalDescriptorSet,
+        VkPipelineLayout graphicPipelineLayout,
+        GraphicPipeline *graphicPipeline,
+        LineCollection &lineCollection,
+        const std::vector<uint32_t> &dynamicOffsets)
+    {
+        bind(cmdBuffer, graphicPipeline->getPipeline());
+
+        vkCmdBindDescriptorSets(
+            cmdBuffer,
+            VK_PIPELINE_BIND_POINT_GRAPHICS,
+            graphicPipelineLayout,
+            0,
+            1,
+            pGlobalDescriptorSet,
+            static_cast<uint32_t>(dynamicOffsets.size()),
+            dynamicOffsets.data());
 
         lineCollection.bind(cmdBuffer);
         lineCollection.draw(cmdBuffer);
@@ -172,9 +225,11 @@ namespace lve
 
     void RenderSystem::cleanUp()
     {
-        if (initialized)
+        if (initialized && graphicPipelineLayout != VK_NULL_HANDLE)
         {
-            vkDestroyPipelineLayout(lveDevice.device(), graphicPipelineLayout, nullptr);
+            lveDevice.getDeletionQueue().push(
+                [device = lveDevice.device(), graphicPipelineLayout = graphicPipelineLayout]()
+                { vkDestroyPipelineLayout(device, graphicPipelineLayout, nullptr); });
         }
     }
 
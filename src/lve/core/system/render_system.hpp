@@ -12,26 +12,48 @@
 
 namespace lve
 {
+    // dynamicOffsets: one per dynamic buffer binding of the global set, in binding order
+
     void renderGameObjects(
         VkCommandBuffer cmdBuffer,
         const VkDescriptorSet *pGlobalDescriptorSet,
         GameObject::Map &gameObjects,
         VkPipelineLayout graphicPipelineLayout,
-        GraphicPipeline *graphicPipeline);
+        GraphicPipeline *graphicPipeline,
+        const std::vector<uint32_t> &dynamicOffsets = {});
 
     void renderScreenTexture(
         VkCommandBuffer cmdBuffer,
         const VkDescriptorSet *pGlobalDescriptorSet,
         VkPipelineLayout graphicPipelineLayout,
         GraphicPipeline *graphicPipeline,
-        VkExtent2D extent);
+        VkExtent2D extent,
+        const std::vector<uint32_t> &dynamicOffsets = {});
+
+    /*
+     * Draw one screen space quad per instance without vertex input, the vertex shader places the
+     * quads itself (e.g. from a storage buffer indexed by gl_InstanceIndex)
+     * @param quadRadius: half edge of the quads in pixels
+     * @param quadDepth: depth of the first instance
+     */
+    void renderInstancedQuads(
+        VkCommandBuffer cmdBuffer,
+        const VkDescriptorSet *pGlobalDescriptorSet,
+        VkPipelineLayout graphicPipelineLayout,
+        GraphicPipeline *graphicPipeline,
+        VkExtent2D extent,
+        float quadRadius,
+        float quadDepth,
+        uint32_t instanceCount,
+        const std::vector<uint32_t> &dynamicOffsets = {});
 
     void renderLines(
         VkCommandBuffer cmdBuffer,
         const VkDescriptorSet *pGlobalDescriptorSet,
         VkPipelineLayout graphicPipelineLayout,
         GraphicPipeline *graphicPipeline,
-        LineCollection &lineCollection);
+        LineCollection &lineCollection,
+        const std::vector<uint32_t> &dynamicOffsets = {});
 
     class RenderSystem
     {
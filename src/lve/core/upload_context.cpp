@@ -0,0 +1,491 @@
+#include "lve/core/upload_context.hpp"
+#include "lve/util/trace.hpp"
+
+// std
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace lve
+{
+    UploadContext::UploadContext(Device &device, VkDeviceSize stagingChunkSize)
+        : lveDevice{device}, stagingChunkSize{stagingChunkSize}
+    {
+        QueueFamilyIndices queueFamilyIndices = lveDevice.findPhysicalQueueFamilies();
+        createSubmitQueue(graphicsSubmitQueue, lveDevice.graphicsTimeline(), queueFamilyIndices.graphicsFamily);
+        if (lveDevice.hasDedicatedTransferQueue())
+            createSubmitQueue(transferSubmitQueue, lveDevice.transferTimeline(), queueFamilyIndices.transferFamily);
+    }
+
+    UploadContext::~UploadContext()
+    {
+        destroySubmitQueue(graphicsSubmitQueue);
+        destroySubmitQueue(transferSubmitQueue);
+    }
+
+    void UploadContext::createSubmitQueue(SubmitQueue &submitQueue, QueueTimeline &timeline, uint32_t queueFamily)
+    {
+        submitQueue.timeline = &timeline;
+        submitQueue.queueFamily = queueFamily;
+
+        VkCommandPoolCreateInfo poolInfo{};
+        poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+        poolInfo.queueFamilyIndex = queueFamily;
+        poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT | VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+
+        if (vkCreateCommandPool(lveDevice.device(), &poolInfo, nullptr, &submitQueue.commandPool) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to create upload command pool!");
+        }
+    }
+
+    void UploadContext::destroySubmitQueue(SubmitQueue &submitQueue)
+    {
+        if (submitQueue.commandPool == VK_NULL_HANDLE)
+            return;
+
+        if (!submitQueue.inFlight.empty())
+            submitQueue.timeline->wait(submitQueue.inFlight.back().timelineValue);
+
+        // frees the command buffers of all submissions
+        vkDestroyCommandPool(lveDevice.device(), submitQueue.commandPool, nullptr);
+        submitQueue.commandPool = VK_NULL_HANDLE;
+    }
+
+    void UploadContext::upload(Buffer &dst, const void *data, VkDeviceSize size, VkDeviceSize dstOffset)
+    {
+        if (size == 0)
+            return;
+
+        std::lock_guard<std::mutex> lock{mutex};
+        stage(pending, dst, data, size, dstOffset);
+    }
+
+    void UploadContext::upload(UploadBatch &batch, Buffer &dst, const void *data, VkDeviceSize size, VkDeviceSize dstOffset)
+    {
+        if (size == 0)
+            return;
+
+        std::lock_guard<std::mutex> lock{mutex};
+        stage(batch, dst, data, size, dstOffset);
+    }
+
+    void UploadContext::copyBuffer(
+        std::shared_ptr<Buffer> src, VkBuffer dst, VkDeviceSize size, VkDeviceSize srcOffset, VkDeviceSize dstOffset)
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        VkBufferCopy region{};
+        region.srcOffset = srcOffset;
+        region.dstOffset = dstOffset;
+        region.size = size;
+        pending.copies.push_back({src->getBuffer(), dst, region});
+
+        // a destroyed Buffer is only deferred past submissions made before, not this pending copy
+        pending.sourceBuffers.push_back(std::move(src));
+    }
+
+    void UploadContext::imageBarrier(
+        const VkImageMemoryBarrier &barrier,
+        VkPipelineStageFlags srcStageMask,
+        VkPipelineStageFlags dstStageMask)
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        imageBarriers.push_back({barrier, srcStageMask, dstStageMask});
+    }
+
+    bool UploadContext::hasPendingWork()
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        return !pending.isEmpty() || !imageBarriers.empty() || !pendingAcquireBarriers.empty();
+    }
+
+    void UploadContext::beginFrame(int frameIndex)
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        if (frameIndex >= static_cast<int>(frameStagingChunks.size()))
+        {
+            frameStagingChunks.resize(frameIndex + 1);
+            frameSourceBuffers.resize(frameIndex + 1);
+        }
+        releaseChunks(frameStagingChunks[frameIndex]);
+        frameSourceBuffers[frameIndex].clear();
+        currentFrameIndex = frameIndex;
+    }
+
+    bool UploadContext::record(VkCommandBuffer commandBuffer)
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        if (pending.isEmpty() && imageBarriers.empty() && pendingAcquireBarriers.empty())
+            return false;
+        if (currentFrameIndex < 0)
+            throw std::runtime_error("UploadContext::beginFrame must be called before recording into a frame");
+
+        LVE_TRACE_ZONE("UploadContext::record");
+        recordAcquires(commandBuffer);
+        if (pending.isEmpty() && imageBarriers.empty())
+            return true;
+
+        recordBatch(commandBuffer, pending, imageBarriers);
+
+        auto &frameChunks = frameStagingChunks[currentFrameIndex];
+        for (auto &chunk : pending.stagingChunks)
+            frameChunks.push_back(std::move(chunk));
+        pending.stagingChunks.clear();
+        pending.stagingChunkOffset = 0;
+
+        auto &frameSources = frameSourceBuffers[currentFrameIndex];
+        for (auto &source : pending.sourceBuffers)
+            frameSources.push_back(std::move(source));
+        pending.sourceBuffers.clear();
+        return true;
+    }
+
+    void UploadContext::takeWaitSemaphores(std::vector<SemaphoreSubmit> &waitSemaphores)
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        if (recordedTransferValue == 0)
+            return;
+
+        // the acquire barriers are recorded at the start of the frame, before any stage reads
+        waitSemaphores.push_back(SemaphoreSubmit{
+            transferSubmitQueue.timeline->getSemaphore(),
+            recordedTransferValue,
+            VK_PIPELINE_STAGE_ALL_COMMANDS_BIT});
+        recordedTransferValue = 0;
+    }
+
+    UploadContext::Ticket UploadContext::submit()
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        if (pending.isEmpty() && imageBarriers.empty())
+            return 0;
+
+        LVE_TRACE_ZONE("UploadContext::submit");
+        retireSubmissions(graphicsSubmitQueue);
+
+        Submission submission = beginSubmission(graphicsSubmitQueue);
+        recordBatch(submission.commandBuffer, pending, imageBarriers);
+        return endSubmission(graphicsSubmitQueue, submission, pending);
+    }
+
+    /*
+     * The copies run on the transfer family, so each destination is released to the graphics
+     * family at the end of the submission and acquired with the same barrier by the next frame
+     * The copies need no leading barrier: the destinations of the batch have not been used by the
+     * graphics queue yet, and the staging memory was written by the host before the submit.
+     */
+    UploadContext::Ticket UploadContext::submitTransfer(UploadBatch &batch)
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        if (batch.isEmpty())
+            return 0;
+
+        LVE_TRACE_ZONE("UploadContext::submitTransfer");
+        if (transferSubmitQueue.commandPool == VK_NULL_HANDLE)
+        {
+            retireSubmissions(graphicsSubmitQueue);
+
+            std::vector<PendingImageBarrier> noImageBarriers;
+            Submission submission = beginSubmission(graphicsSubmitQueue);
+            recordBatch(submission.commandBuffer, batch, noImageBarriers);
+            return endSubmission(graphicsSubmitQueue, submission, batch);
+        }
+
+        retireSubmissions(transferSubmitQueue);
+
+        std::vector<VkBuffer> destinations;
+        for (const UploadBatch::Copy &copy : batch.copies)
+        {
+            if (std::find(destinations.begin(), destinations.end(), copy.dst) == destinations.end())
+                destinations.push_back(copy.dst);
+        }
+
+        std::vector<VkBufferMemoryBarrier> releaseBarriers;
+        releaseBarriers.reserve(destinations.size());
+        for (VkBuffer dst : destinations)
+        {
+            VkBufferMemoryBarrier barrier{};
+            barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+            barrier.srcQueueFamilyIndex = transferSubmitQueue.queueFamily;
+            barrier.dstQueueFamilyIndex = graphicsSubmitQueue.queueFamily;
+            barrier.buffer = dst;
+            barrier.offset = 0;
+            barrier.size = VK_WHOLE_SIZE;
+            barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+            releaseBarriers.push_back(barrier);
+
+            // the access masks of the release are ignored by the acquire and the other way round
+            barrier.srcAccessMask = 0;
+            barrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT;
+            pendingAcquireBarriers.push_back(barrier);
+        }
+
+        Submission submission = beginSubmission(transferSubmitQueue);
+        recordCopies(submission.commandBuffer, batch);
+        vkCmdPipelineBarrier(
+            submission.commandBuffer,
+            VK_PIPELINE_STAGE_TRANSFER_BIT,
+            VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+            0,
+            0,
+            nullptr,
+            static_cast<uint32_t>(releaseBarriers.size()),
+            releaseBarriers.data(),
+            0,
+            nullptr);
+
+        Ticket ticket = endSubmission(transferSubmitQueue, submission, batch);
+        pendingTransferValue = transferSubmitQueue.inFlight.back().timelineValue;
+        return ticket;
+    }
+
+    bool UploadContext::isComplete(Ticket ticket)
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        retireSubmissions(graphicsSubmitQueue);
+        retireSubmissions(transferSubmitQueue);
+        return findSubmission(ticket).second == nullptr;
+    }
+
+    void UploadContext::wait(Ticket ticket)
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        auto [submitQueue, submission] = findSubmission(ticket);
+        if (submission != nullptr)
+            submitQueue->timeline->wait(submission->timelineValue);
+        retireSubmissions(graphicsSubmitQueue);
+        retireSubmissions(transferSubmitQueue);
+    }
+
+    UploadContext::Submission UploadContext::beginSubmission(SubmitQueue &submitQueue)
+    {
+        Submission submission;
+        if (!submitQueue.idle.empty())
+        {
+            submission = std::move(submitQueue.idle.back());
+            submitQueue.idle.pop_back();
+        }
+        else
+        {
+            VkCommandBufferAllocateInfo allocInfo{};
+            allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+            allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+            allocInfo.commandPool = submitQueue.commandPool;
+            allocInfo.commandBufferCount = 1;
+            if (vkAllocateCommandBuffers(lveDevice.device(), &allocInfo, &submission.commandBuffer) != VK_SUCCESS)
+            {
+                throw std::runtime_error("failed to allocate upload command buffer!");
+            }
+        }
+
+        VkCommandBufferBeginInfo beginInfo{};
+        beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+        vkBeginCommandBuffer(submission.commandBuffer, &beginInfo);
+        return submission;
+    }
+
+    UploadContext::Ticket UploadContext::endSubmission(SubmitQueue &submitQueue, Submission &submission, UploadBatch &batch)
+    {
+        vkEndCommandBuffer(submission.commandBuffer);
+        submission.timelineValue = submitQueue.timeline->submit({submission.commandBuffer});
+
+        submission.ticket = nextTicket++;
+        submission.stagingChunks = std::move(batch.stagingChunks);
+        batch.stagingChunks.clear();
+        batch.stagingChunkOffset = 0;
+        submission.sourceBuffers = std::move(batch.sourceBuffers);
+        batch.sourceBuffers.clear();
+        submitQueue.inFlight.push_back(std::move(submission));
+        return submitQueue.inFlight.back().ticket;
+    }
+
+    // submissions complete in order on a queue, so stop at the first one still running
+    void UploadContext::retireSubmissions(SubmitQueue &submitQueue)
+    {
+        if (submitQueue.inFlight.empty())
+            return;
+
+        uint64_t completedValue = submitQueue.timeline->getCompletedValue();
+        while (!submitQueue.inFlight.empty() && submitQueue.inFlight.front().timelineValue <= completedValue)
+        {
+            Submission submission = std::move(submitQueue.inFlight.front());
+            submitQueue.inFlight.pop_front();
+
+            releaseChunks(submission.stagingChunks);
+            submission.sourceBuffers.clear();
+            vkResetCommandBuffer(submission.commandBuffer, 0);
+            submitQueue.idle.push_back(std::move(submission));
+        }
+    }
+
+    std::pair<UploadContext::SubmitQueue *, UploadContext::Submission *> UploadContext::findSubmission(Ticket ticket)
+    {
+        for (SubmitQueue *submitQueue : {&graphicsSubmitQueue, &transferSubmitQueue})
+        {
+            for (Submission &submission : submitQueue->inFlight)
+            {
+                if (submission.ticket == ticket)
+                    return {submitQueue, &submission};
+            }
+        }
+        return {nullptr, nullptr};
+    }
+
+    // 16 byte aligned sub-ranges of the batch's current chunk, a new chunk when it is full
+    void UploadContext::stage(UploadBatch &batch, Buffer &dst, const void *data, VkDeviceSize size, VkDeviceSize dstOffset)
+    {
+        batch.stagingChunkOffset = (batch.stagingChunkOffset + 15) & ~VkDeviceSize{15};
+        if (batch.stagingChunks.empty() || batch.stagingChunkOffset + size > batch.stagingChunks.back()->getBufferSize())
+        {
+            if (size <= stagingChunkSize && !freeChunks.empty())
+            {
+                batch.stagingChunks.push_back(std::move(freeChunks.back()));
+                freeChunks.pop_back();
+            }
+            else
+            {
+                // uploads larger than a chunk get a chunk of their own, dropped after use
+                batch.stagingChunks.push_back(std::make_unique<Buffer>(
+                    lveDevice,
+                    std::max(size, stagingChunkSize),
+                    1,
+                    VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+                    VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT));
+                batch.stagingChunks.back()->map();
+            }
+            batch.stagingChunkOffset = 0;
+        }
+
+        Buffer &chunk = *batch.stagingChunks.back();
+        std::memcpy(static_cast<char *>(chunk.getMappedMemory()) + batch.stagingChunkOffset, data, size);
+
+        VkBufferCopy region{};
+        region.srcOffset = batch.stagingChunkOffset;
+        region.dstOffset = dstOffset;
+        region.size = size;
+        batch.copies.push_back({chunk.getBuffer(), dst.getBuffer(), region});
+        batch.stagingChunkOffset += size;
+    }
+
+    /*
+     * Record the copies of batch and the image barriers between two barriers: the first orders them
+     * after all previous commands (the destinations may still be read by a frame in flight), the
+     * second makes the copies visible to everything after it
+     */
+    void UploadContext::recordBatch(
+        VkCommandBuffer commandBuffer,
+        UploadBatch &batch,
+        std::vector<PendingImageBarrier> &batchImageBarriers)
+    {
+        VkPipelineStageFlags srcStageMask = 0;
+        VkPipelineStageFlags dstStageMask = 0;
+        std::vector<VkImageMemoryBarrier> barriers;
+        barriers.reserve(batchImageBarriers.size());
+        for (const PendingImageBarrier &imageBarrier : batchImageBarriers)
+        {
+            barriers.push_back(imageBarrier.barrier);
+            srcStageMask |= imageBarrier.srcStageMask;
+            dstStageMask |= imageBarrier.dstStageMask;
+        }
+        if (!batch.isEmpty())
+        {
+            srcStageMask |= VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+            dstStageMask |= VK_PIPELINE_STAGE_TRANSFER_BIT;
+        }
+        vkCmdPipelineBarrier(
+            commandBuffer,
+            srcStageMask,
+            dstStageMask,
+            0,
+            0,
+            nullptr,
+            0,
+            nullptr,
+            static_cast<uint32_t>(barriers.size()),
+            barriers.data());
+        batchImageBarriers.clear();
+
+        if (batch.isEmpty())
+            return;
+
+        recordCopies(commandBuffer, batch);
+
+        VkMemoryBarrier memoryBarrier{};
+        memoryBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        memoryBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        memoryBarrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT;
+        vkCmdPipelineBarrier(
+            commandBuffer,
+            VK_PIPELINE_STAGE_TRANSFER_BIT,
+            VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+            0,
+            1,
+            &memoryBarrier,
+            0,
+            nullptr,
+            0,
+            nullptr);
+    }
+
+    // consecutive copies between the same buffers go into one command
+    void UploadContext::recordCopies(VkCommandBuffer commandBuffer, UploadBatch &batch)
+    {
+        std::vector<UploadBatch::Copy> &copies = batch.copies;
+        size_t first = 0;
+        std::vector<VkBufferCopy> regions;
+        for (size_t i = 0; i <= copies.size(); i++)
+        {
+            if (i < copies.size() && copies[i].src == copies[first].src && copies[i].dst == copies[first].dst)
+            {
+                regions.push_back(copies[i].region);
+                continue;
+            }
+            vkCmdCopyBuffer(
+                commandBuffer,
+                copies[first].src,
+                copies[first].dst,
+                static_cast<uint32_t>(regions.size()),
+                regions.data());
+            regions.clear();
+            if (i < copies.size())
+                regions.push_back(copies[i].region);
+            first = i;
+        }
+        copies.clear();
+    }
+
+    // the transfer timeline is waited on by the submission of the current frame
+    void UploadContext::recordAcquires(VkCommandBuffer commandBuffer)
+    {
+        if (pendingAcquireBarriers.empty())
+            return;
+
+        vkCmdPipelineBarrier(
+            commandBuffer,
+            VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+            VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+            0,
+            0,
+            nullptr,
+            static_cast<uint32_t>(pendingAcquireBarriers.size()),
+            pendingAcquireBarriers.data(),
+            0,
+            nullptr);
+        pendingAcquireBarriers.clear();
+
+        // values complete in order, so the last transfer covers all acquired ones
+        recordedTransferValue = pendingTransferValue;
+        pendingTransferValue = 0;
+    }
+
+    void UploadContext::releaseChunks(std::vector<std::unique_ptr<Buffer>> &chunks)
+    {
+        for (auto &chunk : chunks)
+        {
+            if (chunk->getBufferSize() == stagingChunkSize)
+                freeChunks.push_back(std::move(chunk));
+        }
+        chunks.clear();
+    }
+} // namespace lve
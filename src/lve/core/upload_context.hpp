@@ -0,0 +1,176 @@
+#pragma once
+
+#include "lve/core/device.hpp"
+#include "lve/core/queue_timeline.hpp"
+#include "lve/core/resource/buffer.hpp"
+
+// libs
+#include <vulkan/vulkan.h>
+
+// std
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace lve
+{
+    /*
+     * Buffer copies together with the staging memory and copy sources they read
+     * UploadContext keeps one for the frame in progress. A batch owned by the caller collects the
+     * uploads of resources that are handed to submitTransfer() as a whole.
+     */
+    class UploadBatch
+    {
+    public:
+        bool isEmpty() const { return copies.empty(); }
+
+    private:
+        friend class UploadContext;
+
+        struct Copy
+        {
+            VkBuffer src;
+            VkBuffer dst;
+            VkBufferCopy region;
+        };
+
+        std::vector<Copy> copies;
+        std::vector<std::unique_ptr<Buffer>> stagingChunks; // the last one is filled next
+        VkDeviceSize stagingChunkOffset = 0;
+        // sources of copyBuffer(), their destruction is deferred until the copies have completed
+        std::vector<std::shared_ptr<Buffer>> sourceBuffers;
+    };
+
+    /*
+     * Collects buffer uploads, buffer copies and image layout transitions, and records them as one
+     * batch instead of a blocking submission per operation
+     * A batch is either recorded into the command buffer of the frame in progress (the frame
+     * managers call record() after beginning the frame and again before the render pass), or into an
+     * own command buffer submitted by submit(), so the CPU never waits for an upload.
+     * Staging memory of a batch is reused once the frame or submission that read it has completed.
+     * Every batch is fenced by barriers: it starts after all earlier commands on the queue and its
+     * writes are visible to all later ones.
+     *
+     * submitTransfer() runs the copies of an UploadBatch on the device's dedicated transfer queue
+     * instead, next to rendering. Its destination buffers are released to the graphics family there
+     * and acquired by the next record() into a frame, whose submission waits on the transfer
+     * timeline (see takeWaitSemaphores). All other uploads stay on the graphics queue.
+     */
+    class UploadContext
+    {
+    public:
+        using Ticket = uint64_t; // identifies a submit(), 0 means nothing was submitted
+
+        UploadContext(Device &device, VkDeviceSize stagingChunkSize = 1 << 20);
+        ~UploadContext();
+
+        UploadContext(const UploadContext &) = delete;
+        UploadContext &operator=(const UploadContext &) = delete;
+
+        // copy size bytes of data to staging memory now and queue the copy into dst
+        void upload(Buffer &dst, const void *data, VkDeviceSize size, VkDeviceSize dstOffset = 0);
+        // same, but the copy is added to batch instead of the pending batch, see submitTransfer()
+        void upload(UploadBatch &batch, Buffer &dst, const void *data, VkDeviceSize size, VkDeviceSize dstOffset = 0);
+        // queue a copy between buffers, the batch keeps src alive until the copy has completed
+        void copyBuffer(
+            std::shared_ptr<Buffer> src, VkBuffer dst, VkDeviceSize size, VkDeviceSize srcOffset = 0, VkDeviceSize dstOffset = 0);
+        void imageBarrier(const VkImageMemoryBarrier &barrier, VkPipelineStageFlags srcStageMask, VkPipelineStageFlags dstStageMask);
+
+        bool hasPendingWork();
+
+        // the frame slot's previous submission has completed, its staging memory can be reused
+        void beginFrame(int frameIndex);
+        /*
+         * Record the pending batch into the command buffer of the frame started by beginFrame()
+         * Must be called outside of a render pass.
+         * @return whether anything was recorded
+         */
+        bool record(VkCommandBuffer commandBuffer);
+        // transfers acquired by record() this frame, the frame's submission has to wait on them
+        void takeWaitSemaphores(std::vector<SemaphoreSubmit> &waitSemaphores);
+
+        // record the pending batch into an own command buffer and submit it to the graphics queue
+        Ticket submit();
+        /*
+         * Submit the copies of batch to the dedicated transfer queue and empty it
+         * Only for destinations the graphics queue has not used yet (e.g. buffers of models being
+         * loaded): the copies overlap the frames in flight, and the first frame recorded afterwards
+         * takes ownership of the destinations. Without a dedicated transfer family the batch is
+         * submitted to the graphics queue like submit().
+         */
+        Ticket submitTransfer(UploadBatch &batch);
+        bool isComplete(Ticket ticket);
+        void wait(Ticket ticket);
+
+    private:
+        struct PendingImageBarrier
+        {
+            VkImageMemoryBarrier barrier;
+            VkPipelineStageFlags srcStageMask;
+            VkPipelineStageFlags dstStageMask;
+        };
+
+        struct Submission
+        {
+            Ticket ticket = 0;
+            VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+            uint64_t timelineValue = 0; // signaled on the queue's timeline when the submission completes
+            std::vector<std::unique_ptr<Buffer>> stagingChunks;
+            std::vector<std::shared_ptr<Buffer>> sourceBuffers;
+        };
+
+        // submissions on one queue complete in order
+        struct SubmitQueue
+        {
+            QueueTimeline *timeline = nullptr;
+            uint32_t queueFamily = 0;
+            VkCommandPool commandPool = VK_NULL_HANDLE;
+            std::deque<Submission> inFlight;
+            std::vector<Submission> idle;
+        };
+
+        void createSubmitQueue(SubmitQueue &submitQueue, QueueTimeline &timeline, uint32_t queueFamily);
+        void destroySubmitQueue(SubmitQueue &submitQueue);
+        Submission beginSubmission(SubmitQueue &submitQueue);
+        // takes the staging chunks and copy sources of batch
+        Ticket endSubmission(SubmitQueue &submitQueue, Submission &submission, UploadBatch &batch);
+        void retireSubmissions(SubmitQueue &submitQueue);
+        std::pair<SubmitQueue *, Submission *> findSubmission(Ticket ticket);
+
+        void stage(UploadBatch &batch, Buffer &dst, const void *data, VkDeviceSize size, VkDeviceSize dstOffset);
+        // clears the copies of batch and batchImageBarriers
+        void recordBatch(VkCommandBuffer commandBuffer, UploadBatch &batch, std::vector<PendingImageBarrier> &batchImageBarriers);
+        void recordCopies(VkCommandBuffer commandBuffer, UploadBatch &batch);
+        void recordAcquires(VkCommandBuffer commandBuffer);
+        void releaseChunks(std::vector<std::unique_ptr<Buffer>> &chunks);
+
+        Device &lveDevice;
+        VkDeviceSize stagingChunkSize;
+        std::mutex mutex;
+
+        SubmitQueue graphicsSubmitQueue;
+        SubmitQueue transferSubmitQueue; // only with a dedicated transfer family
+
+        // pending batch
+        UploadBatch pending;
+        std::vector<PendingImageBarrier> imageBarriers;
+
+        // chunks of standard size that are no longer read by the GPU
+        std::vector<std::unique_ptr<Buffer>> freeChunks;
+
+        // chunks and copy sources of batches recorded into frames, per frame slot
+        std::vector<std::vector<std::unique_ptr<Buffer>>> frameStagingChunks;
+        std::vector<std::vector<std::shared_ptr<Buffer>>> frameSourceBuffers;
+        int currentFrameIndex = -1;
+
+        // queue family ownership transfers from submitTransfer() waiting for the next frame
+        std::vector<VkBufferMemoryBarrier> pendingAcquireBarriers;
+        uint64_t pendingTransferValue = 0;  // transfer timeline value of the barriers above
+        uint64_t recordedTransferValue = 0; // acquired in the current frame, not yet taken
+
+        Ticket nextTicket = 1;
+    };
+} // namespace lve
@@ -1,4 +1,5 @@
 #include "lve/core/window.hpp"
+#include "lve/util/trace.hpp"
 
 // std
 #include <stdexcept>
@@ -121,6 +122,7 @@ namespace lve
     void Window::mainThreadGlfwEventLoop()
     {
         bool wasMinimized = false;
+        LVE_TRACE_THREAD_NAME("main (glfw events)");
 
         while (!shouldClose())
         {
@@ -129,6 +131,7 @@ namespace lve
             bool isMinimized = isWindowMinimized();
             if (isMinimized)
             {
+                LVE_TRACE_ZONE("glfwWaitEvents (minimized)");
                 glfwWaitEvents();
             }
 
@@ -1,4 +1,7 @@
 #include "lve/go/geo/line.hpp"
+#include "lve/core/resource/frame_allocator.hpp"
+#include "lve/core/upload_context.hpp"
+#include "lve/util/trace.hpp"
 
 // std
 #include <memory>
@@ -26,11 +29,12 @@ namespace lve
         return attributeDescriptions;
     }
 
-    LineCollection::LineCollection(Device &device, size_t maxLineCount)
-        : lveDevice{device}, maxLineCount{maxLineCount}
+    LineCollection::LineCollection(Device &device, size_t maxLineCount, FrameAllocator *frameAllocator)
+        : lveDevice{device}, frameAllocator{frameAllocator}, maxLineCount{maxLineCount}
     {
         lines.reserve(maxLineCount);
-        createLineBuffer();
+        if (frameAllocator == nullptr)
+            createLineBuffer();
     }
 
     void LineCollection::createLineBuffer()
@@ -38,28 +42,25 @@ namespace lve
         uint32_t lineSize = sizeof(Line);
         uint32_t totalLineCount = maxLineCount;
 
-        stagingBuffer = std::make_unique<Buffer>(
-            lveDevice,
-            lineSize,
-            totalLineCount,
-            VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
-
-        stagingBuffer->map();
-        stagingBuffer->writeToBuffer((void *)lines.data());
-
         lineBuffer = std::make_unique<Buffer>(
             lveDevice,
             lineSize,
             totalLineCount,
             VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
             VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-
-        lineBuffer->copyBufferFrom(stagingBuffer->getBuffer(), lineSize * maxLineCount);
     }
 
     void LineCollection::bind(VkCommandBuffer commandBuffer)
     {
+        if (frameAllocator != nullptr)
+        {
+            if (lineCount == 0)
+                return;
+            FrameAllocation allocation = frameAllocator->write(lines.data(), sizeof(Line) * lineCount);
+            vkCmdBindVertexBuffers(commandBuffer, 0, 1, &allocation.buffer, &allocation.offset);
+            return;
+        }
+
         VkBuffer buffers[] = {lineBuffer->getBuffer()};
         VkDeviceSize offsets[] = {0};
         vkCmdBindVertexBuffers(commandBuffer, 0, 1, buffers, offsets);
@@ -80,7 +81,7 @@ namespace lve
 
         lines.push_back(line);
         lineCount++;
-        updateBuffer();
+        uploadLines(lineCount - 1);
     }
 
     void LineCollection::addLines(const std::vector<Line> &lines)
@@ -88,24 +89,29 @@ namespace lve
         if (lineCount + lines.size() > maxLineCount)
             throw std::runtime_error("Cannot add more lines to LineCollection than maxLineCount");
 
+        size_t firstLine = lineCount;
         this->lines.insert(this->lines.end(), lines.begin(), lines.end());
         lineCount += lines.size();
-        updateBuffer();
+        uploadLines(firstLine);
     }
 
     void LineCollection::clearLines()
     {
         lines.clear();
         lineCount = 0;
-        updateBuffer();
     }
 
-    void LineCollection::updateBuffer()
+    // only the lines appended since firstLine are copied, lines before it are already uploaded
+    void LineCollection::uploadLines(size_t firstLine)
     {
-        if (lineCount == 0)
+        if (frameAllocator != nullptr || firstLine >= lineCount)
             return;
 
-        stagingBuffer->writeToBuffer((void *)lines.data());
-        lineBuffer->copyBufferFrom(stagingBuffer->getBuffer(), sizeof(Line) * maxLineCount);
+        LVE_TRACE_ZONE("LineCollection::uploadLines");
+        lveDevice.getUploadContext().upload(
+            *lineBuffer,
+            lines.data() + firstLine,
+            sizeof(Line) * (lineCount - firstLine),
+            sizeof(Line) * firstLine);
     }
 } // namespace lve
\ No newline at end of file
@@ -12,6 +12,8 @@
 
 namespace lve
 {
+    class FrameAllocator;
+
     struct Line
     {
         struct Vertex
@@ -39,10 +41,17 @@ namespace lve
         Vertex end;
     };
 
+    /*
+     * Lines in a device local vertex buffer
+     * Added lines are queued on the device's upload context, so they have to be added before the
+     * render pass of the frame that draws them. With a frame allocator the lines are rebuilt every
+     * frame anyway, so bind() writes them into the frame's partition instead and nothing is
+     * uploaded.
+     */
     class LineCollection
     {
     public:
-        LineCollection(Device &device, size_t maxLineCount);
+        LineCollection(Device &device, size_t maxLineCount, FrameAllocator *frameAllocator = nullptr);
 
         LineCollection(const LineCollection &) = delete;
         LineCollection &operator=(const LineCollection &) = delete;
@@ -58,12 +67,12 @@ namespace lve
 
     private:
         void createLineBuffer();
-        void updateBuffer();
+        void uploadLines(size_t firstLine);
 
         Device &lveDevice;
+        FrameAllocator *frameAllocator;
 
-        std::unique_ptr<Buffer> lineBuffer;
-        std::unique_ptr<Buffer> stagingBuffer;
+        std::unique_ptr<Buffer> lineBuffer; // only without a frame allocator
         std::vector<Line> lines;
         size_t lineCount{0};
         size_t maxLineCount;
@@ -1,4 +1,5 @@
 #include "lve/go/geo/model.hpp"
+#include "lve/core/upload_context.hpp"
 #include "lve/util/math.hpp"
 
 // libs
@@ -27,38 +28,27 @@ namespace std
 namespace lve
 {
 
-    Model::Model(Device &device, const Model::Builder &builder) : lveDevice{device}
+    Model::Model(Device &device, const Model::Builder &builder, UploadBatch *uploadBatch) : lveDevice{device}
     {
-        createVertexBuffer(builder.vertices);
-        createIndexBuffer(builder.indices);
+        createVertexBuffer(builder.vertices, uploadBatch);
+        createIndexBuffer(builder.indices, uploadBatch);
     }
 
     std::unique_ptr<Model> Model::createModelFromFile(
-        Device &device, const std::string &filepath)
+        Device &device, const std::string &filepath, UploadBatch *uploadBatch)
     {
         Builder builder{};
         builder.loadModel(filepath);
-        return std::make_unique<Model>(device, builder);
+        return std::make_unique<Model>(device, builder, uploadBatch);
     }
 
-    void Model::createVertexBuffer(const std::vector<Vertex> &vertices)
+    void Model::createVertexBuffer(const std::vector<Vertex> &vertices, UploadBatch *uploadBatch)
     {
         vertexCount = static_cast<uint32_t>(vertices.size());
         assert(vertexCount >= 3 && "Vertex count must be at least 3");
         VkDeviceSize bufferSize = sizeof(vertices[0]) * vertexCount;
         uint32_t vertexSize = sizeof(vertices[0]);
 
-        Buffer stagingBuffer{
-            lveDevice,
-            vertexSize,
-            vertexCount,
-            VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-        };
-
-        stagingBuffer.map();
-        stagingBuffer.writeToBuffer((void *)vertices.data());
-
         vertexBuffer = std::make_unique<Buffer>(
             lveDevice,
             vertexSize,
@@ -66,10 +56,10 @@ namespace lve
             VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
             VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
 
-        vertexBuffer->copyBufferFrom(stagingBuffer.getBuffer(), bufferSize);
+        upload(*vertexBuffer, vertices.data(), bufferSize, uploadBatch);
     }
 
-    void Model::createIndexBuffer(const std::vector<uint32_t> &indices)
+    void Model::createIndexBuffer(const std::vector<uint32_t> &indices, UploadBatch *uploadBatch)
     {
         indexCount = static_cast<uint32_t>(indices.size());
         hasIndexBuffer = indexCount > 0;
@@ -82,17 +72,6 @@ namespace lve
         VkDeviceSize bufferSize = sizeof(indices[0]) * indexCount;
         uint32_t indexSize = sizeof(indices[0]);
 
-        Buffer stagingBuffer{
-            lveDevice,
-            indexSize,
-            indexCount,
-            VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-        };
-
-        stagingBuffer.map();
-        stagingBuffer.writeToBuffer((void *)indices.data());
-
         indexBuffer = std::make_unique<Buffer>(
             lveDevice,
             indexSize,
@@ -100,7 +79,15 @@ namespace lve
             VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
             VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
 
-        indexBuffer->copyBufferFrom(stagingBuffer.getBuffer(), bufferSize);
+        upload(*indexBuffer, indices.data(), bufferSize, uploadBatch);
+    }
+
+    void Model::upload(Buffer &buffer, const void *data, VkDeviceSize size, UploadBatch *uploadBatch)
+    {
+        if (uploadBatch != nullptr)
+            lveDevice.getUploadContext().upload(*uploadBatch, buffer, data, size);
+        else
+            lveDevice.getUploadContext().upload(buffer, data, size);
     }
 
     void Model::draw(VkCommandBuffer commandBuffer)
@@ -12,6 +12,8 @@
 
 namespace lve
 {
+    class UploadBatch;
+
     class Model
     {
     public:
@@ -40,20 +42,22 @@ namespace lve
             void loadModel(const std::string &filepath);
         };
 
-        Model(Device &device, const Model::Builder &builder);
+        // the buffers are uploaded through uploadBatch when given, otherwise with the next frame
+        Model(Device &device, const Model::Builder &builder, UploadBatch *uploadBatch = nullptr);
 
         Model(const Model &) = delete;
         Model &operator=(const Model &) = delete;
 
         static std::unique_ptr<Model> createModelFromFile(
-            Device &device, const std::string &filepath);
+            Device &device, const std::string &filepath, UploadBatch *uploadBatch = nullptr);
 
         void bind(VkCommandBuffer commandBuffer);
         void draw(VkCommandBuffer commandBuffer);
 
     private:
-        void createVertexBuffer(const std::vector<Vertex> &vertices);
-        void createIndexBuffer(const std::vector<uint32_t> &indices);
+        void createVertexBuffer(const std::vector<Vertex> &vertices, UploadBatch *uploadBatch);
+        void createIndexBuffer(const std::vector<uint32_t> &indices, UploadBatch *uploadBatch);
+        void upload(Buffer &buffer, const void *data, VkDeviceSize size, UploadBatch *uploadBatch);
 
         Device &lveDevice;
 
@@ -0,0 +1,229 @@
+#include "lve/util/image_io.hpp"
+#include "lve/util/file_io.hpp"
+
+// std
+#include <algorithm>
+#include <array>
+#include <stdexcept>
+
+namespace lve
+{
+    namespace io
+    {
+        namespace
+        {
+            const size_t MAX_STORED_BLOCK_SIZE = 65535;
+
+            std::array<uint32_t, 256> makeCrcTable()
+            {
+                std::array<uint32_t, 256> table{};
+                for (uint32_t n = 0; n < 256; n++)
+                {
+                    uint32_t c = n;
+                    for (int k = 0; k < 8; k++)
+                        c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+                    table[n] = c;
+                }
+                return table;
+            }
+
+            void appendU32BigEndian(std::vector<char> &out, uint32_t value)
+            {
+                out.push_back(static_cast<char>(value >> 24));
+                out.push_back(static_cast<char>(value >> 16));
+                out.push_back(static_cast<char>(value >> 8));
+                out.push_back(static_cast<char>(value));
+            }
+
+            // length, type, data, then the crc over type and data
+            void appendPngChunk(std::vector<char> &out, const char type[4], const std::vector<uint8_t> &data)
+            {
+                appendU32BigEndian(out, static_cast<uint32_t>(data.size()));
+                size_t typeStart = out.size();
+                out.insert(out.end(), type, type + 4);
+                out.insert(out.end(), data.begin(), data.end());
+                uint32_t crc = crc32(reinterpret_cast<const uint8_t *>(out.data()) + typeStart, 4 + data.size());
+                appendU32BigEndian(out, crc);
+            }
+
+            void checkImageArgs(const std::string &filepath, uint32_t width, uint32_t height, const uint8_t *rgbaPixels)
+            {
+                if (width == 0 || height == 0 || rgbaPixels == nullptr)
+                    throw std::runtime_error("Cannot write an empty image to " + filepath);
+            }
+        } // namespace
+
+        uint32_t crc32(const uint8_t *data, size_t size, uint32_t crc)
+        {
+            static const std::array<uint32_t, 256> table = makeCrcTable();
+            crc = ~crc;
+            for (size_t i = 0; i < size; i++)
+                crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+            return ~crc;
+        }
+
+        uint32_t adler32(const uint8_t *data, size_t size, uint32_t adler)
+        {
+            const uint32_t MOD_ADLER = 65521;
+            const size_t MAX_DEFERRED = 5552; // largest run that cannot overflow before the modulo
+            uint32_t a = adler & 0xFFFF;
+            uint32_t b = adler >> 16;
+            while (size > 0)
+            {
+                size_t runLength = std::min(size, MAX_DEFERRED);
+                size -= runLength;
+                for (size_t i = 0; i < runLength; i++)
+                {
+                    a += *data++;
+                    b += a;
+                }
+                a %= MOD_ADLER;
+                b %= MOD_ADLER;
+            }
+            return (b << 16) | a;
+        }
+
+        void writePpm(const std::string &filepath, uint32_t width, uint32_t height, const uint8_t *rgbaPixels)
+        {
+            checkImageArgs(filepath, width, height, rgbaPixels);
+            std::string header = "P6\n" + std::to_string(width) + " " + std::to_string(height) + "\n255\n";
+
+            std::vector<char> data(header.begin(), header.end());
+            data.reserve(header.size() + static_cast<size_t>(width) * height * 3);
+            for (size_t i = 0; i < static_cast<size_t>(width) * height; i++)
+                data.insert(data.end(), rgbaPixels + i * 4, rgbaPixels + i * 4 + 3);
+
+            writeFile(filepath, data);
+        }
+
+        void writePng(const std::string &filepath, uint32_t width, uint32_t height, const uint8_t *rgbaPixels)
+        {
+            checkImageArgs(filepath, width, height, rgbaPixels);
+
+            // scanlines of RGB, each prefixed with filter type 0 (none)
+            size_t rowSize = 1 + static_cast<size_t>(width) * 3;
+            std::vector<uint8_t> scanlines(rowSize * height);
+            for (uint32_t y = 0; y < height; y++)
+            {
+                uint8_t *row = scanlines.data() + y * rowSize;
+                row[0] = 0;
+                const uint8_t *src = rgbaPixels + static_cast<size_t>(y) * width * 4;
+                for (uint32_t x = 0; x < width; x++)
+                {
+                    row[1 + x * 3 + 0] = src[x * 4 + 0];
+                    row[1 + x * 3 + 1] = src[x * 4 + 1];
+                    row[1 + x * 3 + 2] = src[x * 4 + 2];
+                }
+            }
+
+            // zlib stream of stored deflate blocks
+            size_t blockCount = std::max<size_t>((scanlines.size() + MAX_STORED_BLOCK_SIZE - 1) / MAX_STORED_BLOCK_SIZE, 1);
+            std::vector<uint8_t> zlibData;
+            zlibData.reserve(2 + scanlines.size() + blockCount * 5 + 4);
+            zlibData.push_back(0x78); // deflate, 32K window
+            zlibData.push_back(0x01); // no preset dictionary, check bits
+            for (size_t offset = 0; offset < scanlines.size(); offset += MAX_STORED_BLOCK_SIZE)
+            {
+                uint16_t blockSize = static_cast<uint16_t>(std::min(MAX_STORED_BLOCK_SIZE, scanlines.size() - offset));
+                bool isFinal = offset + blockSize == scanlines.size();
+                zlibData.push_back(isFinal ? 1 : 0);
+                zlibData.push_back(static_cast<uint8_t>(blockSize));
+                zlibData.push_back(static_cast<uint8_t>(blockSize >> 8));
+                zlibData.push_back(static_cast<uint8_t>(~blockSize));
+                zlibData.push_back(static_cast<uint8_t>(~blockSize >> 8));
+                zlibData.insert(zlibData.end(), scanlines.begin() + offset, scanlines.begin() + offset + blockSize);
+            }
+            uint32_t adler = adler32(scanlines.data(), scanlines.size());
+            zlibData.push_back(static_cast<uint8_t>(adler >> 24));
+            zlibData.push_back(static_cast<uint8_t>(adler >> 16));
+            zlibData.push_back(static_cast<uint8_t>(adler >> 8));
+            zlibData.push_back(static_cast<uint8_t>(adler));
+
+            std::vector<uint8_t> ihdr;
+            ihdr.reserve(13);
+            for (uint32_t value : {width, height})
+                for (int shift = 24; shift >= 0; shift -= 8)
+                    ihdr.push_back(static_cast<uint8_t>(value >> shift));
+            ihdr.push_back(8); // bit depth
+            ihdr.push_back(2); // color type RGB
+            ihdr.push_back(0); // compression
+            ihdr.push_back(0); // filter
+            ihdr.push_back(0); // no interlace
+
+            const uint8_t signature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+            std::vector<char> file(signature, signature + 8);
+            appendPngChunk(file, "IHDR", ihdr);
+            appendPngChunk(file, "IDAT", zlibData);
+            appendPngChunk(file, "IEND", {});
+
+            writeFile(filepath, file);
+        }
+
+        void writeYuv420(const std::string &filepath, uint32_t width, uint32_t height, const uint8_t *rgbaPixels)
+        {
+            checkImageArgs(filepath, width, height, rgbaPixels);
+            uint32_t chromaWidth = (width + 1) / 2;
+            uint32_t chromaHeight = (height + 1) / 2;
+            size_t lumaSize = static_cast<size_t>(width) * height;
+            size_t chromaSize = static_cast<size_t>(chromaWidth) * chromaHeight;
+
+            std::vector<char> data(lumaSize + chromaSize * 2);
+            uint8_t *yPlane = reinterpret_cast<uint8_t *>(data.data());
+            uint8_t *uPlane = yPlane + lumaSize;
+            uint8_t *vPlane = uPlane + chromaSize;
+
+            for (size_t i = 0; i < lumaSize; i++)
+            {
+                int r = rgbaPixels[i * 4 + 0], g = rgbaPixels[i * 4 + 1], b = rgbaPixels[i * 4 + 2];
+                yPlane[i] = static_cast<uint8_t>(((66 * r + 129 * g + 25 * b + 128) >> 8) + 16);
+            }
+
+            // chroma of the averaged 2x2 block, edge pixels are repeated for odd sizes
+            for (uint32_t cy = 0; cy < chromaHeight; cy++)
+            {
+                for (uint32_t cx = 0; cx < chromaWidth; cx++)
+                {
+                    int r = 0, g = 0, b = 0;
+                    for (uint32_t dy = 0; dy < 2; dy++)
+                    {
+                        for (uint32_t dx = 0; dx < 2; dx++)
+                        {
+                            uint32_t x = std::min(cx * 2 + dx, width - 1);
+                            uint32_t y = std::min(cy * 2 + dy, height - 1);
+                            const uint8_t *pixel = rgbaPixels + (static_cast<size_t>(y) * width + x) * 4;
+                            r += pixel[0];
+                            g += pixel[1];
+                            b += pixel[2];
+                        }
+                    }
+                    r = (r + 2) / 4;
+                    g = (g + 2) / 4;
+                    b = (b + 2) / 4;
+                    size_t c = static_cast<size_t>(cy) * chromaWidth + cx;
+                    uPlane[c] = static_cast<uint8_t>(((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128);
+                    vPlane[c] = static_cast<uint8_t>(((112 * r - 94 * g - 18 * b + 128) >> 8) + 128);
+                }
+            }
+
+            writeFile(filepath, data);
+        }
+
+        void writeImage(const std::string &filepath, uint32_t width, uint32_t height, const uint8_t *rgbaPixels)
+        {
+            auto hasExtension = [&filepath](const std::string &extension)
+            {
+                return filepath.size() >= extension.size() &&
+                       filepath.compare(filepath.size() - extension.size(), extension.size(), extension) == 0;
+            };
+
+            if (hasExtension(".png"))
+                writePng(filepath, width, height, rgbaPixels);
+            else if (hasExtension(".ppm"))
+                writePpm(filepath, width, height, rgbaPixels);
+            else if (hasExtension(".yuv"))
+                writeYuv420(filepath, width, height, rgbaPixels);
+            else
+                throw std::runtime_error("Unknown image format: " + filepath + ", expected .png, .ppm or .yuv");
+        }
+    } // namespace io
+} // namespace lve
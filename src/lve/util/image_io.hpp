@@ -0,0 +1,34 @@
+#pragma once
+
+// std
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace lve
+{
+    /*
+     * Dependency free image dumps for offscreen captures and golden image comparisons
+     * Pixels are tightly packed 8 bit RGBA rows, top row first. The alpha channel is dropped, both
+     * formats store RGB. PNG data is written as stored (uncompressed) deflate blocks, so files are
+     * large but byte exact and cheap to encode.
+     */
+    namespace io
+    {
+        void writePpm(const std::string &filepath, uint32_t width, uint32_t height, const uint8_t *rgbaPixels);
+        void writePng(const std::string &filepath, uint32_t width, uint32_t height, const uint8_t *rgbaPixels);
+
+        /*
+         * Raw planar YUV 4:2:0 (I420, BT.601 limited range): the Y plane, then the U and V planes at
+         * half resolution rounded up. Frames can be concatenated into a stream for video encoders,
+         * e.g. ffmpeg -f rawvideo -pix_fmt yuv420p -s WxH
+         */
+        void writeYuv420(const std::string &filepath, uint32_t width, uint32_t height, const uint8_t *rgbaPixels);
+
+        // picks the format from the extension, .ppm, .png or .yuv
+        void writeImage(const std::string &filepath, uint32_t width, uint32_t height, const uint8_t *rgbaPixels);
+
+        uint32_t crc32(const uint8_t *data, size_t size, uint32_t crc = 0);
+        uint32_t adler32(const uint8_t *data, size_t size, uint32_t adler = 1);
+    } // namespace io
+} // namespace lve
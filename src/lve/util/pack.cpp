@@ -0,0 +1,157 @@
+#include "lve/util/pack.hpp"
+
+// std
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define LVE_PACK_X86
+#include <cpuid.h>
+#include <immintrin.h>
+#endif
+
+namespace lve
+{
+    namespace pack
+    {
+        uint16_t floatToHalf(float value)
+        {
+            uint32_t bits;
+            std::memcpy(&bits, &value, sizeof(float));
+            uint32_t sign = (bits >> 16) & 0x8000;
+            uint32_t exponent = (bits >> 23) & 0xff;
+            uint32_t mantissa = bits & 0x7fffff;
+
+            if (exponent == 0xff) // inf stays inf, nan is quieted
+                return static_cast<uint16_t>(sign | 0x7c00 | (mantissa ? 0x200 | (mantissa >> 13) : 0));
+
+            int halfExponent = static_cast<int>(exponent) - 127 + 15;
+            if (halfExponent >= 31)
+                return static_cast<uint16_t>(sign | 0x7c00);
+
+            if (halfExponent <= 0) // subnormal half
+            {
+                if (halfExponent < -10)
+                    return static_cast<uint16_t>(sign);
+                mantissa |= 0x800000;
+                uint32_t shift = static_cast<uint32_t>(14 - halfExponent);
+                uint32_t halfMantissa = mantissa >> shift;
+                uint32_t remainder = mantissa & ((1u << shift) - 1);
+                uint32_t halfway = 1u << (shift - 1);
+                if (remainder > halfway || (remainder == halfway && (halfMantissa & 1)))
+                    halfMantissa++;
+                return static_cast<uint16_t>(sign | halfMantissa);
+            }
+
+            uint32_t half = sign | (static_cast<uint32_t>(halfExponent) << 10) | (mantissa >> 13);
+            uint32_t remainder = mantissa & 0x1fff;
+            if (remainder > 0x1000 || (remainder == 0x1000 && (half & 1)))
+                half++; // a carry into the exponent is the correct rounding, up to inf
+            return static_cast<uint16_t>(half);
+        }
+
+        float halfToFloat(uint16_t half)
+        {
+            uint32_t sign = static_cast<uint32_t>(half & 0x8000) << 16;
+            uint32_t exponent = (half >> 10) & 0x1f;
+            uint32_t mantissa = half & 0x3ff;
+
+            float value;
+            if (exponent == 0)
+            {
+                value = std::ldexp(static_cast<float>(mantissa), -24);
+                return sign ? -value : value;
+            }
+
+            uint32_t bits = exponent == 0x1f
+                                ? sign | 0x7f800000 | (mantissa << 13)
+                                : sign | ((exponent - 15 + 127) << 23) | (mantissa << 13);
+            std::memcpy(&value, &bits, sizeof(float));
+            return value;
+        }
+
+        static uint32_t packUnorm16(float value)
+        {
+            if (!(value > 0.f)) // also NaN, like the SIMD path
+                return 0;
+            // lrint rounds to nearest even like _mm_cvtps_epi32
+            return static_cast<uint32_t>(std::lrint(std::min(value, 1.f) * 65535.f));
+        }
+
+        void packUnorm2x16(const float *src, size_t pairCount, float scaleX, float scaleY, uint32_t *dst)
+        {
+            size_t i = 0;
+#if defined(LVE_PACK_X86) && defined(__SSE2__)
+            const __m128 scale = _mm_setr_ps(scaleX, scaleY, scaleX, scaleY);
+            const __m128 zero = _mm_setzero_ps();
+            const __m128 one = _mm_set1_ps(1.f);
+            const __m128 maxValue = _mm_set1_ps(65535.f);
+            for (; i + 4 <= pairCount; i += 4)
+            {
+                // 4 pairs per iteration, each 64 bit lane holds x in its low and y in its high int
+                __m128 first = _mm_mul_ps(_mm_loadu_ps(src + i * 2), scale);
+                __m128 second = _mm_mul_ps(_mm_loadu_ps(src + i * 2 + 4), scale);
+                first = _mm_min_ps(_mm_max_ps(first, zero), one); // max first so NaN becomes 0
+                second = _mm_min_ps(_mm_max_ps(second, zero), one);
+                __m128i firstInt = _mm_cvtps_epi32(_mm_mul_ps(first, maxValue));
+                __m128i secondInt = _mm_cvtps_epi32(_mm_mul_ps(second, maxValue));
+
+                // move y next to x in the low int of every lane, then gather the low ints
+                firstInt = _mm_or_si128(firstInt, _mm_srli_epi64(firstInt, 16));
+                secondInt = _mm_or_si128(secondInt, _mm_srli_epi64(secondInt, 16));
+                firstInt = _mm_shuffle_epi32(firstInt, _MM_SHUFFLE(3, 1, 2, 0));
+                secondInt = _mm_shuffle_epi32(secondInt, _MM_SHUFFLE(3, 1, 2, 0));
+                _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), _mm_unpacklo_epi64(firstInt, secondInt));
+            }
+#endif
+            for (; i < pairCount; i++)
+                dst[i] = packUnorm16(src[i * 2] * scaleX) | (packUnorm16(src[i * 2 + 1] * scaleY) << 16);
+        }
+
+#ifdef LVE_PACK_X86
+        __attribute__((target("f16c"))) static size_t packHalf2x16F16C(const float *src, size_t pairCount, uint32_t *dst)
+        {
+            size_t i = 0;
+            for (; i + 2 <= pairCount; i += 2)
+            {
+                __m128i halves = _mm_cvtps_ph(_mm_loadu_ps(src + i * 2), _MM_FROUND_TO_NEAREST_INT);
+                _mm_storel_epi64(reinterpret_cast<__m128i *>(dst + i), halves);
+            }
+            return i;
+        }
+#endif
+
+        bool hasSimdHalfConversion()
+        {
+#ifdef LVE_PACK_X86
+            static const bool supported = []()
+            {
+                unsigned int eax, ebx, ecx, edx;
+                if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx))
+                    return false;
+                if (!(ecx & bit_F16C) || !(ecx & bit_AVX) || !(ecx & bit_OSXSAVE))
+                    return false;
+                // VEX encoded instructions also need the OS to save the SSE and AVX state
+                uint32_t xcr0Low, xcr0High;
+                __asm__("xgetbv" : "=a"(xcr0Low), "=d"(xcr0High) : "c"(0));
+                return (xcr0Low & 0x6) == 0x6;
+            }();
+            return supported;
+#else
+            return false;
+#endif
+        }
+
+        void packHalf2x16(const float *src, size_t pairCount, uint32_t *dst)
+        {
+            size_t i = 0;
+#ifdef LVE_PACK_X86
+            if (hasSimdHalfConversion())
+                i = packHalf2x16F16C(src, pairCount, dst);
+#endif
+            for (; i < pairCount; i++)
+                dst[i] = floatToHalf(src[i * 2]) | (static_cast<uint32_t>(floatToHalf(src[i * 2 + 1])) << 16);
+        }
+    } // namespace pack
+} // namespace lve
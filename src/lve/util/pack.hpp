@@ -0,0 +1,29 @@
+#pragma once
+
+// std
+#include <cstddef>
+#include <cstdint>
+
+namespace lve
+{
+    /*
+     * Packing of float pairs into 32 bit words, bit compatible with GLSL unpackUnorm2x16 and
+     * unpackHalf2x16 (x in the low 16 bits). The batch routines use SSE2 / F16C when the CPU has
+     * them and fall back to the scalar conversions otherwise, results are identical either way.
+     */
+    namespace pack
+    {
+        uint16_t floatToHalf(float value); // round to nearest even, like F16C
+        float halfToFloat(uint16_t half);
+
+        /*
+         * @param src: interleaved x, y pairs
+         * @param pairCount: number of pairs in src and words in dst
+         * @param scaleX, scaleY: applied before clamping to [0, 1], e.g. 1 / range
+         */
+        void packUnorm2x16(const float *src, size_t pairCount, float scaleX, float scaleY, uint32_t *dst);
+        void packHalf2x16(const float *src, size_t pairCount, uint32_t *dst);
+
+        bool hasSimdHalfConversion(); // F16C available at runtime
+    } // namespace pack
+} // namespace lve
@@ -0,0 +1,174 @@
+#include "lve/util/stats.hpp"
+#include "lve/util/file_io.hpp"
+
+// std
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+namespace lve
+{
+    namespace stats
+    {
+        History::History(size_t capacity) : values(std::max<size_t>(capacity, 1), 0.0) {}
+
+        void History::push(double value)
+        {
+            values[head] = value;
+            head = (head + 1) % values.size();
+            count = std::min(count + 1, values.size());
+        }
+
+        void History::clear()
+        {
+            head = 0;
+            count = 0;
+        }
+
+        double History::last() const
+        {
+            if (count == 0)
+                return 0.0;
+            return values[(head + values.size() - 1) % values.size()];
+        }
+
+        double History::average() const
+        {
+            if (count == 0)
+                return 0.0;
+            double sum = 0.0;
+            for (double value : ordered())
+                sum += value;
+            return sum / count;
+        }
+
+        double History::max() const
+        {
+            std::vector<double> orderedValues = ordered();
+            if (orderedValues.empty())
+                return 0.0;
+            return *std::max_element(orderedValues.begin(), orderedValues.end());
+        }
+
+        std::vector<double> History::ordered() const
+        {
+            std::vector<double> result;
+            result.reserve(count);
+            size_t start = (head + values.size() - count) % values.size();
+            for (size_t i = 0; i < count; i++)
+                result.push_back(values[(start + i) % values.size()]);
+            return result;
+        }
+
+        std::mutex StatsRecorder::mutex;
+        size_t StatsRecorder::historyCapacity = 256;
+        std::unordered_map<std::string, History> StatsRecorder::histories;
+        std::vector<std::string> StatsRecorder::names;
+
+        void StatsRecorder::record(const std::string &name, double value)
+        {
+            std::lock_guard<std::mutex> lock{mutex};
+            auto it = histories.find(name);
+            if (it == histories.end())
+            {
+                it = histories.emplace(name, History{historyCapacity}).first;
+                names.push_back(name);
+            }
+            it->second.push(value);
+        }
+
+        /*
+         * Set the number of samples kept per metric, existing histories are reset
+         * @param capacity: number of samples kept per metric
+         */
+        void StatsRecorder::setHistoryCapacity(size_t capacity)
+        {
+            std::lock_guard<std::mutex> lock{mutex};
+            historyCapacity = capacity;
+            for (auto &entry : histories)
+                entry.second = History{capacity};
+        }
+
+        void StatsRecorder::clear()
+        {
+            std::lock_guard<std::mutex> lock{mutex};
+            histories.clear();
+            names.clear();
+        }
+
+        std::vector<std::string> StatsRecorder::getNames()
+        {
+            std::lock_guard<std::mutex> lock{mutex};
+            return names;
+        }
+
+        bool StatsRecorder::getSummary(const std::string &name, Summary &summary)
+        {
+            std::lock_guard<std::mutex> lock{mutex};
+            auto it = histories.find(name);
+            if (it == histories.end())
+                return false;
+            summary = {it->second.size(), it->second.last(), it->second.average(), it->second.max()};
+            return true;
+        }
+
+        std::vector<double> StatsRecorder::getHistory(const std::string &name)
+        {
+            std::lock_guard<std::mutex> lock{mutex};
+            auto it = histories.find(name);
+            if (it == histories.end())
+                return {};
+            return it->second.ordered();
+        }
+
+        std::string StatsRecorder::toJson()
+        {
+            std::lock_guard<std::mutex> lock{mutex};
+            std::ostringstream json;
+            json << std::setprecision(6) << "{\n";
+            for (size_t i = 0; i < names.size(); i++)
+            {
+                const History &history = histories.at(names[i]);
+                json << "  \"" << names[i] << "\": {"
+                     << "\"count\": " << history.size()
+                     << ", \"last\": " << history.last()
+                     << ", \"average\": " << history.average()
+                     << ", \"max\": " << history.max()
+                     << ", \"history\": [";
+                std::vector<double> values = history.ordered();
+                for (size_t j = 0; j < values.size(); j++)
+                    json << (j == 0 ? "" : ", ") << values[j];
+                json << "]}" << (i + 1 < names.size() ? "," : "") << "\n";
+            }
+            json << "}\n";
+            return json.str();
+        }
+
+        void StatsRecorder::dumpJson(const std::string &filepath)
+        {
+            io::writeFile(filepath, toJson());
+        }
+
+        void StatsRecorder::printSummary()
+        {
+            std::lock_guard<std::mutex> lock{mutex};
+            std::cout << std::fixed << std::setprecision(3);
+            for (const std::string &name : names)
+            {
+                const History &history = histories.at(name);
+                std::cout << "  " << std::left << std::setw(32) << name << std::right
+                          << " last " << std::setw(10) << history.last()
+                          << " avg " << std::setw(10) << history.average()
+                          << " max " << std::setw(10) << history.max() << std::endl;
+            }
+            std::cout << std::defaultfloat;
+        }
+
+        ScopedTimer::~ScopedTimer()
+        {
+            auto duration = std::chrono::steady_clock::now() - startTime;
+            StatsRecorder::record(name, std::chrono::duration<double, std::milli>(duration).count());
+        }
+    } // namespace stats
+} // namespace lve
@@ -0,0 +1,103 @@
+#pragma once
+
+// std
+#include <chrono>
+#include <cstddef>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/*
+ * Runtime statistics, enabled with the LVE_ENABLE_STATS compile definition (CMake option of the
+ * same name). Instrumentation should go through the macros at the bottom of this file so that it
+ * compiles to nothing when stats are disabled.
+ */
+
+namespace lve
+{
+    namespace stats
+    {
+        // Fixed capacity history of one metric, oldest values are overwritten first
+        class History
+        {
+        public:
+            History(size_t capacity = 256);
+
+            void push(double value);
+            void clear();
+
+            size_t size() const { return count; }
+            size_t capacity() const { return values.size(); }
+            double last() const;
+            double average() const;
+            double max() const;
+            std::vector<double> ordered() const; // oldest first
+
+        private:
+            std::vector<double> values;
+            size_t head = 0; // next slot to write
+            size_t count = 0;
+        };
+
+        struct Summary
+        {
+            size_t sampleCount;
+            double last;
+            double average;
+            double max;
+        };
+
+        class StatsRecorder // Static class holding one history per metric name
+        {
+        public:
+            static void record(const std::string &name, double value);
+            static void setHistoryCapacity(size_t capacity);
+            static void clear();
+
+            static std::vector<std::string> getNames();
+            static bool getSummary(const std::string &name, Summary &summary);
+            static std::vector<double> getHistory(const std::string &name);
+
+            static std::string toJson();
+            static void dumpJson(const std::string &filepath);
+            static void printSummary();
+
+        private:
+            StatsRecorder() = delete;
+
+            static std::mutex mutex;
+            static size_t historyCapacity;
+            static std::unordered_map<std::string, History> histories;
+            static std::vector<std::string> names; // insertion order, keeps the dump stable
+        };
+
+        // Records the lifetime of the object in milliseconds under the given name
+        class ScopedTimer
+        {
+        public:
+            ScopedTimer(const char *name) : name{name}, startTime{std::chrono::steady_clock::now()} {}
+            ~ScopedTimer();
+
+            ScopedTimer(const ScopedTimer &) = delete;
+            ScopedTimer &operator=(const ScopedTimer &) = delete;
+
+        private:
+            const char *name;
+            std::chrono::steady_clock::time_point startTime;
+        };
+    } // namespace stats
+} // namespace lve
+
+#define LVE_STATS_CONCAT_IMPL(a, b) a##b
+#define LVE_STATS_CONCAT(a, b) LVE_STATS_CONCAT_IMPL(a, b)
+
+#ifdef LVE_ENABLE_STATS
+#define LVE_STATS_SCOPE(name) lve::stats::ScopedTimer LVE_STATS_CONCAT(lveStatsTimer_, __LINE__)(name)
+#define LVE_STATS_RECORD(name, value) lve::stats::StatsRecorder::record(name, static_cast<double>(value))
+#define LVE_STATS_ONLY(statement) statement
+#else
+#define LVE_STATS_SCOPE(name)
+#define LVE_STATS_RECORD(name, value)
+#define LVE_STATS_ONLY(statement)
+#endif
@@ -0,0 +1,53 @@
+#include "lve/util/thread_pool.hpp"
+#include "lve/util/trace.hpp"
+
+// std
+#include <algorithm>
+#include <string>
+
+namespace lve
+{
+    ThreadPool::ThreadPool(size_t threadCount)
+    {
+        if (threadCount == 0)
+        {
+            unsigned int hardwareThreads = std::thread::hardware_concurrency();
+            threadCount = std::max(hardwareThreads, 2u) - 1;
+        }
+
+        workers.reserve(threadCount);
+        for (size_t i = 0; i < threadCount; i++)
+            workers.emplace_back(&ThreadPool::workerLoop, this, i);
+    }
+
+    ThreadPool::~ThreadPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock{queueMutex};
+            isStopping = true;
+        }
+        queueCondVar.notify_all();
+
+        // queued tasks are still run so no future is left without a value
+        for (std::thread &worker : workers)
+            worker.join();
+    }
+
+    void ThreadPool::workerLoop(size_t workerIndex)
+    {
+        LVE_TRACE_THREAD_NAME("worker " + std::to_string(workerIndex));
+        while (true)
+        {
+            std::function<void()> task;
+            {
+                std::unique_lock<std::mutex> lock{queueMutex};
+                queueCondVar.wait(lock, [this] { return isStopping || !tasks.empty(); });
+                if (tasks.empty())
+                    return; // stopping and drained
+                task = std::move(tasks.front());
+                tasks.pop();
+            }
+            task();
+        }
+    }
+} // namespace lve
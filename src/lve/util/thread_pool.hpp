@@ -0,0 +1,44 @@
+#pragma once
+
+// std
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+namespace lve
+{
+    /*
+     * Fixed set of worker threads consuming a FIFO task queue
+     * Tasks are submitted as callables and their result (or exception) is returned as a future.
+     */
+    class ThreadPool
+    {
+    public:
+        // 0 picks one worker per hardware thread, minus the calling thread
+        ThreadPool(size_t threadCount = 0);
+        ~ThreadPool();
+
+        ThreadPool(const ThreadPool &) = delete;
+        ThreadPool &operator=(const ThreadPool &) = delete;
+
+        template <typename Task>
+        auto submit(Task &&task) -> std::future<decltype(task())>;
+
+        size_t getThreadCount() const { return workers.size(); }
+
+    private:
+        std::vector<std::thread> workers;
+        std::queue<std::function<void()>> tasks;
+        std::mutex queueMutex;
+        std::condition_variable queueCondVar;
+        bool isStopping = false;
+
+        void workerLoop(size_t workerIndex);
+    };
+} // namespace lve
+
+#include "lve/util/thread_pool.tpp"
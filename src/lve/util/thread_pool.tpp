@@ -0,0 +1,28 @@
+#pragma once
+
+#include "lve/util/thread_pool.hpp"
+
+// std
+#include <memory>
+#include <stdexcept>
+
+namespace lve
+{
+    template <typename Task>
+    auto ThreadPool::submit(Task &&task) -> std::future<decltype(task())>
+    {
+        using Result = decltype(task());
+
+        // std::function needs a copyable callable, so the packaged task is shared
+        auto packagedTask = std::make_shared<std::packaged_task<Result()>>(std::forward<Task>(task));
+        std::future<Result> future = packagedTask->get_future();
+        {
+            std::lock_guard<std::mutex> lock{queueMutex};
+            if (isStopping)
+                throw std::runtime_error("Cannot submit tasks to a stopping ThreadPool");
+            tasks.emplace([packagedTask]() { (*packagedTask)(); });
+        }
+        queueCondVar.notify_one();
+        return future;
+    }
+} // namespace lve
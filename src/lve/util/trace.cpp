@@ -0,0 +1,206 @@
+#include "lve/util/trace.hpp"
+#include "lve/util/file_io.hpp"
+
+// std
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <vector>
+
+namespace lve
+{
+    namespace trace
+    {
+        namespace
+        {
+            struct Event
+            {
+                const char *name;
+                int64_t timestampNs;
+                char phase; // 'B' or 'E'
+            };
+
+            // Only the owning thread writes, "count" is published with release so a flushing
+            // thread can read every event below it without locking
+            struct Chunk
+            {
+                static constexpr size_t CAPACITY = 4096;
+                Event events[CAPACITY];
+                std::atomic<size_t> count{0};
+                std::atomic<Chunk *> next{nullptr};
+
+                ~Chunk() { delete next.load(); }
+            };
+
+            struct ThreadBuffer
+            {
+                uint32_t threadId;
+                std::string threadName; // guarded by registryMutex
+                uint64_t session;       // of the recorded events, written by the owning thread under registryMutex
+                std::unique_ptr<Chunk> head;
+                Chunk *tail; // only used by the owning thread
+            };
+
+            std::atomic<bool> recording{false};
+            // incremented by start(), a buffer of an earlier session is reset by its thread before its next event
+            std::atomic<uint64_t> currentSession{0};
+            const auto epoch = std::chrono::steady_clock::now();
+
+            int64_t nowNs()
+            {
+                return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - epoch)
+                    .count();
+            }
+
+            // buffers are never freed so a flush can read buffers of exited threads
+            std::mutex registryMutex;
+            std::vector<std::unique_ptr<ThreadBuffer>> registry;
+
+            ThreadBuffer &getThreadBuffer()
+            {
+                thread_local ThreadBuffer *threadBuffer = nullptr;
+                if (threadBuffer == nullptr)
+                {
+                    auto buffer = std::make_unique<ThreadBuffer>();
+                    buffer->head = std::make_unique<Chunk>();
+                    buffer->tail = buffer->head.get();
+
+                    std::lock_guard<std::mutex> lock{registryMutex};
+                    buffer->threadId = static_cast<uint32_t>(registry.size());
+                    buffer->threadName = "thread " + std::to_string(buffer->threadId);
+                    buffer->session = currentSession.load(std::memory_order_relaxed);
+                    threadBuffer = buffer.get();
+                    registry.push_back(std::move(buffer));
+                }
+                return *threadBuffer;
+            }
+
+            // drops the events of an earlier session, under the lock so no flush is walking the chunks
+            void resetThreadBuffer(ThreadBuffer &buffer)
+            {
+                std::lock_guard<std::mutex> lock{registryMutex};
+                delete buffer.head->next.exchange(nullptr);
+                buffer.head->count.store(0, std::memory_order_relaxed);
+                buffer.tail = buffer.head.get();
+                buffer.session = currentSession.load(std::memory_order_relaxed);
+            }
+
+            void pushEvent(const char *name, char phase)
+            {
+                int64_t timestamp = nowNs();
+
+                ThreadBuffer &buffer = getThreadBuffer();
+                if (buffer.session != currentSession.load(std::memory_order_relaxed))
+                    resetThreadBuffer(buffer);
+
+                Chunk *chunk = buffer.tail;
+                size_t index = chunk->count.load(std::memory_order_relaxed);
+                if (index == Chunk::CAPACITY)
+                {
+                    Chunk *newChunk = new Chunk();
+                    chunk->next.store(newChunk, std::memory_order_release);
+                    buffer.tail = newChunk;
+                    chunk = newChunk;
+                    index = 0;
+                }
+                chunk->events[index] = {name, timestamp, phase};
+                chunk->count.store(index + 1, std::memory_order_release);
+            }
+
+            void writeEscaped(std::ostringstream &json, const char *text)
+            {
+                for (const char *c = text; *c != '\0'; c++)
+                {
+                    if (*c == '"' || *c == '\\')
+                        json << '\\';
+                    json << *c;
+                }
+            }
+        } // namespace
+
+        void start()
+        {
+            currentSession.fetch_add(1, std::memory_order_relaxed);
+            recording.store(true, std::memory_order_relaxed);
+        }
+        void stop() { recording.store(false, std::memory_order_relaxed); }
+        bool isRecording() { return recording.load(std::memory_order_relaxed); }
+
+        void setThreadName(const std::string &name)
+        {
+            ThreadBuffer &buffer = getThreadBuffer();
+            std::lock_guard<std::mutex> lock{registryMutex};
+            buffer.threadName = name;
+        }
+
+        void beginZone(const char *name) { pushEvent(name, 'B'); }
+        void endZone(const char *name) { pushEvent(name, 'E'); }
+
+        void flushToFile(const std::string &filepath)
+        {
+            std::ostringstream json;
+            json << "{\"traceEvents\": [\n";
+            bool isFirst = true;
+            auto separator = [&]() -> const char *
+            {
+                const char *result = isFirst ? "" : ",\n";
+                isFirst = false;
+                return result;
+            };
+            auto writeEvent = [&](const Event &event, uint32_t threadId)
+            {
+                json << separator() << "{\"name\": \"";
+                writeEscaped(json, event.name);
+                json << "\", \"ph\": \"" << event.phase << "\", \"pid\": 0, \"tid\": " << threadId
+                     << ", \"ts\": " << event.timestampNs / 1000 << "." << event.timestampNs / 100 % 10 << "}";
+            };
+
+            {
+                std::lock_guard<std::mutex> lock{registryMutex};
+                uint64_t session = currentSession.load(std::memory_order_relaxed);
+                int64_t flushTimestamp = nowNs();
+                for (const auto &buffer : registry)
+                {
+                    json << separator() << "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 0, \"tid\": "
+                         << buffer->threadId << ", \"args\": {\"name\": \"";
+                    writeEscaped(json, buffer->threadName.c_str());
+                    json << "\"}}";
+
+                    // events of an earlier session wait for their thread to reset them
+                    if (buffer->session != session)
+                        continue;
+
+                    // an end without begin belongs to a zone begun before start(), it is dropped
+                    std::vector<const char *> openZones;
+                    for (Chunk *chunk = buffer->head.get(); chunk != nullptr;
+                         chunk = chunk->next.load(std::memory_order_acquire))
+                    {
+                        size_t count = chunk->count.load(std::memory_order_acquire);
+                        for (size_t i = 0; i < count; i++)
+                        {
+                            const Event &event = chunk->events[i];
+                            if (event.phase == 'B')
+                                openZones.push_back(event.name);
+                            else if (openZones.empty())
+                                continue;
+                            else
+                                openZones.pop_back();
+                            writeEvent(event, buffer->threadId);
+                        }
+                    }
+
+                    // zones still open, e.g. after stop(), are closed at the flush
+                    while (!openZones.empty())
+                    {
+                        writeEvent({openZones.back(), flushTimestamp, 'E'}, buffer->threadId);
+                        openZones.pop_back();
+                    }
+                }
+            }
+
+            json << "\n]}\n";
+            io::writeFile(filepath, json.str());
+        }
+    } // namespace trace
+} // namespace lve
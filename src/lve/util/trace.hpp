@@ -0,0 +1,70 @@
+#pragma once
+
+// std
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/*
+ * Timeline tracing, exported in the Chrome trace event format (chrome://tracing, ui.perfetto.dev)
+ * Every thread appends begin/end events to its own chunked buffer without locking, a flush walks
+ * all buffers and writes the events recorded so far. Recording is off until start() is called,
+ * and the macros at the bottom of this file compile to nothing without LVE_ENABLE_TRACE.
+ * Every start() begins a new session whose flushes only contain its own events, the buffers of
+ * earlier sessions are reused. Zones still open at a flush are closed at the time of the flush.
+ * Zone names must outlive the trace, string literals are expected.
+ */
+
+namespace lve
+{
+    namespace trace
+    {
+        void start();
+        void stop();
+        bool isRecording();
+
+        // name shown for the calling thread in the timeline
+        void setThreadName(const std::string &name);
+
+        void beginZone(const char *name);
+        void endZone(const char *name);
+
+        // write the events recorded since the last start() to a Chrome trace JSON file
+        void flushToFile(const std::string &filepath);
+
+        // Records a zone covering the lifetime of the object
+        class Zone
+        {
+        public:
+            Zone(const char *name) : name{name}, isActive{isRecording()}
+            {
+                if (isActive)
+                    beginZone(name);
+            }
+            ~Zone()
+            {
+                if (isActive)
+                    endZone(name);
+            }
+
+            Zone(const Zone &) = delete;
+            Zone &operator=(const Zone &) = delete;
+
+        private:
+            const char *name;
+            bool isActive; // a zone started before stop() still gets its end event
+        };
+    } // namespace trace
+} // namespace lve
+
+#define LVE_TRACE_CONCAT_IMPL(a, b) a##b
+#define LVE_TRACE_CONCAT(a, b) LVE_TRACE_CONCAT_IMPL(a, b)
+
+#ifdef LVE_ENABLE_TRACE
+#define LVE_TRACE_ZONE(name) lve::trace::Zone LVE_TRACE_CONCAT(lveTraceZone_, __LINE__)(name)
+#define LVE_TRACE_THREAD_NAME(name) lve::trace::setThreadName(name)
+#else
+#define LVE_TRACE_ZONE(name)
+#define LVE_TRACE_THREAD_NAME(name)
+#endif
@@ -1,4 +1,6 @@
 #include "app/fluid_sim/2d/app.hpp"
+#include "app/fluid_sim/2d/headless_app.hpp"
+#include "app/fluid_sim/3d/app.hpp"
 #include "app/renderer/app.hpp"
 #include "lve/util/file_io.hpp"
 
@@ -12,6 +14,8 @@ int main()
     try
     {
         FluidSim2DApp app{};
+        // FluidSim2DHeadlessApp app{};
+        // FluidSim3DApp app{};
         // RendererApp app{};
 
         app.run();
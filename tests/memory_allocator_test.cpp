@@ -0,0 +1,205 @@
+#include "lve/core/resource/memory_allocator.hpp"
+#include "mock_memory_backend.hpp"
+
+// std
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+using lve::MemoryAllocation;
+using lve::MemoryAllocator;
+using lve::MemoryAllocatorStats;
+using lve::MemoryResourceKind;
+using lve::MockMemoryBackend;
+
+namespace
+{
+    int failureCount = 0;
+
+    void check(bool condition, const std::string &message)
+    {
+        if (!condition)
+        {
+            std::cerr << "FAILED: " << message << std::endl;
+            failureCount++;
+        }
+    }
+
+    constexpr uint32_t DEVICE_LOCAL = 0;
+    constexpr uint32_t HOST_NON_COHERENT = 1; // host visible with a 64 byte atom
+    constexpr uint64_t BLOCK_SIZE = 1024;
+
+    MockMemoryBackend createBackend(uint64_t maxBlockSize = UINT64_MAX)
+    {
+        return MockMemoryBackend{{{1, false}, {64, true}}, maxBlockSize};
+    }
+
+    void testAlignment()
+    {
+        MockMemoryBackend backend = createBackend();
+        MemoryAllocator allocator{backend, 1, BLOCK_SIZE};
+
+        MemoryAllocation first = allocator.allocate(DEVICE_LOCAL, 100, 1, MemoryResourceKind::LINEAR);
+        MemoryAllocation aligned = allocator.allocate(DEVICE_LOCAL, 64, 256, MemoryResourceKind::LINEAR);
+        check(first.offset == 0, "first allocation starts the block");
+        check(aligned.offset % 256 == 0, "offset is aligned to the requested alignment");
+        check(aligned.offset >= first.offset + first.size, "aligned allocation does not overlap");
+        check(aligned.memory == first.memory, "small allocations share a block");
+
+        // the type's minimum alignment applies to the offset and rounds the size
+        MemoryAllocation hostFirst = allocator.allocate(HOST_NON_COHERENT, 10, 4, MemoryResourceKind::LINEAR);
+        MemoryAllocation hostSecond = allocator.allocate(HOST_NON_COHERENT, 10, 4, MemoryResourceKind::LINEAR);
+        check(hostFirst.size == 64, "size is rounded to the minimum alignment");
+        check(hostSecond.offset % 64 == 0 && hostSecond.offset >= 64, "offset respects the minimum alignment");
+        check(hostSecond.mapped == static_cast<char *>(hostFirst.mapped) + (hostSecond.offset - hostFirst.offset),
+              "mapped pointer points at the offset inside the block");
+        check(first.mapped == nullptr, "device local allocations are not mapped");
+
+        try
+        {
+            allocator.allocate(DEVICE_LOCAL, 16, 3, MemoryResourceKind::LINEAR);
+            check(false, "alignment that is not a power of two throws");
+        }
+        catch (const std::runtime_error &)
+        {
+        }
+    }
+
+    void testGranularityPools()
+    {
+        {
+            MockMemoryBackend backend = createBackend();
+            MemoryAllocator allocator{backend, 1024, BLOCK_SIZE};
+            MemoryAllocation buffer = allocator.allocate(DEVICE_LOCAL, 64, 1, MemoryResourceKind::LINEAR);
+            MemoryAllocation image = allocator.allocate(DEVICE_LOCAL, 64, 1, MemoryResourceKind::OPTIMAL);
+            check(buffer.memory != image.memory, "linear and optimal resources get separate blocks with granularity > 1");
+            check(allocator.getStats().blockCount == 2, "one block per pool");
+        }
+        {
+            MockMemoryBackend backend = createBackend();
+            MemoryAllocator allocator{backend, 1, BLOCK_SIZE};
+            MemoryAllocation buffer = allocator.allocate(DEVICE_LOCAL, 64, 1, MemoryResourceKind::LINEAR);
+            MemoryAllocation image = allocator.allocate(DEVICE_LOCAL, 64, 1, MemoryResourceKind::OPTIMAL);
+            check(buffer.memory == image.memory, "linear and optimal resources share a block with granularity 1");
+        }
+    }
+
+    void testFreeMergesNeighbors()
+    {
+        MockMemoryBackend backend = createBackend();
+        MemoryAllocator allocator{backend, 1, BLOCK_SIZE};
+
+        MemoryAllocation a = allocator.allocate(DEVICE_LOCAL, 256, 1, MemoryResourceKind::LINEAR);
+        MemoryAllocation b = allocator.allocate(DEVICE_LOCAL, 256, 1, MemoryResourceKind::LINEAR);
+        MemoryAllocation c = allocator.allocate(DEVICE_LOCAL, 256, 1, MemoryResourceKind::LINEAR);
+        MemoryAllocation d = allocator.allocate(DEVICE_LOCAL, 256, 1, MemoryResourceKind::LINEAR);
+        check(allocator.getStats().largestFreeRange == 0, "four quarters fill the block");
+
+        allocator.free(a);
+        allocator.free(c);
+        check(!a.isValid(), "free resets the allocation");
+        check(allocator.getStats().largestFreeRange == 256, "separated ranges are not merged");
+
+        allocator.free(b);
+        check(allocator.getStats().largestFreeRange == 768, "freed range merges with both neighbors");
+
+        MemoryAllocation large = allocator.allocate(DEVICE_LOCAL, 512, 1, MemoryResourceKind::LINEAR);
+        check(large.memory == d.memory && large.offset == 0, "merged range is reused");
+        check(allocator.getStats().blockCount == 1, "no new block for the merged range");
+    }
+
+    void testDedicatedAllocations()
+    {
+        MockMemoryBackend backend = createBackend();
+        MemoryAllocator allocator{backend, 1, BLOCK_SIZE};
+
+        MemoryAllocation small = allocator.allocate(DEVICE_LOCAL, 64, 1, MemoryResourceKind::LINEAR);
+        MemoryAllocation large = allocator.allocate(DEVICE_LOCAL, BLOCK_SIZE / 2 + 1, 1, MemoryResourceKind::LINEAR);
+        check(large.memory != small.memory, "allocation above half a block gets its own block");
+        check(large.offset == 0, "dedicated allocation starts its block");
+        check(backend.getBlockSize(large.memory) == BLOCK_SIZE / 2 + 1, "dedicated block has the allocation's size");
+        check(allocator.getStats().dedicatedBlockCount == 1, "dedicated block is counted");
+
+        allocator.free(large);
+        check(backend.getLiveBlockCount() == 1, "dedicated block is released on free");
+        check(allocator.getStats().dedicatedBlockCount == 0, "no dedicated block left");
+
+        // the last empty pooled block is kept, a second one is released
+        MemoryAllocation filler = allocator.allocate(DEVICE_LOCAL, BLOCK_SIZE / 2, 1, MemoryResourceKind::LINEAR);
+        MemoryAllocation overflow = allocator.allocate(DEVICE_LOCAL, BLOCK_SIZE / 2, 1, MemoryResourceKind::LINEAR);
+        check(overflow.memory != small.memory, "full block spills into a new block");
+        allocator.free(small);
+        allocator.free(filler);
+        allocator.free(overflow);
+        check(backend.getLiveBlockCount() == 1, "a single empty block is kept per pool");
+    }
+
+    void testOutOfMemoryHalving()
+    {
+        MockMemoryBackend backend = createBackend(BLOCK_SIZE / 4);
+        MemoryAllocator allocator{backend, 1, BLOCK_SIZE};
+
+        MemoryAllocation allocation = allocator.allocate(DEVICE_LOCAL, 100, 1, MemoryResourceKind::LINEAR);
+        check(allocation.isValid(), "allocation succeeds with a smaller block");
+        const std::vector<uint64_t> expectedSizes{BLOCK_SIZE, BLOCK_SIZE / 2, BLOCK_SIZE / 4};
+        check(backend.getRequestedSizes() == expectedSizes, "block size is halved after each failure");
+        check(allocator.getStats().reservedBytes == BLOCK_SIZE / 4, "the smaller block is used");
+        check(allocator.getStats().backendAllocationCount == 1, "failed attempts are not counted");
+
+        // halving stops at the allocation's size
+        try
+        {
+            allocator.allocate(DEVICE_LOCAL, 300, 1, MemoryResourceKind::LINEAR);
+            check(false, "allocation larger than any possible block throws");
+        }
+        catch (const std::runtime_error &)
+        {
+        }
+        check(backend.getRequestedSizes().back() == 300, "last attempt has the allocation's size");
+    }
+
+    void testStats()
+    {
+        MockMemoryBackend backend = createBackend();
+        {
+            MemoryAllocator allocator{backend, 1, BLOCK_SIZE};
+            MemoryAllocation a = allocator.allocate(DEVICE_LOCAL, 100, 1, MemoryResourceKind::LINEAR);
+            MemoryAllocation b = allocator.allocate(DEVICE_LOCAL, 200, 1, MemoryResourceKind::LINEAR);
+            MemoryAllocation c = allocator.allocate(HOST_NON_COHERENT, 100, 1, MemoryResourceKind::LINEAR);
+
+            MemoryAllocatorStats stats = allocator.getStats();
+            check(stats.blockCount == 2, "one block per memory type");
+            check(stats.allocationCount == 3, "allocation count");
+            check(stats.usedBytes == 100 + 200 + 128, "used bytes include the rounded size");
+            check(stats.reservedBytes == 2 * BLOCK_SIZE, "reserved bytes are the block sizes");
+            check(stats.largestFreeRange == BLOCK_SIZE - 128, "largest free range over all blocks");
+            check(stats.backendAllocationCount == 2, "backend allocations");
+
+            allocator.free(a);
+            allocator.free(b);
+            allocator.free(c);
+            stats = allocator.getStats();
+            check(stats.allocationCount == 0 && stats.usedBytes == 0, "nothing used after freeing everything");
+            check(stats.blockCount == 2, "empty blocks are kept");
+        }
+        check(backend.getLiveBlockCount() == 0, "destructor releases every block");
+    }
+} // namespace
+
+int main()
+{
+    testAlignment();
+    testGranularityPools();
+    testFreeMergesNeighbors();
+    testDedicatedAllocations();
+    testOutOfMemoryHalving();
+    testStats();
+
+    if (failureCount > 0)
+    {
+        std::cerr << failureCount << " checks failed" << std::endl;
+        return 1;
+    }
+    std::cout << "memory allocator tests passed" << std::endl;
+    return 0;
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include "lve/core/resource/memory_allocator.hpp"
+
+// std
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+namespace lve
+{
+    /*
+     * MemoryBackend handing out fake block handles, for running MemoryAllocator on the CPU
+     * Host visible types get a real host buffer as their mapping, so mapped pointers can be checked.
+     * Blocks larger than maxBlockSize fail like a driver out of memory.
+     */
+    class MockMemoryBackend : public MemoryBackend
+    {
+    public:
+        struct MemoryType
+        {
+            uint64_t minAlignment = 1;
+            bool isHostVisible = false;
+        };
+
+        MockMemoryBackend(std::vector<MemoryType> memoryTypes, uint64_t maxBlockSize = UINT64_MAX)
+            : memoryTypes{memoryTypes}, maxBlockSize{maxBlockSize}
+        {
+        }
+
+        bool allocateBlock(uint32_t memoryTypeIndex, uint64_t size, MemoryBlockInfo &block) override
+        {
+            requestedSizes.push_back(size);
+            if (size > maxBlockSize)
+                return false;
+
+            block.handle = nextHandle++;
+            block.mapped = nullptr;
+            if (getMemoryType(memoryTypeIndex).isHostVisible)
+            {
+                auto storage = std::make_unique<char[]>(size);
+                block.mapped = storage.get();
+                mappedStorage[block.handle] = std::move(storage);
+            }
+            liveBlocks[block.handle] = size;
+            return true;
+        }
+
+        void freeBlock(const MemoryBlockInfo &block) override
+        {
+            if (liveBlocks.erase(block.handle) == 0)
+                throw std::runtime_error("MockMemoryBackend: freed an unknown or already freed block");
+            mappedStorage.erase(block.handle);
+        }
+
+        uint64_t getMinAlignment(uint32_t memoryTypeIndex) const override
+        {
+            return getMemoryType(memoryTypeIndex).minAlignment;
+        }
+
+        size_t getLiveBlockCount() const { return liveBlocks.size(); }
+        uint64_t getBlockSize(uint64_t handle) const { return liveBlocks.at(handle); }
+        const std::vector<uint64_t> &getRequestedSizes() const { return requestedSizes; } // every allocateBlock call
+
+    private:
+        const MemoryType &getMemoryType(uint32_t memoryTypeIndex) const
+        {
+            if (memoryTypeIndex >= memoryTypes.size())
+                throw std::runtime_error("MockMemoryBackend: memory type index out of range");
+            return memoryTypes[memoryTypeIndex];
+        }
+
+        std::vector<MemoryType> memoryTypes;
+        uint64_t maxBlockSize;
+        uint64_t nextHandle = 1; // 0 marks an invalid allocation
+        std::map<uint64_t, uint64_t> liveBlocks; // handle -> size
+        std::map<uint64_t, std::unique_ptr<char[]>> mappedStorage;
+        std::vector<uint64_t> requestedSizes;
+    };
+} // namespace lve